@@ -0,0 +1,219 @@
+/*
+ * Copyright Mellanox Technologies, Ltd. 2001-2016.
+ * This software product is licensed under Apache version 2, as detailed in
+ * the COPYING file.
+ */
+
+#ifndef SAI_ACL_H
+#define SAI_ACL_H 1
+
+#include <netinet/in.h>
+#include <packets.h>
+
+#include <sai-common.h>
+#ifdef SAI_VENDOR
+#include <sai-vendor-common.h>
+#endif /* SAI_VENDOR */
+
+/* Match fields of ACL rule. */
+enum ops_sai_acl_field {
+    OPS_SAI_ACL_FIELD_IN_PORT    = 1 << 0,
+    OPS_SAI_ACL_FIELD_SRC_MAC    = 1 << 1,
+    OPS_SAI_ACL_FIELD_DST_MAC    = 1 << 2,
+    OPS_SAI_ACL_FIELD_ETHER_TYPE = 1 << 3,
+    OPS_SAI_ACL_FIELD_VLAN_ID    = 1 << 4,
+    OPS_SAI_ACL_FIELD_SRC_IP     = 1 << 5,
+    OPS_SAI_ACL_FIELD_DST_IP     = 1 << 6,
+    OPS_SAI_ACL_FIELD_SRC_IPV6   = 1 << 7,
+    OPS_SAI_ACL_FIELD_DST_IPV6   = 1 << 8,
+    OPS_SAI_ACL_FIELD_IP_PROTO   = 1 << 9,
+    OPS_SAI_ACL_FIELD_DSCP       = 1 << 10,
+    OPS_SAI_ACL_FIELD_L4_SRC     = 1 << 11,
+    OPS_SAI_ACL_FIELD_L4_DST     = 1 << 12,
+    OPS_SAI_ACL_FIELD_TCP_FLAGS  = 1 << 13,
+};
+
+enum ops_sai_acl_action {
+    OPS_SAI_ACL_ACTION_DROP,
+    OPS_SAI_ACL_ACTION_FORWARD,
+    OPS_SAI_ACL_ACTION_TRAP,        /* Send to CPU only. */
+    OPS_SAI_ACL_ACTION_REDIRECT,    /* Send to single port. */
+};
+
+/* ACL rule in host byte order, fields not set in 'fields' are wildcarded. */
+struct ops_sai_acl_rule {
+    uint16_t priority;              /* Higher value wins. */
+    uint32_t fields;                /* OPS_SAI_ACL_FIELD_* bitmap. */
+    uint32_t in_port;               /* Port label id. */
+    struct eth_addr src_mac;
+    struct eth_addr src_mac_mask;
+    struct eth_addr dst_mac;
+    struct eth_addr dst_mac_mask;
+    uint16_t ether_type;
+    uint16_t vlan_id;
+    uint32_t src_ip;
+    uint32_t src_ip_mask;
+    uint32_t dst_ip;
+    uint32_t dst_ip_mask;
+    struct in6_addr src_ipv6;
+    struct in6_addr src_ipv6_mask;
+    struct in6_addr dst_ipv6;
+    struct in6_addr dst_ipv6_mask;
+    uint8_t ip_proto;
+    uint8_t dscp;
+    uint16_t l4_src;
+    uint16_t l4_src_mask;
+    uint16_t l4_dst;
+    uint16_t l4_dst_mask;
+    uint8_t tcp_flags;
+    uint8_t tcp_flags_mask;
+
+    enum ops_sai_acl_action action;
+    uint32_t redirect_port;         /* Port label id of REDIRECT action. */
+};
+
+struct ops_sai_acl_stats {
+    uint64_t packets;
+    uint64_t bytes;
+};
+
+struct acl_class {
+    /**
+     * Initialize ACL. Creates ingress ACL table.
+     */
+    void (*init)(void);
+    /**
+     * Check whether ACL rule can be added, so that rule which would never be
+     * programmed is rejected up front.
+     *
+     * @param[in] rule - ACL rule.
+     *
+     * @return 0          rule can be added
+     * @return EOPNOTSUPP ACL offload is disabled
+     * @return ERANGE     priority does not fit ACL priority range of the switch
+     */
+    int (*rule_check)(const struct ops_sai_acl_rule *rule);
+    /**
+     * Add ACL rule. Rule is programmed to hardware on next commit. Rule takes
+     * one TCAM entry, or none if it is shadowed by higher priority rule.
+     *
+     * @param[in]  rule   - ACL rule.
+     * @param[out] handle - installed rule handle.
+     *
+     * @return 0     operation completed successfully
+     * @return ERANGE priority does not fit ACL priority range of the switch
+     * @return errno operation failed
+     */
+    int (*rule_add)(const struct ops_sai_acl_rule *rule, handle_t *handle);
+    /**
+     * Remove ACL rule. Rule is removed from hardware on next commit.
+     *
+     * @param[in] handle - installed rule handle.
+     *
+     * @return 0     operation completed successfully
+     * @return errno operation failed
+     */
+    int (*rule_remove)(const handle_t *handle);
+    /**
+     * Activate rules added and removed since previous commit. Added rules
+     * are installed before removed ones are freed.
+     */
+    void (*commit)(void);
+    /**
+     * Read counters of ACL rule.
+     *
+     * @param[in]  handle - installed rule handle.
+     * @param[out] stats  - rule counters.
+     *
+     * @return 0     operation completed successfully
+     * @return errno operation failed
+     */
+    int (*rule_stats_get)(const handle_t *handle,
+                          struct ops_sai_acl_stats *stats);
+    /**
+     * Forward counters of ACL rule to another rule. Counters of 'from' are
+     * read for the last time when its entry is destroyed and are added to
+     * 'to', so traffic matched until next commit is not lost.
+     *
+     * @param[in] from - installed rule handle, being replaced.
+     * @param[in] to   - installed rule handle, replacing 'from'.
+     *
+     * @return 0     operation completed successfully
+     * @return errno operation failed
+     */
+    int (*rule_stats_forward)(const handle_t *from, const handle_t *to);
+    /**
+     * De-initialize ACL. Removes remaining rules and ACL table.
+     */
+    void (*deinit)(void);
+};
+
+DECLARE_GENERIC_CLASS_GETTER(struct acl_class, acl);
+
+#define ops_sai_acl_class_generic() (CLASS_GENERIC_GETTER(acl)())
+
+#ifndef ops_sai_acl_class
+#define ops_sai_acl_class ops_sai_acl_class_generic
+#endif
+
+static inline void
+ops_sai_acl_init(void)
+{
+    ovs_assert(ops_sai_acl_class()->init);
+    ops_sai_acl_class()->init();
+}
+
+static inline int
+ops_sai_acl_rule_check(const struct ops_sai_acl_rule *rule)
+{
+    ovs_assert(ops_sai_acl_class()->rule_check);
+    return ops_sai_acl_class()->rule_check(rule);
+}
+
+static inline int
+ops_sai_acl_rule_add(const struct ops_sai_acl_rule *rule, handle_t *handle)
+{
+    ovs_assert(ops_sai_acl_class()->rule_add);
+    return ops_sai_acl_class()->rule_add(rule, handle);
+}
+
+static inline int
+ops_sai_acl_rule_remove(const handle_t *handle)
+{
+    ovs_assert(ops_sai_acl_class()->rule_remove);
+    return ops_sai_acl_class()->rule_remove(handle);
+}
+
+static inline void
+ops_sai_acl_commit(void)
+{
+    ovs_assert(ops_sai_acl_class()->commit);
+    ops_sai_acl_class()->commit();
+}
+
+static inline int
+ops_sai_acl_rule_stats_get(const handle_t *handle,
+                           struct ops_sai_acl_stats *stats)
+{
+    ovs_assert(ops_sai_acl_class()->rule_stats_get);
+    return ops_sai_acl_class()->rule_stats_get(handle, stats);
+}
+
+static inline int
+ops_sai_acl_rule_stats_forward(const handle_t *from, const handle_t *to)
+{
+    ovs_assert(ops_sai_acl_class()->rule_stats_forward);
+    return ops_sai_acl_class()->rule_stats_forward(from, to);
+}
+
+static inline void
+ops_sai_acl_deinit(void)
+{
+    ovs_assert(ops_sai_acl_class()->deinit);
+    ops_sai_acl_class()->deinit();
+}
+
+void ops_sai_acl_run(void);
+void ops_sai_acl_wait(void);
+
+#endif /* SAI_ACL_H */
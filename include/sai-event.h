@@ -0,0 +1,37 @@
+/*
+ * Copyright Mellanox Technologies, Ltd. 2001-2016.
+ * This software product is licensed under Apache version 2, as detailed in
+ * the COPYING file.
+ */
+
+#ifndef SAI_EVENT_H
+#define SAI_EVENT_H 1
+
+#include <stdbool.h>
+#include <sai.h>
+
+enum ops_sai_event_type {
+    OPS_SAI_EVENT_PORT_STATE,
+    OPS_SAI_EVENT_SWITCH_STATE,
+    OPS_SAI_EVENT_SWITCH_SHUTDOWN,
+};
+
+/* Notification posted by SAI threads for processing in main loop. */
+struct ops_sai_event {
+    enum ops_sai_event_type type;
+    union {
+        struct {
+            sai_object_id_t oid;
+            bool up;
+        } port_state;
+        sai_switch_oper_status_t switch_state;
+    };
+};
+
+void ops_sai_event_init(void);
+void ops_sai_event_deinit(void);
+void ops_sai_event_push(const struct ops_sai_event *);
+void ops_sai_event_run(void);
+void ops_sai_event_wait(void);
+
+#endif /* sai-event.h */
@@ -12,6 +12,48 @@
 #include <sai-vendor-common.h>
 #endif /* SAI_VENDOR */
 
+/* Packet fields LAG member is selected by. */
+enum ops_sai_lag_hash_field {
+    OPS_SAI_LAG_HASH_SRC_MAC    = 1 << 0,
+    OPS_SAI_LAG_HASH_DST_MAC    = 1 << 1,
+    OPS_SAI_LAG_HASH_ETHERTYPE  = 1 << 2,
+    OPS_SAI_LAG_HASH_VLAN_ID    = 1 << 3,
+    OPS_SAI_LAG_HASH_SRC_IP     = 1 << 4,
+    OPS_SAI_LAG_HASH_DST_IP     = 1 << 5,
+    OPS_SAI_LAG_HASH_IP_PROTO   = 1 << 6,
+    OPS_SAI_LAG_HASH_SRC_PORT   = 1 << 7,
+    OPS_SAI_LAG_HASH_DST_PORT   = 1 << 8,
+    OPS_SAI_LAG_HASH_INNER      = 1 << 9,   /* Hash same fields of inner
+                                             * headers of tunneled packets. */
+};
+
+#define OPS_SAI_LAG_HASH_L2 \
+    (OPS_SAI_LAG_HASH_SRC_MAC | OPS_SAI_LAG_HASH_DST_MAC | \
+     OPS_SAI_LAG_HASH_ETHERTYPE | OPS_SAI_LAG_HASH_VLAN_ID)
+#define OPS_SAI_LAG_HASH_L3 \
+    (OPS_SAI_LAG_HASH_SRC_IP | OPS_SAI_LAG_HASH_DST_IP | \
+     OPS_SAI_LAG_HASH_IP_PROTO)
+#define OPS_SAI_LAG_HASH_L4 \
+    (OPS_SAI_LAG_HASH_SRC_PORT | OPS_SAI_LAG_HASH_DST_PORT)
+#define OPS_SAI_LAG_HASH_DEFAULT \
+    (OPS_SAI_LAG_HASH_L2 | OPS_SAI_LAG_HASH_L3 | OPS_SAI_LAG_HASH_L4 | \
+     OPS_SAI_LAG_HASH_INNER)
+
+/* Function ECMP next hop is selected with. */
+enum ops_sai_ecmp_hash_algorithm {
+    OPS_SAI_ECMP_HASH_ALGORITHM_CRC,
+    OPS_SAI_ECMP_HASH_ALGORITHM_XOR,
+    OPS_SAI_ECMP_HASH_ALGORITHM_RANDOM,
+};
+
+struct ops_sai_ecmp_hash_params {
+    uint32_t seed;
+    enum ops_sai_ecmp_hash_algorithm algorithm;
+    bool symmetric;                 /* Both directions of a flow hash the
+                                     * same, source and destination fields
+                                     * are swapped for one of them. */
+};
+
 struct hash_class {
     /**
      * Initialize hashing. Set default hash fields.
@@ -27,6 +69,29 @@ struct hash_class {
      * @return errno operation failed
      */
     int  (*ecmp_hash_set)(uint64_t hash, bool enable);
+    /**
+     * Set ECMP hash seed, function and symmetric mode. Switches of the same
+     * network should use different seed or function, otherwise each tier
+     * splits flows the same way as the previous one, and only part of next
+     * hops of the next tier receive traffic.
+     *
+     * @param[in] params - hash parameters.
+     *
+     * @return 0 operation completed successfully
+     * @return errno operation failed
+     */
+    int  (*ecmp_hash_params_set)(const struct ops_sai_ecmp_hash_params *params);
+    /**
+     * Set LAG hash fields and seed. Seed should differ between switches of
+     * the same network, so that they don't select members the same way.
+     *
+     * @param[in] fields - bitmap of ops_sai_lag_hash_field.
+     * @param[in] seed   - hash seed.
+     *
+     * @return 0 operation completed successfully
+     * @return errno operation failed
+     */
+    int  (*lag_hash_set)(uint32_t fields, uint32_t seed);
     /**
      * De-initialize hashing.
      */
@@ -55,6 +120,20 @@ ops_sai_ecmp_hash_set(uint64_t fields_to_set, bool enable)
     return ops_sai_hash_class()->ecmp_hash_set(fields_to_set, enable);
 }
 
+static inline int
+ops_sai_ecmp_hash_params_set(const struct ops_sai_ecmp_hash_params *params)
+{
+    ovs_assert(ops_sai_hash_class()->ecmp_hash_params_set);
+    return ops_sai_hash_class()->ecmp_hash_params_set(params);
+}
+
+static inline int
+ops_sai_lag_hash_set(uint32_t fields, uint32_t seed)
+{
+    ovs_assert(ops_sai_hash_class()->lag_hash_set);
+    return ops_sai_hash_class()->lag_hash_set(fields, seed);
+}
+
 static inline void
 ops_sai_ecmp_hash_deinit(void)
 {
@@ -62,4 +141,10 @@ ops_sai_ecmp_hash_deinit(void)
     return ops_sai_hash_class()->deinit();
 }
 
+uint32_t ops_sai_lag_hash_seed_default(void);
+void ops_sai_ecmp_hash_params_default(struct ops_sai_ecmp_hash_params *);
+const char *ops_sai_ecmp_hash_algorithm_str(enum ops_sai_ecmp_hash_algorithm);
+void ops_sai_hash_unixctl_register(void);
+int ops_sai_hash_reapply(void);
+
 #endif /* SAI_HASH_H */
@@ -9,10 +9,14 @@
 
 #include <sai-common.h>
 #include <sai-policer.h>
+#include <sai-rx.h>
 #ifdef SAI_VENDOR
 #include <sai-vendor-common.h>
 #endif /* SAI_VENDOR */
 
+struct ops_sai_trap_group_stats_list;
+struct ops_sai_trap_group_entry;
+
 enum host_intf_type {
     HOST_INTF_TYPE_L2_PORT_NETDEV,
     HOST_INTF_TYPE_L3_PORT_NETDEV,
@@ -59,6 +63,55 @@ struct host_intf_class {
     * Unregisters traps for packets.
     */
     void (*traps_unregister)(void);
+    /**
+     * Sends packet from CPU. Packet data is passed to SAI as is.
+     *
+     * @param[in] data  - packet data.
+     * @param[in] size  - packet size.
+     * @param[in] hw_id - egress port label id, or NULL to let pipeline
+     *                    forward the packet.
+     *
+     * @return 0 operation completed successfully
+     * @return errno operation failed
+     */
+    int (*packet_send)(void *data, size_t size, const uint32_t *hw_id);
+    /**
+     * Reads counters of all trap groups and appends them to list.
+     *
+     * @param[in,out] list - trap group counters.
+     */
+    void (*trap_group_stats_collect)(struct ops_sai_trap_group_stats_list *list);
+    /**
+     * Get trap groups created by vendor outside of trap group configuration.
+     * Their policers are tuned along with policers of configured groups.
+     *
+     * @return list of struct ops_sai_trap_group_entry.
+     */
+    struct ovs_list *(*vendor_trap_groups_get)(void);
+    /**
+     * Reads policer counters of trap group.
+     *
+     * @param[in]  entry - trap group.
+     * @param[out] stats - policer counters.
+     *
+     * @return 0 operation completed successfully
+     * @return errno operation failed
+     */
+    int (*trap_group_policer_stats_get)(
+                                const struct ops_sai_trap_group_entry *entry,
+                                struct ops_sai_policer_stats *stats);
+    /**
+     * Changes rate and burst of trap group policer.
+     *
+     * @param[in] entry  - trap group.
+     * @param[in] config - new policer configuration.
+     *
+     * @return 0 operation completed successfully
+     * @return errno operation failed
+     */
+    int (*trap_group_policer_update)(
+                                const struct ops_sai_trap_group_entry *entry,
+                                const struct ops_sai_policer_config *config);
     /**
     * De-initialize host interface.
     */
@@ -83,6 +136,37 @@ struct ops_sai_trap_group_config {
     uint32_t priority;
     bool is_log;
     bool is_l3;
+    bool is_cb;     /* Deliver to receive engine instead of netdev. */
+    bool has_queue; /* CPU queue is set, otherwise default queue is used. */
+    uint32_t queue;
+    /* Callback groups only: serve receive queue from dedicated thread. */
+    bool has_rx_worker;
+    int rx_core;            /* Core to pin worker to, -1 for any core. */
+    /* Bounds of adaptive policer rate, tuning is disabled if rate_min is 0.
+     * Rate stays at policer_config.rate_max when CPU is not congested. */
+    uint32_t rate_min;      /* Floor while group is flooded. */
+    uint32_t rate_ceil;     /* Ceiling of critical groups while CPU idles. */
+};
+
+struct ops_sai_host_intf_tx_stats {
+    uint64_t packets;
+    uint64_t bytes;
+    uint64_t errors;
+};
+
+struct ops_sai_trap_group_stats {
+    char name[SAI_TRAP_GROUP_MAX_NAME_LEN];
+    struct ops_sai_policer_stats policer;
+    uint32_t rate;                  /* Current policer rate, 0 if unknown. */
+    bool has_rx;                    /* Group is served by receive engine. */
+    struct ops_sai_rx_stats rx;
+};
+
+struct ops_sai_trap_group_stats_list {
+    struct ops_sai_trap_group_stats *entries;
+    size_t n;
+    size_t allocated;
+    long long int updated;          /* time_msec() of last collection. */
 };
 
 struct ops_sai_trap_group_entry {
@@ -90,6 +174,12 @@ struct ops_sai_trap_group_entry {
     struct ovs_list list_node;
     handle_t trap_group;
     handle_t policer;
+    /* Adaptive policer state, config is private copy of group
+     * configuration. */
+    struct ops_sai_trap_group_config *config;
+    uint32_t rate;
+    uint64_t red_packets;
+    bool is_flooded;
 };
 
 static inline void ops_sai_host_intf_init(void)
@@ -126,6 +216,44 @@ static inline void ops_sai_host_intf_traps_unregister(void)
     ops_sai_host_intf_class()->traps_unregister();
 }
 
+static inline int ops_sai_host_intf_packet_send(void *data, size_t size,
+                                                const uint32_t *hw_id)
+{
+    ovs_assert(ops_sai_host_intf_class()->packet_send);
+    return ops_sai_host_intf_class()->packet_send(data, size, hw_id);
+}
+
+static inline void ops_sai_host_intf_trap_group_stats_collect(
+                                    struct ops_sai_trap_group_stats_list *list)
+{
+    ovs_assert(ops_sai_host_intf_class()->trap_group_stats_collect);
+    ops_sai_host_intf_class()->trap_group_stats_collect(list);
+}
+
+static inline struct ovs_list *ops_sai_host_intf_vendor_trap_groups_get(void)
+{
+    ovs_assert(ops_sai_host_intf_class()->vendor_trap_groups_get);
+    return ops_sai_host_intf_class()->vendor_trap_groups_get();
+}
+
+static inline int ops_sai_host_intf_trap_group_policer_stats_get(
+                                const struct ops_sai_trap_group_entry *entry,
+                                struct ops_sai_policer_stats *stats)
+{
+    ovs_assert(ops_sai_host_intf_class()->trap_group_policer_stats_get);
+    return ops_sai_host_intf_class()->trap_group_policer_stats_get(entry,
+                                                                   stats);
+}
+
+static inline int ops_sai_host_intf_trap_group_policer_update(
+                                const struct ops_sai_trap_group_entry *entry,
+                                const struct ops_sai_policer_config *config)
+{
+    ovs_assert(ops_sai_host_intf_class()->trap_group_policer_update);
+    return ops_sai_host_intf_class()->trap_group_policer_update(entry,
+                                                                config);
+}
+
 static inline void ops_sai_host_intf_deinit(void)
 {
     ovs_assert(ops_sai_host_intf_class()->deinit);
@@ -133,5 +261,13 @@ static inline void ops_sai_host_intf_deinit(void)
 }
 
 const char *ops_sai_host_intf_type_to_str(enum host_intf_type);
+void ops_sai_host_intf_tx_stats_get(struct ops_sai_host_intf_tx_stats *);
+struct ops_sai_trap_group_stats *
+ops_sai_trap_group_stats_list_add(struct ops_sai_trap_group_stats_list *,
+                                  const char *name);
+const struct ops_sai_trap_group_stats_list *
+ops_sai_host_intf_trap_group_stats_get(void);
+void ops_sai_host_intf_run(void);
+void ops_sai_host_intf_wait(void);
 
 #endif /* sai-host-intf.h */
@@ -0,0 +1,137 @@
+/*
+ * Copyright Mellanox Technologies, Ltd. 2001-2016.
+ * This software product is licensed under Apache version 2, as detailed in
+ * the COPYING file.
+ */
+
+#ifndef SAI_LAG_H
+#define SAI_LAG_H 1
+
+#include <sai-common.h>
+#ifdef SAI_VENDOR
+#include <sai-vendor-common.h>
+#endif /* SAI_VENDOR */
+
+/* LAGs get label IDs above physical port label IDs, so that VLAN, PVID and
+ * router interface configuration can address them the same way as ports. */
+#define OPS_SAI_LAG_HW_ID_BASE (0x10000)
+
+struct lag_class {
+    /**
+     * Initialize LAGs.
+     */
+    void (*init)(void);
+    /**
+     * Create LAG without members.
+     *
+     * @param[out] hw_id - label id assigned to LAG.
+     *
+     * @return 0     operation completed successfully
+     * @return errno operation failed
+     */
+    int (*create)(uint32_t *hw_id);
+    /**
+     * Remove LAG and its remaining members.
+     *
+     * @param[in] hw_id - LAG label id.
+     *
+     * @return 0     operation completed successfully
+     * @return errno operation failed
+     */
+    int (*remove)(uint32_t hw_id);
+    /**
+     * Add port to LAG.
+     *
+     * @param[in] hw_id      - LAG label id.
+     * @param[in] port_hw_id - port label id.
+     *
+     * @return 0     operation completed successfully
+     * @return errno operation failed
+     */
+    int (*member_add)(uint32_t hw_id, uint32_t port_hw_id);
+    /**
+     * Remove port from LAG.
+     *
+     * @param[in] hw_id      - LAG label id.
+     * @param[in] port_hw_id - port label id.
+     *
+     * @return 0     operation completed successfully
+     * @return errno operation failed
+     */
+    int (*member_del)(uint32_t hw_id, uint32_t port_hw_id);
+    /**
+     * Exclude LAG member from or return it to traffic distribution on link
+     * state change, without waiting for bundle reconfiguration. Does
+     * nothing if port is not LAG member.
+     *
+     * @param[in] port_hw_id - port label id.
+     * @param[in] up         - port operational state.
+     *
+     * @return 0     operation completed successfully
+     * @return errno operation failed
+     */
+    int (*port_state_set)(uint32_t port_hw_id, bool up);
+    /**
+     * De-initialize LAGs. Removes remaining LAGs.
+     */
+    void (*deinit)(void);
+};
+
+DECLARE_GENERIC_CLASS_GETTER(struct lag_class, lag);
+
+#define ops_sai_lag_class_generic() (CLASS_GENERIC_GETTER(lag)())
+
+#ifndef ops_sai_lag_class
+#define ops_sai_lag_class ops_sai_lag_class_generic
+#endif
+
+static inline void
+ops_sai_lag_init(void)
+{
+    ovs_assert(ops_sai_lag_class()->init);
+    ops_sai_lag_class()->init();
+}
+
+static inline int
+ops_sai_lag_create(uint32_t *hw_id)
+{
+    ovs_assert(ops_sai_lag_class()->create);
+    return ops_sai_lag_class()->create(hw_id);
+}
+
+static inline int
+ops_sai_lag_remove(uint32_t hw_id)
+{
+    ovs_assert(ops_sai_lag_class()->remove);
+    return ops_sai_lag_class()->remove(hw_id);
+}
+
+static inline int
+ops_sai_lag_member_add(uint32_t hw_id, uint32_t port_hw_id)
+{
+    ovs_assert(ops_sai_lag_class()->member_add);
+    return ops_sai_lag_class()->member_add(hw_id, port_hw_id);
+}
+
+static inline int
+ops_sai_lag_member_del(uint32_t hw_id, uint32_t port_hw_id)
+{
+    ovs_assert(ops_sai_lag_class()->member_del);
+    return ops_sai_lag_class()->member_del(hw_id, port_hw_id);
+}
+
+static inline int
+ops_sai_lag_port_state_set(uint32_t port_hw_id, bool up)
+{
+    ovs_assert(ops_sai_lag_class()->port_state_set);
+    return ops_sai_lag_class()->port_state_set(port_hw_id, up);
+}
+
+static inline void
+ops_sai_lag_deinit(void)
+{
+    ovs_assert(ops_sai_lag_class()->deinit);
+    ops_sai_lag_class()->deinit();
+}
+
+#endif /* SAI_LAG_H */
@@ -0,0 +1,75 @@
+/*
+ * Copyright Mellanox Technologies, Ltd. 2001-2016.
+ * This software product is licensed under Apache version 2, as detailed in
+ * the COPYING file.
+ */
+
+#ifndef SAI_NETLINK_H
+#define SAI_NETLINK_H 1
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <netinet/in.h>
+#include <ofpbuf.h>
+#include <netlink-socket.h>
+
+#define OPS_SAI_NETLINK_ADDR_MAX  32
+/* Re-created link, its state and every address fit into one batch. */
+#define OPS_SAI_NETLINK_BATCH_MAX (OPS_SAI_NETLINK_ADDR_MAX + 4)
+
+struct eth_addr;
+
+/* Link requests sent to kernel with single sendmsg(). */
+struct ops_sai_netlink_batch {
+    size_t n;
+    struct ofpbuf requests[OPS_SAI_NETLINK_BATCH_MAX];
+    struct nl_transaction txns[OPS_SAI_NETLINK_BATCH_MAX];
+};
+
+struct ops_sai_netlink_addr {
+    uint8_t family;
+    uint8_t prefixlen;
+    union {
+        struct in_addr ip4;
+        struct in6_addr ip6;
+    };
+};
+
+/* Kernel visible state of link, preserved when link is re-created. */
+struct ops_sai_netlink_link_state {
+    int ifindex;
+    bool up;
+    uint32_t mtu;
+    size_t n_addrs;
+    struct ops_sai_netlink_addr addrs[OPS_SAI_NETLINK_ADDR_MAX];
+};
+
+/* Puts link kind specific attributes into IFLA_INFO_DATA. */
+typedef void (*ops_sai_netlink_info_data_cb)(struct ofpbuf *, const void *);
+
+void ops_sai_netlink_batch_init(struct ops_sai_netlink_batch *);
+void ops_sai_netlink_batch_destroy(struct ops_sai_netlink_batch *);
+int ops_sai_netlink_batch_commit(struct ops_sai_netlink_batch *);
+
+void ops_sai_netlink_link_add(struct ops_sai_netlink_batch *, const char *name,
+                              int ifindex, const char *kind,
+                              const char *parent, const struct eth_addr *,
+                              ops_sai_netlink_info_data_cb, const void *aux);
+void ops_sai_netlink_vlan_add(struct ops_sai_netlink_batch *, const char *name,
+                              const char *parent, uint16_t vid,
+                              const struct eth_addr *);
+void ops_sai_netlink_link_del(struct ops_sai_netlink_batch *,
+                              const char *name);
+void ops_sai_netlink_link_set_address(struct ops_sai_netlink_batch *,
+                                      const char *name,
+                                      const struct eth_addr *);
+void ops_sai_netlink_link_set_up(struct ops_sai_netlink_batch *,
+                                 const char *name, bool up);
+
+int ops_sai_netlink_link_state_get(const char *name,
+                                   struct ops_sai_netlink_link_state *);
+void ops_sai_netlink_link_state_put(struct ops_sai_netlink_batch *,
+                                    const char *name, int ifindex,
+                                    const struct ops_sai_netlink_link_state *);
+
+#endif /* sai-netlink.h */
@@ -0,0 +1,63 @@
+/*
+ * Copyright Mellanox Technologies, Ltd. 2001-2016.
+ * This software product is licensed under Apache version 2, as detailed in
+ * the COPYING file.
+ */
+
+#ifndef SAI_NHG_H
+#define SAI_NHG_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <hmap.h>
+
+/* Default number of buckets of resilient or weighted next hop group. */
+#define OPS_SAI_NHG_BUCKETS_DEFAULT (64)
+
+struct ops_sai_nhg_member {
+    char *next_hop;
+    uint32_t weight;                /* Share of buckets relative to other
+                                     * members. */
+    size_t n_buckets;               /* Number of buckets owned. */
+};
+
+/*
+ * Next hop group of remote route. With resilient hashing next hops are
+ * spread over fixed number of buckets, so hash of a flow always selects the
+ * same bucket. When next hop is added or removed, only buckets which have to
+ * move to keep distribution even are reassigned, and flows hashed to other
+ * buckets keep their next hop. Next hops get buckets in proportion to their
+ * weights, which are derived from egress port speed or configured by user.
+ * Group without buckets only tracks next hops of plain ECMP route, it gets
+ * buckets once its next hops have different weights.
+ */
+struct ops_sai_nhg {
+    struct hmap_node node;
+    uint64_t vrid;
+    char *prefix;
+    size_t n_buckets;               /* 0 for plain ECMP. */
+    const char **buckets;           /* Next hop of each bucket, points to
+                                     * 'next_hop' of member. */
+    struct ops_sai_nhg_member *members;
+    size_t n_members;
+    bool installed;                 /* Route is programmed to hardware. */
+};
+
+void ops_sai_nhg_init(void);
+void ops_sai_nhg_deinit(void);
+size_t ops_sai_nhg_resilient_buckets(void);
+struct ops_sai_nhg *ops_sai_nhg_find(uint64_t, const char *);
+struct ops_sai_nhg *ops_sai_nhg_create(uint64_t, const char *, size_t);
+void ops_sai_nhg_destroy(struct ops_sai_nhg *);
+bool ops_sai_nhg_members_add(struct ops_sai_nhg *, uint32_t,
+                             char *const *const);
+bool ops_sai_nhg_members_del(struct ops_sai_nhg *, uint32_t,
+                             char *const *const);
+void ops_sai_nhg_buckets_set(struct ops_sai_nhg *, size_t);
+bool ops_sai_nhg_is_weighted(const struct ops_sai_nhg *);
+uint32_t ops_sai_nhg_weight_get(uint64_t, const char *);
+int ops_sai_nhg_weight_set(uint64_t, const char *, uint32_t, bool,
+                           int (*)(struct ops_sai_nhg *));
+
+#endif /* sai-nhg.h */
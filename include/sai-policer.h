@@ -12,11 +12,20 @@
 #include <sai-vendor-common.h>
 #endif /* SAI_VENDOR */
 
+/* Counter value of counters not supported by the policer. */
+#define OPS_SAI_POLICER_STAT_NA UINT64_MAX
+
 struct ops_sai_policer_config {
     uint32_t burst_max;
     uint32_t rate_max;
 };
 
+struct ops_sai_policer_stats {
+    uint64_t green_packets;
+    uint64_t yellow_packets;
+    uint64_t red_packets;
+};
+
 struct policer_class {
     /**
     * Initialize policers.
@@ -41,6 +50,27 @@ struct policer_class {
      * @return 0 on success, sai status converted to errno value.
      */
     int (*remove)(const handle_t *handle);
+    /**
+     * Change rate and burst of existing policer.
+     *
+     * param[in] handle - pointer to policer object.
+     * @param[in] config - pointer to policer configuration.
+     *
+     * @return 0 on success, sai status converted to errno value.
+     */
+    int (*update)(const handle_t                      *handle,
+                  const struct ops_sai_policer_config *config);
+    /**
+     * Read policer counters.
+     *
+     * param[in]  handle - pointer to policer object.
+     * param[out] stats  - policer counters, OPS_SAI_POLICER_STAT_NA for
+     *                     counters policer does not support.
+     *
+     * @return 0 on success, sai status converted to errno value.
+     */
+    int (*stats_get)(const handle_t *handle,
+                     struct ops_sai_policer_stats *stats);
     /**
      * De-initialize policers.
      */
@@ -74,6 +104,20 @@ static inline int ops_sai_policer_remove(const handle_t *handle)
     return ops_sai_policer_class_generic()->remove(handle);
 }
 
+static inline int ops_sai_policer_update(const handle_t *handle,
+                                         const struct ops_sai_policer_config *config)
+{
+    ovs_assert(ops_sai_policer_class_generic()->update);
+    return ops_sai_policer_class_generic()->update(handle, config);
+}
+
+static inline int ops_sai_policer_stats_get(const handle_t *handle,
+                                            struct ops_sai_policer_stats *stats)
+{
+    ovs_assert(ops_sai_policer_class_generic()->stats_get);
+    return ops_sai_policer_class_generic()->stats_get(handle, stats);
+}
+
 static inline void ops_sai_policer_deinit(void)
 {
     ovs_assert(ops_sai_policer_class_generic()->deinit);
@@ -0,0 +1,49 @@
+/*
+ * Copyright Mellanox Technologies, Ltd. 2001-2016.
+ * This software product is licensed under Apache version 2, as detailed in
+ * the COPYING file.
+ */
+
+#ifndef SAI_RING_H
+#define SAI_RING_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <ovs-atomic.h>
+
+/*
+ * Bounded multi-producer single-consumer ring of fixed size elements.
+ *
+ * Producers (SAI/SDK notification threads) never block: when the ring is
+ * full the element is dropped and accounted in 'n_dropped'. The consumer is
+ * the OVS main loop or a worker thread, woken up through an eventfd.
+ */
+struct ops_sai_ring {
+    uint8_t *cells;
+    size_t cell_size;
+    size_t elem_size;
+    uint32_t mask;
+    atomic_uint32_t head;       /* Next position to be claimed by producer. */
+    atomic_uint32_t tail;       /* Next position to be consumed, written by
+                                 * consumer only. */
+    int wake_fd;
+    atomic_flag wake_pending;
+    atomic_uint64_t n_dropped;
+};
+
+int ops_sai_ring_init(struct ops_sai_ring *, uint32_t size, size_t elem_size);
+void ops_sai_ring_destroy(struct ops_sai_ring *);
+bool ops_sai_ring_push(struct ops_sai_ring *, const void *elem);
+void *ops_sai_ring_reserve(struct ops_sai_ring *);
+void ops_sai_ring_commit(struct ops_sai_ring *, void *slot);
+bool ops_sai_ring_pop(struct ops_sai_ring *, void *elem);
+const void *ops_sai_ring_peek(struct ops_sai_ring *);
+void ops_sai_ring_release(struct ops_sai_ring *);
+bool ops_sai_ring_is_empty(struct ops_sai_ring *);
+uint32_t ops_sai_ring_count(struct ops_sai_ring *);
+uint64_t ops_sai_ring_dropped_get(struct ops_sai_ring *);
+void ops_sai_ring_wake_clear(struct ops_sai_ring *);
+void ops_sai_ring_wait(struct ops_sai_ring *);
+
+#endif /* sai-ring.h */
@@ -12,6 +12,9 @@
 #include <sai-vendor-common.h>
 #endif /* SAI_VENDOR */
 
+/* Derived next hop weight of next hop whose egress ports are all down. */
+#define OPS_SAI_ROUTE_NH_WEIGHT_DOWN (UINT32_MAX)
+
 struct route_class {
     /**
     * Initializes route.
@@ -85,6 +88,23 @@ struct route_class {
      * @return 0     if operation completed successfully.
      * @return errno if operation failed.*/
     int  (*remove)(const handle_t *vrid, const char *prefix);
+    /**
+     *  Function for setting weight of next hop in all remote routes of
+     *  virtual router. Traffic of route is shared between its next hops in
+     *  proportion to weights. Weight configured by user takes precedence
+     *  over the one derived from egress port speed.
+     *
+     * @param[in] vrid       - virtual router ID
+     * @param[in] next_hop   - next hop IP address
+     * @param[in] weight     - weight, 0 to unset, OPS_SAI_ROUTE_NH_WEIGHT_DOWN
+     *                         if egress ports are down
+     * @param[in] configured - weight is configured by user, otherwise it is
+     *                         derived from egress port speed
+     *
+     * @return 0     if operation completed successfully.
+     * @return errno if operation failed.*/
+    int  (*nh_weight_set)(const handle_t *vrid, const char *next_hop,
+                          uint32_t weight, bool configured);
     /**
      * De-initializes route.
      */
@@ -152,6 +172,15 @@ ops_sai_route_remove(const handle_t *vrid, const char     *prefix)
     return ops_sai_route_class()->remove(vrid, prefix);
 }
 
+static inline int
+ops_sai_route_nh_weight_set(const handle_t *vrid, const char *next_hop,
+                            uint32_t weight, bool configured)
+{
+    ovs_assert(ops_sai_route_class()->nh_weight_set);
+    return ops_sai_route_class()->nh_weight_set(vrid, next_hop, weight,
+                                                configured);
+}
+
 static inline void
 ops_sai_route_deinit(void)
 {
@@ -0,0 +1,56 @@
+/*
+ * Copyright Mellanox Technologies, Ltd. 2001-2016.
+ * This software product is licensed under Apache version 2, as detailed in
+ * the COPYING file.
+ */
+
+#ifndef SAI_RX_H
+#define SAI_RX_H 1
+
+#include <stdint.h>
+#include <sai.h>
+
+/* Receive queue is served by main loop. */
+#define SAI_RX_WORKER_NONE (-2)
+/* Receive queue is served by worker thread without CPU affinity. */
+#define SAI_RX_WORKER_ANY  (-1)
+
+/* Smallest frame receive ring slot holds. Slots grow with the largest port
+ * MTU, see ops_sai_rx_port_mtu_update(). */
+#define SAI_RX_FRAME_SIZE_MIN (2048)
+
+/* Packet trapped to CPU. Lives in receive ring, valid only during callback. */
+struct ops_sai_rx_packet {
+    int32_t trap_id;
+    sai_object_id_t in_port;
+    uint32_t size;
+    uint8_t data[];
+};
+
+struct ops_sai_rx_stats {
+    uint64_t accepted;      /* Queued by SAI thread. */
+    uint64_t dropped;       /* Ring full or packet larger than slot. */
+    uint64_t delivered;     /* Handed to consumer. */
+    uint64_t no_consumer;   /* Dequeued, but trap has no consumer. */
+    uint32_t depth;         /* Packets waiting in queue. */
+    uint32_t capacity;
+};
+
+typedef void (*ops_sai_rx_cb)(const struct ops_sai_rx_packet *, void *aux);
+
+void ops_sai_rx_init(void);
+void ops_sai_rx_deinit(void);
+int ops_sai_rx_queue_create(const char *name, uint32_t priority,
+                            int worker_core);
+void ops_sai_rx_queue_destroy(const char *name);
+int ops_sai_rx_trap_bind(const char *queue_name, int32_t trap_id);
+int ops_sai_rx_consumer_register(int32_t trap_id, ops_sai_rx_cb, void *aux);
+void ops_sai_rx_consumer_unregister(int32_t trap_id);
+void ops_sai_rx_packet_post(const void *buffer, sai_size_t size,
+                            uint32_t attr_count, const sai_attribute_t *);
+void ops_sai_rx_port_mtu_update(int mtu);
+void ops_sai_rx_run(void);
+void ops_sai_rx_wait(void);
+int ops_sai_rx_stats_get(const char *queue_name, struct ops_sai_rx_stats *);
+
+#endif /* sai-rx.h */
@@ -0,0 +1,108 @@
+/*
+ * Copyright Mellanox Technologies, Ltd. 2001-2016.
+ * This software product is licensed under Apache version 2, as detailed in
+ * the COPYING file.
+ */
+
+#ifndef SAI_SFLOW_H
+#define SAI_SFLOW_H 1
+
+#include <sai-common.h>
+#ifdef SAI_VENDOR
+#include <sai-vendor-common.h>
+#endif /* SAI_VENDOR */
+
+struct sset;
+
+/* Directions of port traffic sampled in hardware. */
+enum ops_sai_sflow_direction {
+    OPS_SAI_SFLOW_INGRESS = 1 << 0,
+    OPS_SAI_SFLOW_EGRESS  = 1 << 1,
+};
+
+#define OPS_SAI_SFLOW_BOTH (OPS_SAI_SFLOW_INGRESS | OPS_SAI_SFLOW_EGRESS)
+
+struct ops_sai_sflow_options {
+    const struct sset *targets;     /* Collectors, "IP[:PORT]". */
+    uint32_t sampling_rate;         /* One of N packets is sampled. */
+    uint32_t header_len;            /* Bytes of sampled packet exported. */
+    uint32_t sub_id;                /* sFlow sub-agent ID. */
+    const char *agent_ip;           /* Agent address, NULL if unknown. */
+};
+
+struct sflow_class {
+    /**
+     * Initialize sampling. Sampling is disabled.
+     */
+    void (*init)(void);
+    /**
+     * Set rate of hardware sampling session. Session is created on first
+     * call and removed when rate is 0, ports must not be sampled then.
+     *
+     * @param[in] rate - one of rate packets is sampled, 0 to remove session.
+     *
+     * @return 0 operation completed successfully
+     * @return errno operation failed
+     */
+    int  (*rate_set)(uint32_t rate);
+    /**
+     * Bind port to sampling session. Sampled packets are trapped with
+     * SAI_HOSTIF_TRAP_ID_SAMPLEPACKET.
+     *
+     * @param[in] hw_id      - port label id.
+     * @param[in] directions - bitmap of ops_sai_sflow_direction, 0 unbinds
+     *                         port.
+     *
+     * @return 0 operation completed successfully
+     * @return errno operation failed
+     */
+    int  (*port_set)(uint32_t hw_id, uint32_t directions);
+    /**
+     * De-initialize sampling.
+     */
+    void (*deinit)(void);
+};
+
+DECLARE_GENERIC_CLASS_GETTER(struct sflow_class, sflow);
+
+#define ops_sai_sflow_class_generic() (CLASS_GENERIC_GETTER(sflow)())
+
+#ifndef ops_sai_sflow_class
+#define ops_sai_sflow_class ops_sai_sflow_class_generic
+#endif
+
+static inline void
+ops_sai_sflow_init(void)
+{
+    ovs_assert(ops_sai_sflow_class()->init);
+    ops_sai_sflow_class()->init();
+}
+
+static inline int
+ops_sai_sflow_rate_set(uint32_t rate)
+{
+    ovs_assert(ops_sai_sflow_class()->rate_set);
+    return ops_sai_sflow_class()->rate_set(rate);
+}
+
+static inline int
+ops_sai_sflow_port_sampling_set(uint32_t hw_id, uint32_t directions)
+{
+    ovs_assert(ops_sai_sflow_class()->port_set);
+    return ops_sai_sflow_class()->port_set(hw_id, directions);
+}
+
+static inline void
+ops_sai_sflow_deinit(void)
+{
+    ovs_assert(ops_sai_sflow_class()->deinit);
+    ops_sai_sflow_class()->deinit();
+}
+
+int ops_sai_sflow_set(const struct ops_sai_sflow_options *);
+int ops_sai_sflow_port_set(uint32_t hw_id, uint32_t ifindex, bool enable);
+void ops_sai_sflow_run(void);
+void ops_sai_sflow_wait(void);
+void ops_sai_sflow_unixctl_register(void);
+
+#endif /* SAI_SFLOW_H */
@@ -0,0 +1,22 @@
+/*
+ * Copyright Mellanox Technologies, Ltd. 2001-2016.
+ * This software product is licensed under Apache version 2, as detailed in
+ * the COPYING file.
+ */
+
+#ifndef SAI_TRAP_CONFIG_H
+#define SAI_TRAP_CONFIG_H 1
+
+#include <stddef.h>
+#include <sai-host-intf.h>
+
+int ops_sai_trap_config_load(const char *path,
+                             struct ops_sai_trap_group_config **configs,
+                             size_t *n_configs);
+struct ops_sai_trap_group_config *
+ops_sai_trap_config_clone(const struct ops_sai_trap_group_config *);
+void ops_sai_trap_config_free(struct ops_sai_trap_group_config *);
+void ops_sai_trap_config_destroy(struct ops_sai_trap_group_config *configs,
+                                 size_t n_configs);
+
+#endif /* sai-trap-config.h */
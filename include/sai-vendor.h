@@ -11,5 +11,7 @@
 
 sai_status_t ops_sai_vendor_base_mac_get(sai_mac_t);
 sai_status_t ops_sai_vendor_config_path_get(char *, uint32_t);
+sai_status_t ops_sai_vendor_port_native_id_get(sai_object_id_t, uint32_t *);
+sai_status_t ops_sai_vendor_lag_native_id_get(sai_object_id_t, uint32_t *);
 
 #endif /* sai-vendor.h */
@@ -0,0 +1,1024 @@
+/*
+ * Copyright Mellanox Technologies, Ltd. 2001-2016.
+ * This software product is licensed under Apache version 2, as detailed in
+ * the COPYING file.
+ */
+
+#include <stdlib.h>
+
+#include <util.h>
+#include <hmap.h>
+#include <hash.h>
+#include <unixctl.h>
+#include <poll-loop.h>
+#include <dynamic-string.h>
+
+#include <sai-log.h>
+#include <sai-api-class.h>
+#include <sai-acl.h>
+
+/* Maximum number of attributes of single ACL entry. */
+#define SAI_ACL_ENTRY_ATTR_MAX (24)
+/* Priority of ingress ACL table among other ACL tables. */
+#define SAI_ACL_TABLE_PRIORITY (0)
+
+VLOG_DEFINE_THIS_MODULE(sai_acl);
+
+enum acl_rule_pending {
+    ACL_RULE_PENDING_NONE,
+    ACL_RULE_PENDING_ADD,
+    ACL_RULE_PENDING_REMOVE,
+};
+
+/*
+ * Rule in ACL table. Member rule is in one of three states: installed (one
+ * TCAM entry, 'entry'), shadowed by higher priority rule which covers its
+ * match ('shadowed_by'), or failed to install ('failed').
+ */
+struct acl_rule_hw {
+    bool member;
+    sai_object_id_t counter;
+    sai_object_id_t entry;
+    uint64_t shadowed_by;
+    bool failed;
+};
+
+struct acl_rule_entry {
+    struct hmap_node node;          /* In acl_rules, by id. */
+    uint64_t id;
+    struct ops_sai_acl_rule rule;
+    enum acl_rule_pending pending;
+    uint64_t stats_to;              /* Rule inheriting counters, or 0. */
+    struct ops_sai_acl_stats base;  /* Counters of replaced rules. */
+    struct acl_rule_hw hw;
+};
+
+static struct hmap acl_rules = HMAP_INITIALIZER(&acl_rules);
+static uint64_t acl_next_id = 1;
+static sai_object_id_t acl_table = SAI_NULL_OBJECT_ID;
+static size_t acl_n_pending = 0;
+static bool acl_tcam_freed = false;
+static uint32_t acl_prio_min = 0;
+static uint32_t acl_prio_max = 0;
+
+static sai_status_t __acl_table_create(void);
+static void __acl_table_remove(void);
+static struct acl_rule_entry *__acl_rule_find(const handle_t *);
+static struct acl_rule_entry *__acl_rule_find_by_id(uint64_t);
+static int __acl_rule_counters_read(const struct acl_rule_entry *,
+                                    struct ops_sai_acl_stats *);
+static void __acl_rule_stats_flush(const struct acl_rule_entry *);
+static uint32_t __acl_priority(uint16_t);
+static int __acl_rule_place(struct acl_rule_entry *);
+static int __acl_rule_install(struct acl_rule_entry *);
+static void __acl_rule_uninstall(struct acl_rule_entry *);
+static void __acl_rules_shadow(struct acl_rule_entry *);
+static void __acl_rules_release(uint64_t);
+static struct acl_rule_entry *__acl_rule_shadower_find(
+                                    const struct acl_rule_entry *);
+static bool __acl_rule_covers(const struct ops_sai_acl_rule *,
+                              const struct ops_sai_acl_rule *);
+static bool __acl_masked_covers(const void *, const void *, const void *,
+                                const void *, size_t);
+static uint32_t __acl_entry_attrs_fill(const struct ops_sai_acl_rule *,
+                                       sai_object_id_t, sai_attribute_t *);
+static void __acl_rule_entry_free(struct acl_rule_entry *);
+static void __acl_show(struct unixctl_conn *, int, const char *[], void *);
+
+/*
+ * Initialize ACL. Creates ingress ACL table which holds all rules. ACL is
+ * disabled if table can not be created.
+ */
+static void
+__acl_init(void)
+{
+    sai_attribute_t attr[2] = { };
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
+
+    VLOG_INFO("Initializing ACL");
+
+    hmap_init(&acl_rules);
+
+    attr[0].id = SAI_SWITCH_ATTR_ACL_ENTRY_MINIMUM_PRIORITY;
+    attr[1].id = SAI_SWITCH_ATTR_ACL_ENTRY_MAXIMUM_PRIORITY;
+    status = sai_api->switch_api->get_switch_attribute(ARRAY_SIZE(attr),
+                                                       attr);
+    SAI_ERROR_LOG_EXIT(status, "Failed to get ACL entry priority range");
+    acl_prio_min = attr[0].value.u32;
+    acl_prio_max = attr[1].value.u32;
+
+    status = __acl_table_create();
+    SAI_ERROR_LOG_EXIT(status, "Failed to create ACL table");
+
+    VLOG_INFO("Created ACL table (priority range: %u-%u)",
+              acl_prio_min, acl_prio_max);
+
+    unixctl_command_register("sai/acl/show", "", 0, 0, __acl_show, NULL);
+
+exit:
+    if (SAI_ERROR_2_ERRNO(status)) {
+        acl_table = SAI_NULL_OBJECT_ID;
+        VLOG_WARN("ACL offload is disabled");
+    }
+}
+
+static sai_status_t
+__acl_table_create(void)
+{
+    size_t i = 0;
+    uint32_t attr_count = 0;
+    sai_attribute_t table_attr[16] = { };
+    const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
+    static const sai_attr_id_t fields[] = {
+        SAI_ACL_TABLE_ATTR_FIELD_IN_PORT,
+        SAI_ACL_TABLE_ATTR_FIELD_SRC_MAC,
+        SAI_ACL_TABLE_ATTR_FIELD_DST_MAC,
+        SAI_ACL_TABLE_ATTR_FIELD_ETHER_TYPE,
+        SAI_ACL_TABLE_ATTR_FIELD_OUTER_VLAN_ID,
+        SAI_ACL_TABLE_ATTR_FIELD_SRC_IP,
+        SAI_ACL_TABLE_ATTR_FIELD_DST_IP,
+        SAI_ACL_TABLE_ATTR_FIELD_SRC_IPv6,
+        SAI_ACL_TABLE_ATTR_FIELD_DST_IPv6,
+        SAI_ACL_TABLE_ATTR_FIELD_IP_PROTOCOL,
+        SAI_ACL_TABLE_ATTR_FIELD_DSCP,
+        SAI_ACL_TABLE_ATTR_FIELD_L4_SRC_PORT,
+        SAI_ACL_TABLE_ATTR_FIELD_L4_DST_PORT,
+        SAI_ACL_TABLE_ATTR_FIELD_TCP_FLAGS,
+    };
+
+    BUILD_ASSERT(ARRAY_SIZE(fields) + 2 <= ARRAY_SIZE(table_attr));
+    ovs_assert(SAI_NULL_OBJECT_ID == acl_table);
+
+    table_attr[attr_count].id = SAI_ACL_TABLE_ATTR_STAGE;
+    table_attr[attr_count].value.s32 = SAI_ACL_STAGE_INGRESS;
+    attr_count++;
+    table_attr[attr_count].id = SAI_ACL_TABLE_ATTR_PRIORITY;
+    table_attr[attr_count].value.u32 = SAI_ACL_TABLE_PRIORITY;
+    attr_count++;
+    for (i = 0; i < ARRAY_SIZE(fields); i++) {
+        table_attr[attr_count].id = fields[i];
+        table_attr[attr_count].value.booldata = true;
+        attr_count++;
+    }
+
+    return sai_api->acl_api->create_acl_table(&acl_table, attr_count,
+                                              table_attr);
+}
+
+static void
+__acl_table_remove(void)
+{
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
+
+    if (SAI_NULL_OBJECT_ID == acl_table) {
+        return;
+    }
+
+    status = sai_api->acl_api->delete_acl_table(acl_table);
+    ERRNO_LOG(SAI_ERROR_2_ERRNO(status), "Failed to remove ACL table");
+    acl_table = SAI_NULL_OBJECT_ID;
+}
+
+/*
+ * Check whether ACL rule can be added.
+ *
+ * @param[in] rule - ACL rule.
+ *
+ * @return 0 rule can be added
+ * @return EOPNOTSUPP ACL offload is disabled
+ * @return ERANGE priority does not fit ACL priority range of the switch
+ */
+static int
+__acl_rule_check(const struct ops_sai_acl_rule *rule)
+{
+    NULL_PARAM_LOG_ABORT(rule);
+
+    if (SAI_NULL_OBJECT_ID == acl_table) {
+        return EOPNOTSUPP;
+    }
+
+    /* Compressing priorities would merge distinct ones and break order. */
+    if (rule->priority > acl_prio_max - acl_prio_min) {
+        return ERANGE;
+    }
+
+    return 0;
+}
+
+/*
+ * Add ACL rule. Rule is programmed on next commit.
+ *
+ * @param[in]  rule   - ACL rule.
+ * @param[out] handle - rule handle.
+ *
+ * @return 0 operation completed successfully
+ * @return errno operation failed
+ */
+static int
+__acl_rule_add(const struct ops_sai_acl_rule *rule, handle_t *handle)
+{
+    int err = 0;
+    struct acl_rule_entry *entry = NULL;
+
+    NULL_PARAM_LOG_ABORT(rule);
+    NULL_PARAM_LOG_ABORT(handle);
+
+    err = __acl_rule_check(rule);
+    if (err) {
+        return err;
+    }
+
+    entry = xzalloc(sizeof *entry);
+    entry->rule = *rule;
+    entry->id = acl_next_id++;
+    entry->pending = ACL_RULE_PENDING_ADD;
+    hmap_insert(&acl_rules, &entry->node, hash_uint64(entry->id));
+    acl_n_pending++;
+
+    handle->data = entry->id;
+
+    return 0;
+}
+
+/*
+ * Remove ACL rule. Rule is removed from hardware on next commit.
+ *
+ * @param[in] handle - rule handle.
+ *
+ * @return 0 operation completed successfully
+ * @return errno operation failed
+ */
+static int
+__acl_rule_remove(const handle_t *handle)
+{
+    int status = 0;
+    struct acl_rule_entry *entry = NULL, *other = NULL;
+
+    NULL_PARAM_LOG_ABORT(handle);
+
+    entry = __acl_rule_find(handle);
+    if (!entry || ACL_RULE_PENDING_REMOVE == entry->pending) {
+        status = ENOENT;
+        ERRNO_LOG_EXIT(status, "ACL rule not found (handle: %"PRIu64")",
+                       handle->data);
+    }
+
+    /* Rule was never programmed. Rules forwarding counters to it forward
+     * them further. */
+    if (ACL_RULE_PENDING_ADD == entry->pending) {
+        hmap_remove(&acl_rules, &entry->node);
+        HMAP_FOR_EACH(other, node, &acl_rules) {
+            if (other->stats_to == entry->id) {
+                other->stats_to = entry->stats_to;
+            }
+        }
+        __acl_rule_stats_flush(entry);
+        __acl_rule_entry_free(entry);
+        acl_n_pending--;
+        goto exit;
+    }
+
+    entry->pending = ACL_RULE_PENDING_REMOVE;
+    acl_n_pending++;
+
+exit:
+    return status;
+}
+
+/*
+ * Activate pending changes. SAI has no atomic table bind, so changes are
+ * applied to the ACL table in place. Added rules are installed before removed
+ * ones are freed, so a modified rule never misses from hardware.
+ */
+static void
+__acl_commit(void)
+{
+    struct acl_rule_entry *entry = NULL, *next_entry = NULL;
+
+    if (!acl_n_pending) {
+        return;
+    }
+
+    HMAP_FOR_EACH(entry, node, &acl_rules) {
+        if (ACL_RULE_PENDING_ADD != entry->pending) {
+            continue;
+        }
+
+        entry->pending = ACL_RULE_PENDING_NONE;
+        entry->hw.member = true;
+        if (!__acl_rule_place(entry)) {
+            __acl_rules_shadow(entry);
+        }
+    }
+
+    /* Flush all counters before freeing any rule, rules replaced within one
+     * commit forward counters through each other. */
+    HMAP_FOR_EACH(entry, node, &acl_rules) {
+        if (ACL_RULE_PENDING_REMOVE == entry->pending) {
+            __acl_rule_stats_flush(entry);
+        }
+    }
+
+    HMAP_FOR_EACH_SAFE(entry, next_entry, node, &acl_rules) {
+        if (ACL_RULE_PENDING_REMOVE != entry->pending) {
+            continue;
+        }
+
+        hmap_remove(&acl_rules, &entry->node);
+        __acl_rules_release(entry->id);
+        __acl_rule_entry_free(entry);
+    }
+
+    /* Retry failed rules only when TCAM space was freed since they failed,
+     * installing them again would fail the same way otherwise. */
+    if (acl_tcam_freed) {
+        acl_tcam_freed = false;
+        HMAP_FOR_EACH(entry, node, &acl_rules) {
+            if (entry->hw.failed && !__acl_rule_place(entry)) {
+                __acl_rules_shadow(entry);
+            }
+        }
+    }
+
+    acl_n_pending = 0;
+}
+
+/*
+ * Read counters of ACL rule.
+ *
+ * @param[in]  handle - rule handle.
+ * @param[out] stats  - rule counters.
+ *
+ * @return 0 operation completed successfully
+ * @return errno operation failed
+ */
+static int
+__acl_rule_stats_get(const handle_t *handle, struct ops_sai_acl_stats *stats)
+{
+    int status = 0;
+    struct acl_rule_entry *entry = NULL;
+
+    NULL_PARAM_LOG_ABORT(handle);
+    NULL_PARAM_LOG_ABORT(stats);
+
+    entry = __acl_rule_find(handle);
+    if (!entry) {
+        status = ENOENT;
+        ERRNO_LOG_EXIT(status, "ACL rule not found (handle: %"PRIu64")",
+                       handle->data);
+    }
+
+    status = __acl_rule_counters_read(entry, stats);
+
+exit:
+    return status;
+}
+
+/*
+ * Read counters of rule, including counters forwarded from replaced rules.
+ */
+static int
+__acl_rule_counters_read(const struct acl_rule_entry *entry,
+                         struct ops_sai_acl_stats *stats)
+{
+    sai_attribute_t attr[2] = { };
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
+
+    *stats = entry->base;
+    if (SAI_NULL_OBJECT_ID == entry->hw.counter) {
+        goto exit;
+    }
+
+    attr[0].id = SAI_ACL_COUNTER_ATTR_PACKETS;
+    attr[1].id = SAI_ACL_COUNTER_ATTR_BYTES;
+    status = sai_api->acl_api->get_acl_counter_attribute(entry->hw.counter,
+                                                         ARRAY_SIZE(attr),
+                                                         attr);
+    SAI_ERROR_LOG_EXIT(status, "Failed to get ACL counter "
+                       "(handle: %"PRIu64")", entry->id);
+
+    stats->packets += attr[0].value.u64;
+    stats->bytes += attr[1].value.u64;
+
+exit:
+    return SAI_ERROR_2_ERRNO(status);
+}
+
+/*
+ * De-initialize ACL. Removes remaining rules and ACL table.
+ */
+static void
+__acl_deinit(void)
+{
+    struct acl_rule_entry *entry = NULL, *next_entry = NULL;
+
+    VLOG_INFO("De-initializing ACL");
+
+    HMAP_FOR_EACH_SAFE(entry, next_entry, node, &acl_rules) {
+        hmap_remove(&acl_rules, &entry->node);
+        __acl_rule_entry_free(entry);
+    }
+    hmap_destroy(&acl_rules);
+
+    __acl_table_remove();
+    acl_n_pending = 0;
+    acl_tcam_freed = false;
+}
+
+/*
+ * Activate rules inserted and deleted since previous run, so all flow table
+ * changes of one main loop iteration are committed together.
+ */
+void
+ops_sai_acl_run(void)
+{
+    if (acl_n_pending) {
+        ops_sai_acl_commit();
+    }
+}
+
+void
+ops_sai_acl_wait(void)
+{
+    if (acl_n_pending) {
+        poll_immediate_wake();
+    }
+}
+
+/*
+ * Forward counters of rule to rule replacing it.
+ *
+ * @param[in] from - rule handle, being replaced.
+ * @param[in] to   - rule handle, replacing 'from'.
+ *
+ * @return 0 operation completed successfully
+ * @return errno operation failed
+ */
+static int
+__acl_rule_stats_forward(const handle_t *from, const handle_t *to)
+{
+    int status = 0;
+    struct acl_rule_entry *entry = NULL;
+
+    NULL_PARAM_LOG_ABORT(from);
+    NULL_PARAM_LOG_ABORT(to);
+
+    entry = __acl_rule_find(from);
+    if (!entry || !__acl_rule_find(to)) {
+        status = ENOENT;
+        ERRNO_LOG_EXIT(status, "ACL rule not found (handle: %"PRIu64")",
+                       entry ? to->data : from->data);
+    }
+
+    entry->stats_to = to->data;
+
+exit:
+    return status;
+}
+
+static struct acl_rule_entry *
+__acl_rule_find(const handle_t *handle)
+{
+    return __acl_rule_find_by_id(handle->data);
+}
+
+static struct acl_rule_entry *
+__acl_rule_find_by_id(uint64_t id)
+{
+    struct acl_rule_entry *entry = NULL;
+
+    HMAP_FOR_EACH_WITH_HASH(entry, node, hash_uint64(id), &acl_rules) {
+        if (entry->id == id) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Read counters of rule being destroyed for the last time and add them to
+ * the rule it forwards counters to. Rules being destroyed too are skipped
+ * along the forwarding chain.
+ */
+static void
+__acl_rule_stats_flush(const struct acl_rule_entry *entry)
+{
+    struct ops_sai_acl_stats stats = { };
+    struct acl_rule_entry *to = __acl_rule_find_by_id(entry->stats_to);
+
+    while (to && ACL_RULE_PENDING_REMOVE == to->pending) {
+        to = __acl_rule_find_by_id(to->stats_to);
+    }
+
+    if (!to) {
+        return;
+    }
+
+    if (!__acl_rule_counters_read(entry, &stats)) {
+        to->base.packets += stats.packets;
+        to->base.bytes += stats.bytes;
+    }
+}
+
+/*
+ * Maps OpenFlow priority to ACL entry priority range of the switch. Priority
+ * is checked to fit the range when rule is added.
+ */
+static uint32_t
+__acl_priority(uint16_t priority)
+{
+    return acl_prio_min + priority;
+}
+
+/*
+ * Either mark rule as shadowed by higher priority rule, or install it.
+ */
+static int
+__acl_rule_place(struct acl_rule_entry *entry)
+{
+    int error = 0;
+    struct acl_rule_entry *shadower = __acl_rule_shadower_find(entry);
+
+    entry->hw.failed = false;
+    entry->hw.shadowed_by = 0;
+
+    if (shadower) {
+        entry->hw.shadowed_by = shadower->id;
+        return 0;
+    }
+
+    error = __acl_rule_install(entry);
+    if (error) {
+        entry->hw.failed = true;
+    }
+
+    return error;
+}
+
+/*
+ * Program TCAM entry of rule.
+ */
+static int
+__acl_rule_install(struct acl_rule_entry *entry)
+{
+    uint32_t attr_count = 0;
+    sai_attribute_t counter_attr[3] = { };
+    sai_attribute_t attr[SAI_ACL_ENTRY_ATTR_MAX] = { };
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    struct acl_rule_hw *hw = &entry->hw;
+    const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
+
+    ovs_assert(SAI_NULL_OBJECT_ID == hw->entry);
+
+    if (SAI_NULL_OBJECT_ID == hw->counter) {
+        counter_attr[0].id = SAI_ACL_COUNTER_ATTR_TABLE_ID;
+        counter_attr[0].value.oid = acl_table;
+        counter_attr[1].id = SAI_ACL_COUNTER_ATTR_ENABLE_PACKET_COUNT;
+        counter_attr[1].value.booldata = true;
+        counter_attr[2].id = SAI_ACL_COUNTER_ATTR_ENABLE_BYTE_COUNT;
+        counter_attr[2].value.booldata = true;
+
+        status = sai_api->acl_api->create_acl_counter(&hw->counter,
+                                                      ARRAY_SIZE(counter_attr),
+                                                      counter_attr);
+        SAI_ERROR_LOG_EXIT(status, "Failed to create ACL counter "
+                           "(handle: %"PRIu64")", entry->id);
+    }
+
+    attr_count = __acl_entry_attrs_fill(&entry->rule, hw->counter, attr);
+    status = sai_api->acl_api->create_acl_entry(&hw->entry, attr_count, attr);
+    SAI_ERROR_LOG_EXIT(status, "Failed to create ACL entry "
+                       "(handle: %"PRIu64", priority: %u)",
+                       entry->id, entry->rule.priority);
+
+    VLOG_DBG("Installed ACL rule (handle: %"PRIu64", priority: %u)",
+             entry->id, entry->rule.priority);
+
+exit:
+    if (SAI_ERROR_2_ERRNO(status)) {
+        hw->entry = SAI_NULL_OBJECT_ID;
+    }
+
+    return SAI_ERROR_2_ERRNO(status);
+}
+
+/*
+ * Remove TCAM entry of rule. Counter is kept.
+ */
+static void
+__acl_rule_uninstall(struct acl_rule_entry *entry)
+{
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    struct acl_rule_hw *hw = &entry->hw;
+    const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
+
+    if (SAI_NULL_OBJECT_ID == hw->entry) {
+        return;
+    }
+
+    status = sai_api->acl_api->delete_acl_entry(hw->entry);
+    ERRNO_LOG(SAI_ERROR_2_ERRNO(status), "Failed to remove ACL entry "
+              "(handle: %"PRIu64")", entry->id);
+    hw->entry = SAI_NULL_OBJECT_ID;
+    acl_tcam_freed = true;
+}
+
+/*
+ * Release TCAM entries of lower priority rules, which are fully covered by
+ * newly installed rule.
+ */
+static void
+__acl_rules_shadow(struct acl_rule_entry *entry)
+{
+    struct acl_rule_entry *other = NULL;
+
+    HMAP_FOR_EACH(other, node, &acl_rules) {
+        if (other == entry || !other->hw.member
+            || other->hw.shadowed_by
+            || other->rule.priority >= entry->rule.priority
+            || !__acl_rule_covers(&entry->rule, &other->rule)) {
+            continue;
+        }
+
+        __acl_rule_uninstall(other);
+        other->hw.failed = false;
+        other->hw.shadowed_by = entry->id;
+        VLOG_DBG("ACL rule is shadowed (handle: %"PRIu64", by: %"PRIu64")",
+                 other->id, entry->id);
+    }
+}
+
+/*
+ * Place again rules, which were shadowed by removed rule.
+ */
+static void
+__acl_rules_release(uint64_t id)
+{
+    struct acl_rule_entry *other = NULL;
+
+    HMAP_FOR_EACH(other, node, &acl_rules) {
+        if (!other->hw.member || other->hw.shadowed_by != id) {
+            continue;
+        }
+
+        if (__acl_rule_place(other)) {
+            VLOG_WARN("Failed to install unshadowed ACL rule "
+                      "(handle: %"PRIu64")", other->id);
+            __acl_rules_release(other->id);
+        }
+    }
+}
+
+static struct acl_rule_entry *
+__acl_rule_shadower_find(const struct acl_rule_entry *entry)
+{
+    struct acl_rule_entry *other = NULL;
+
+    HMAP_FOR_EACH(other, node, &acl_rules) {
+        if (other != entry && other->hw.member && !other->hw.failed
+            && ACL_RULE_PENDING_REMOVE != other->pending
+            && other->rule.priority > entry->rule.priority
+            && __acl_rule_covers(&other->rule, &entry->rule)) {
+            return other;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Check whether every packet matched by rule 'b' is matched by rule 'a'.
+ */
+static bool
+__acl_rule_covers(const struct ops_sai_acl_rule *a,
+                  const struct ops_sai_acl_rule *b)
+{
+    uint32_t exact = OPS_SAI_ACL_FIELD_IN_PORT | OPS_SAI_ACL_FIELD_ETHER_TYPE |
+                     OPS_SAI_ACL_FIELD_VLAN_ID | OPS_SAI_ACL_FIELD_IP_PROTO |
+                     OPS_SAI_ACL_FIELD_DSCP;
+    uint32_t fields = a->fields & exact;
+
+    if ((b->fields & fields) != fields) {
+        return false;
+    }
+
+    if ((fields & OPS_SAI_ACL_FIELD_IN_PORT && a->in_port != b->in_port)
+        || (fields & OPS_SAI_ACL_FIELD_ETHER_TYPE
+            && a->ether_type != b->ether_type)
+        || (fields & OPS_SAI_ACL_FIELD_VLAN_ID && a->vlan_id != b->vlan_id)
+        || (fields & OPS_SAI_ACL_FIELD_IP_PROTO && a->ip_proto != b->ip_proto)
+        || (fields & OPS_SAI_ACL_FIELD_DSCP && a->dscp != b->dscp)) {
+        return false;
+    }
+
+#define ACL_MASKED_COVERS(FIELD, VALUE, MASK)                               \
+    (!(a->fields & (FIELD))                                                 \
+     || ((b->fields & (FIELD))                                              \
+         && __acl_masked_covers(&a->VALUE, &a->MASK, &b->VALUE, &b->MASK,   \
+                                sizeof a->VALUE)))
+
+    return ACL_MASKED_COVERS(OPS_SAI_ACL_FIELD_SRC_MAC, src_mac, src_mac_mask)
+        && ACL_MASKED_COVERS(OPS_SAI_ACL_FIELD_DST_MAC, dst_mac, dst_mac_mask)
+        && ACL_MASKED_COVERS(OPS_SAI_ACL_FIELD_SRC_IP, src_ip, src_ip_mask)
+        && ACL_MASKED_COVERS(OPS_SAI_ACL_FIELD_DST_IP, dst_ip, dst_ip_mask)
+        && ACL_MASKED_COVERS(OPS_SAI_ACL_FIELD_SRC_IPV6, src_ipv6,
+                             src_ipv6_mask)
+        && ACL_MASKED_COVERS(OPS_SAI_ACL_FIELD_DST_IPV6, dst_ipv6,
+                             dst_ipv6_mask)
+        && ACL_MASKED_COVERS(OPS_SAI_ACL_FIELD_L4_SRC, l4_src, l4_src_mask)
+        && ACL_MASKED_COVERS(OPS_SAI_ACL_FIELD_L4_DST, l4_dst, l4_dst_mask)
+        && ACL_MASKED_COVERS(OPS_SAI_ACL_FIELD_TCP_FLAGS, tcp_flags,
+                             tcp_flags_mask);
+
+#undef ACL_MASKED_COVERS
+}
+
+/*
+ * Check whether value/mask 'a' matches every value matched by 'b'.
+ */
+static bool
+__acl_masked_covers(const void *a_value_, const void *a_mask_,
+                    const void *b_value_, const void *b_mask_, size_t n)
+{
+    size_t i = 0;
+    const uint8_t *a_value = a_value_, *a_mask = a_mask_;
+    const uint8_t *b_value = b_value_, *b_mask = b_mask_;
+
+    for (i = 0; i < n; i++) {
+        if ((a_mask[i] & ~b_mask[i])
+            || ((a_value[i] ^ b_value[i]) & a_mask[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Translates ACL rule to SAI ACL entry attributes.
+ *
+ * @param[in]  rule    - ACL rule.
+ * @param[in]  counter - ACL counter of entry.
+ * @param[out] attr    - array of SAI_ACL_ENTRY_ATTR_MAX attributes.
+ *
+ * @return number of filled attributes.
+ */
+static uint32_t
+__acl_entry_attrs_fill(const struct ops_sai_acl_rule *rule,
+                       sai_object_id_t counter, sai_attribute_t *attr)
+{
+    uint32_t n = 0;
+
+    attr[n].id = SAI_ACL_ENTRY_ATTR_TABLE_ID;
+    attr[n].value.oid = acl_table;
+    n++;
+    attr[n].id = SAI_ACL_ENTRY_ATTR_PRIORITY;
+    attr[n].value.u32 = __acl_priority(rule->priority);
+    n++;
+    attr[n].id = SAI_ACL_ENTRY_ATTR_ADMIN_STATE;
+    attr[n].value.booldata = true;
+    n++;
+
+    if (rule->fields & OPS_SAI_ACL_FIELD_IN_PORT) {
+        attr[n].id = SAI_ACL_ENTRY_ATTR_FIELD_IN_PORT;
+        attr[n].value.aclfield.enable = true;
+        attr[n].value.aclfield.data.oid =
+            ops_sai_api_hw_id2port_id(rule->in_port);
+        n++;
+    }
+
+    if (rule->fields & OPS_SAI_ACL_FIELD_SRC_MAC) {
+        attr[n].id = SAI_ACL_ENTRY_ATTR_FIELD_SRC_MAC;
+        attr[n].value.aclfield.enable = true;
+        memcpy(attr[n].value.aclfield.data.mac, rule->src_mac.ea,
+               sizeof attr[n].value.aclfield.data.mac);
+        memcpy(attr[n].value.aclfield.mask.mac, rule->src_mac_mask.ea,
+               sizeof attr[n].value.aclfield.mask.mac);
+        n++;
+    }
+
+    if (rule->fields & OPS_SAI_ACL_FIELD_DST_MAC) {
+        attr[n].id = SAI_ACL_ENTRY_ATTR_FIELD_DST_MAC;
+        attr[n].value.aclfield.enable = true;
+        memcpy(attr[n].value.aclfield.data.mac, rule->dst_mac.ea,
+               sizeof attr[n].value.aclfield.data.mac);
+        memcpy(attr[n].value.aclfield.mask.mac, rule->dst_mac_mask.ea,
+               sizeof attr[n].value.aclfield.mask.mac);
+        n++;
+    }
+
+    if (rule->fields & OPS_SAI_ACL_FIELD_ETHER_TYPE) {
+        attr[n].id = SAI_ACL_ENTRY_ATTR_FIELD_ETHER_TYPE;
+        attr[n].value.aclfield.enable = true;
+        attr[n].value.aclfield.data.u16 = rule->ether_type;
+        attr[n].value.aclfield.mask.u16 = UINT16_MAX;
+        n++;
+    }
+
+    if (rule->fields & OPS_SAI_ACL_FIELD_VLAN_ID) {
+        attr[n].id = SAI_ACL_ENTRY_ATTR_FIELD_OUTER_VLAN_ID;
+        attr[n].value.aclfield.enable = true;
+        attr[n].value.aclfield.data.u16 = rule->vlan_id;
+        attr[n].value.aclfield.mask.u16 = VLAN_VID_MASK >> VLAN_VID_SHIFT;
+        n++;
+    }
+
+    if (rule->fields & OPS_SAI_ACL_FIELD_SRC_IP) {
+        attr[n].id = SAI_ACL_ENTRY_ATTR_FIELD_SRC_IP;
+        attr[n].value.aclfield.enable = true;
+        attr[n].value.aclfield.data.ip4 = htonl(rule->src_ip);
+        attr[n].value.aclfield.mask.ip4 = htonl(rule->src_ip_mask);
+        n++;
+    }
+
+    if (rule->fields & OPS_SAI_ACL_FIELD_DST_IP) {
+        attr[n].id = SAI_ACL_ENTRY_ATTR_FIELD_DST_IP;
+        attr[n].value.aclfield.enable = true;
+        attr[n].value.aclfield.data.ip4 = htonl(rule->dst_ip);
+        attr[n].value.aclfield.mask.ip4 = htonl(rule->dst_ip_mask);
+        n++;
+    }
+
+    if (rule->fields & OPS_SAI_ACL_FIELD_SRC_IPV6) {
+        attr[n].id = SAI_ACL_ENTRY_ATTR_FIELD_SRC_IPv6;
+        attr[n].value.aclfield.enable = true;
+        memcpy(attr[n].value.aclfield.data.ip6, &rule->src_ipv6,
+               sizeof attr[n].value.aclfield.data.ip6);
+        memcpy(attr[n].value.aclfield.mask.ip6, &rule->src_ipv6_mask,
+               sizeof attr[n].value.aclfield.mask.ip6);
+        n++;
+    }
+
+    if (rule->fields & OPS_SAI_ACL_FIELD_DST_IPV6) {
+        attr[n].id = SAI_ACL_ENTRY_ATTR_FIELD_DST_IPv6;
+        attr[n].value.aclfield.enable = true;
+        memcpy(attr[n].value.aclfield.data.ip6, &rule->dst_ipv6,
+               sizeof attr[n].value.aclfield.data.ip6);
+        memcpy(attr[n].value.aclfield.mask.ip6, &rule->dst_ipv6_mask,
+               sizeof attr[n].value.aclfield.mask.ip6);
+        n++;
+    }
+
+    if (rule->fields & OPS_SAI_ACL_FIELD_IP_PROTO) {
+        attr[n].id = SAI_ACL_ENTRY_ATTR_FIELD_IP_PROTOCOL;
+        attr[n].value.aclfield.enable = true;
+        attr[n].value.aclfield.data.u8 = rule->ip_proto;
+        attr[n].value.aclfield.mask.u8 = UINT8_MAX;
+        n++;
+    }
+
+    if (rule->fields & OPS_SAI_ACL_FIELD_DSCP) {
+        attr[n].id = SAI_ACL_ENTRY_ATTR_FIELD_DSCP;
+        attr[n].value.aclfield.enable = true;
+        attr[n].value.aclfield.data.u8 = rule->dscp;
+        attr[n].value.aclfield.mask.u8 = IP_DSCP_MASK >> 2;
+        n++;
+    }
+
+    if (rule->fields & OPS_SAI_ACL_FIELD_L4_SRC) {
+        attr[n].id = SAI_ACL_ENTRY_ATTR_FIELD_L4_SRC_PORT;
+        attr[n].value.aclfield.enable = true;
+        attr[n].value.aclfield.data.u16 = rule->l4_src;
+        attr[n].value.aclfield.mask.u16 = rule->l4_src_mask;
+        n++;
+    }
+
+    if (rule->fields & OPS_SAI_ACL_FIELD_L4_DST) {
+        attr[n].id = SAI_ACL_ENTRY_ATTR_FIELD_L4_DST_PORT;
+        attr[n].value.aclfield.enable = true;
+        attr[n].value.aclfield.data.u16 = rule->l4_dst;
+        attr[n].value.aclfield.mask.u16 = rule->l4_dst_mask;
+        n++;
+    }
+
+    if (rule->fields & OPS_SAI_ACL_FIELD_TCP_FLAGS) {
+        attr[n].id = SAI_ACL_ENTRY_ATTR_FIELD_TCP_FLAGS;
+        attr[n].value.aclfield.enable = true;
+        attr[n].value.aclfield.data.u8 = rule->tcp_flags;
+        attr[n].value.aclfield.mask.u8 = rule->tcp_flags_mask;
+        n++;
+    }
+
+    switch (rule->action) {
+    case OPS_SAI_ACL_ACTION_DROP:
+        attr[n].id = SAI_ACL_ENTRY_ATTR_PACKET_ACTION;
+        attr[n].value.aclaction.enable = true;
+        attr[n].value.aclaction.parameter.s32 = SAI_PACKET_ACTION_DROP;
+        n++;
+        break;
+    case OPS_SAI_ACL_ACTION_FORWARD:
+        attr[n].id = SAI_ACL_ENTRY_ATTR_PACKET_ACTION;
+        attr[n].value.aclaction.enable = true;
+        attr[n].value.aclaction.parameter.s32 = SAI_PACKET_ACTION_FORWARD;
+        n++;
+        break;
+    case OPS_SAI_ACL_ACTION_TRAP:
+        attr[n].id = SAI_ACL_ENTRY_ATTR_PACKET_ACTION;
+        attr[n].value.aclaction.enable = true;
+        attr[n].value.aclaction.parameter.s32 = SAI_PACKET_ACTION_TRAP;
+        n++;
+        break;
+    case OPS_SAI_ACL_ACTION_REDIRECT:
+        attr[n].id = SAI_ACL_ENTRY_ATTR_ACTION_REDIRECT;
+        attr[n].value.aclaction.enable = true;
+        attr[n].value.aclaction.parameter.oid =
+            ops_sai_api_hw_id2port_id(rule->redirect_port);
+        n++;
+        break;
+    default:
+        ovs_assert(false);
+    }
+
+    attr[n].id = SAI_ACL_ENTRY_ATTR_ACTION_COUNTER;
+    attr[n].value.aclaction.enable = true;
+    attr[n].value.aclaction.parameter.oid = counter;
+    n++;
+
+    ovs_assert(n <= SAI_ACL_ENTRY_ATTR_MAX);
+
+    return n;
+}
+
+/*
+ * Remove TCAM entry and counter of rule and free it.
+ */
+static void
+__acl_rule_entry_free(struct acl_rule_entry *entry)
+{
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
+
+    __acl_rule_uninstall(entry);
+
+    if (SAI_NULL_OBJECT_ID != entry->hw.counter) {
+        status = sai_api->acl_api->delete_acl_counter(entry->hw.counter);
+        ERRNO_LOG(SAI_ERROR_2_ERRNO(status), "Failed to remove ACL counter "
+                  "(handle: %"PRIu64")", entry->id);
+    }
+
+    free(entry);
+}
+
+/*
+ * appctl sai/acl/show: show TCAM usage of ACL rules.
+ */
+static void
+__acl_show(struct unixctl_conn *conn, int argc OVS_UNUSED,
+           const char *argv[] OVS_UNUSED, void *aux OVS_UNUSED)
+{
+    size_t n_rules = 0;
+    size_t n_entries = 0;
+    size_t n_shadowed = 0;
+    struct ds ds = DS_EMPTY_INITIALIZER;
+    struct acl_rule_entry *entry = NULL;
+    const struct acl_rule_hw *hw = NULL;
+
+    ds_put_format(&ds, "%-10s %8s %12s  %s\n", "Handle", "Priority",
+                  "TCAM entries", "State");
+
+    HMAP_FOR_EACH(entry, node, &acl_rules) {
+        hw = &entry->hw;
+        if (!hw->member) {
+            continue;
+        }
+
+        ds_put_format(&ds, "%-10"PRIu64" %8u %12d  ",
+                      entry->id, entry->rule.priority,
+                      SAI_NULL_OBJECT_ID != hw->entry);
+        if (hw->shadowed_by) {
+            ds_put_format(&ds, "shadowed by %"PRIu64"\n", hw->shadowed_by);
+            n_shadowed++;
+        } else if (hw->failed) {
+            ds_put_cstr(&ds, "failed\n");
+        } else {
+            ds_put_cstr(&ds, "installed\n");
+        }
+        n_rules++;
+        n_entries += SAI_NULL_OBJECT_ID != hw->entry;
+    }
+
+    ds_put_format(&ds, "\nRules: %"PRIuSIZE", shadowed: %"PRIuSIZE", "
+                  "TCAM entries: %"PRIuSIZE"\n", n_rules, n_shadowed,
+                  n_entries);
+    ds_put_format(&ds, "Pending changes: %"PRIuSIZE"\n", acl_n_pending);
+
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
+}
+
+DEFINE_GENERIC_CLASS(struct acl_class, acl) = {
+    .init = __acl_init,
+    .rule_check = __acl_rule_check,
+    .rule_add = __acl_rule_add,
+    .rule_remove = __acl_rule_remove,
+    .commit = __acl_commit,
+    .rule_stats_get = __acl_rule_stats_get,
+    .rule_stats_forward = __acl_rule_stats_forward,
+    .deinit = __acl_deinit
+};
+
+DEFINE_GENERIC_CLASS_GETTER(struct acl_class, acl);
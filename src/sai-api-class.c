@@ -6,20 +6,65 @@
 
 #include <malloc.h>
 #include <string.h>
+#include <stdio.h>
+#include <unistd.h>
 #include <sai-api-class.h>
 #include <sai-log.h>
-#include <sai-netdev.h>
 #include <util.h>
+#include <hash.h>
+#include <packets.h>
+#include <timeval.h>
+#include <ovs-thread.h>
+#include <dynamic-string.h>
 #include <sai-vendor.h>
 #include <sai-common.h>
+#include <sai-event.h>
+#include <sai-rx.h>
+
+#ifndef SAI_PLATFORM_CACHE_FILE_PATH
+#define SAI_PLATFORM_CACHE_FILE_PATH "/var/run/openswitch/sai-platform.cache"
+#endif
+
+/* Maximum number of threads used to discover ports. */
+#define SAI_INIT_PORTS_THREADS_MAX (4)
 
 VLOG_DEFINE_THIS_MODULE(sai_api_class);
 
+enum sai_boot_phase {
+    SAI_BOOT_PHASE_PLATFORM,
+    SAI_BOOT_PHASE_API,
+    SAI_BOOT_PHASE_SWITCH,
+    SAI_BOOT_PHASE_PORTS,
+    SAI_BOOT_PHASE_MAX,
+};
+
+static const char *sai_boot_phase_names[SAI_BOOT_PHASE_MAX] = {
+    [SAI_BOOT_PHASE_PLATFORM] = "platform identity",
+    [SAI_BOOT_PHASE_API] = "api query",
+    [SAI_BOOT_PHASE_SWITCH] = "switch init",
+    [SAI_BOOT_PHASE_PORTS] = "port discovery",
+};
+
+struct init_ports_worker {
+    sai_object_id_t *oids;
+    struct ops_sai_port_entry *ports;
+    sai_status_t *statuses;
+    uint32_t count;
+    uint32_t first;
+    uint32_t step;
+};
+
 static struct ops_sai_api_class sai_api;
-static sai_object_id_t sai_lable_id_to_oid_map[SAI_PORTS_MAX];
+/* Port table indexed both by label ID and by port object ID. Holds physical
+ * ports and LAGs, sai_lag_port_count of them are LAGs. */
+static struct hmap sai_port_hw_id_map = HMAP_INITIALIZER(&sai_port_hw_id_map);
+static struct hmap sai_port_oid_map = HMAP_INITIALIZER(&sai_port_oid_map);
+static size_t sai_lag_port_count = 0;
 static struct eth_addr sai_api_mac;
 static char sai_api_mac_str[MAC_STR_LEN + 1];
 static char sai_config_file_path[PATH_MAX] = { };
+static long long int sai_boot_phase_msec[SAI_BOOT_PHASE_MAX];
+static bool sai_platform_cached = false;
 
 static const char *__profile_get_value(sai_switch_profile_id_t, const char *);
 static int __profile_get_next_value(sai_switch_profile_id_t, const char **,
@@ -32,8 +77,17 @@ static void __event_port(uint32_t, sai_port_event_notification_t *);
 static void __event_switch_shutdown(void);
 static void __event_rx_packet(const void *, sai_size_t, uint32_t,
                                 const sai_attribute_t *);
-static sai_status_t __get_port_lable_id(sai_object_id_t, uint32_t *);
+static sai_status_t __get_port_lanes(sai_object_id_t,
+                                     struct ops_sai_port_entry *);
 static sai_status_t __init_ports(void);
+static void *__init_ports_worker(void *);
+static void __deinit_ports(void);
+static sai_status_t __platform_identity_get(void);
+static int __platform_cache_load(void);
+static void __platform_cache_store(void);
+static void *__base_mac_worker(void *);
+static void __boot_phase_done(enum sai_boot_phase, long long int *);
+static void __boot_timing_log(void);
 
 /**
  * Initialize SAI api. Register callbacks, query APIs.
@@ -42,6 +96,7 @@ void
 ops_sai_api_init(void)
 {
     sai_status_t status = SAI_STATUS_SUCCESS;
+    long long int phase_start = time_msec();
 
     static const service_method_table_t sai_services = {
         __profile_get_value,
@@ -63,16 +118,13 @@ ops_sai_api_init(void)
         SAI_ERROR_LOG_EXIT(status, "SAI api already initialized");
     }
 
-    status = ops_sai_vendor_base_mac_get(sai_api_mac.ea);
-    SAI_ERROR_LOG_EXIT(status, "Failed to get base MAC address");
+    status = __platform_identity_get();
+    SAI_ERROR_LOG_EXIT(status, "Failed to get platform identity");
     sprintf(sai_api_mac_str, "%02hhx:%02hhx:%02hhx:%02hhx:%02hhx:%02hhx",
             sai_api_mac.ea[0], sai_api_mac.ea[1],
             sai_api_mac.ea[2], sai_api_mac.ea[3],
             sai_api_mac.ea[4], sai_api_mac.ea[5]);
-
-    status = ops_sai_vendor_config_path_get(sai_config_file_path,
-                                            sizeof(sai_config_file_path));
-    SAI_ERROR_LOG_EXIT(status, "Failed to get config file path");
+    __boot_phase_done(SAI_BOOT_PHASE_PLATFORM, &phase_start);
 
     status = sai_api_initialize(0, &sai_services);
     SAI_ERROR_LOG_EXIT(status, "Failed to initialize SAI api");
@@ -98,13 +150,38 @@ ops_sai_api_init(void)
                            (void **) &sai_api.hash_api);
     SAI_ERROR_LOG_EXIT(status, "Failed to initialize SAI hash api");
 
+    status = sai_api_query(SAI_API_ACL,
+                           (void **) &sai_api.acl_api);
+    SAI_ERROR_LOG_EXIT(status, "Failed to initialize SAI ACL api");
+
+    status = sai_api_query(SAI_API_LAG,
+                           (void **) &sai_api.lag_api);
+    SAI_ERROR_LOG_EXIT(status, "Failed to initialize SAI LAG api");
+
+    /* Packet sampling is optional, sFlow fails to enable without it. */
+    status = sai_api_query(SAI_API_SAMPLEPACKET,
+                           (void **) &sai_api.samplepacket_api);
+    if (SAI_STATUS_SUCCESS != status) {
+        VLOG_WARN("SAI sample packet api is not available (status: %d)",
+                  status);
+        sai_api.samplepacket_api = NULL;
+        status = SAI_STATUS_SUCCESS;
+    }
+    __boot_phase_done(SAI_BOOT_PHASE_API, &phase_start);
+
+    ops_sai_event_init();
+    ops_sai_rx_init();
+
     status = sai_api.switch_api->initialize_switch(1, "SX", "/", &sai_events);
     SAI_ERROR_LOG_EXIT(status, "Failed to initialize switch");
+    __boot_phase_done(SAI_BOOT_PHASE_SWITCH, &phase_start);
 
     status = __init_ports();
     SAI_ERROR_LOG_EXIT(status, "Failed to create interfaces");
+    __boot_phase_done(SAI_BOOT_PHASE_PORTS, &phase_start);
 
     sai_api.initialized = true;
+    __boot_timing_log();
 
 exit:
     if (SAI_ERROR_2_ERRNO(status)) {
@@ -123,9 +200,13 @@ ops_sai_api_uninit(void)
     SAI_API_TRACE_FN();
 
     sai_api.initialized = false;
+    __deinit_ports();
     status = sai_api_uninitialize();
     SAI_ERROR_LOG_EXIT(status, "Failed to uninitialize SAI api");
 
+    ops_sai_rx_deinit();
+    ops_sai_event_deinit();
+
 exit:
     return SAI_ERROR_2_ERRNO(status);
 }
@@ -143,12 +224,168 @@ ops_sai_api_get_instance(void)
 
 /**
  * Convert port label ID to sai_object_id_t.
- * @return sai_object_id_t of requested port.
+ * @return sai_object_id_t of requested port, SAI_NULL_OBJECT_ID if port
+ * does not exist.
  */
 sai_object_id_t
 ops_sai_api_hw_id2port_id(uint32_t hw_id)
 {
-    return sai_lable_id_to_oid_map[hw_id];
+    const struct ops_sai_port_entry *port = ops_sai_api_port_get(hw_id);
+
+    return port ? port->oid : SAI_NULL_OBJECT_ID;
+}
+
+/**
+ * Convert sai_object_id_t to port label ID.
+ * @param[in] oid - port object ID.
+ * @param[out] hw_id - port label ID.
+ * @return 0 operation completed successfully
+ * @return errno operation failed
+ */
+int
+ops_sai_api_port_id2hw_id(sai_object_id_t oid, uint32_t *hw_id)
+{
+    const struct ops_sai_port_entry *port = ops_sai_api_port_get_by_oid(oid);
+
+    NULL_PARAM_LOG_ABORT(hw_id);
+
+    if (NULL == port) {
+        return ENOENT;
+    }
+
+    *hw_id = port->hw_id;
+
+    return 0;
+}
+
+/**
+ * Get vendor specific port ID cached on initialization.
+ * @param[in] hw_id - port label ID.
+ * @param[out] native_id - vendor port ID.
+ * @return 0 operation completed successfully
+ * @return errno operation failed
+ */
+int
+ops_sai_api_hw_id2native_id(uint32_t hw_id, uint32_t *native_id)
+{
+    const struct ops_sai_port_entry *port = ops_sai_api_port_get(hw_id);
+
+    NULL_PARAM_LOG_ABORT(native_id);
+
+    if (NULL == port) {
+        return ENOENT;
+    }
+
+    *native_id = port->native_id;
+
+    return 0;
+}
+
+/**
+ * Find port by label ID.
+ * @param[in] hw_id - port label ID.
+ * @return pointer to port entry, NULL if port does not exist.
+ */
+const struct ops_sai_port_entry *
+ops_sai_api_port_get(uint32_t hw_id)
+{
+    struct ops_sai_port_entry *port = NULL;
+
+    HMAP_FOR_EACH_WITH_HASH(port, hw_id_node, hash_int(hw_id, 0),
+                            &sai_port_hw_id_map) {
+        if (port->hw_id == hw_id) {
+            return port;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Find port by port object ID.
+ * @param[in] oid - port object ID.
+ * @return pointer to port entry, NULL if port does not exist.
+ */
+const struct ops_sai_port_entry *
+ops_sai_api_port_get_by_oid(sai_object_id_t oid)
+{
+    struct ops_sai_port_entry *port = NULL;
+
+    HMAP_FOR_EACH_WITH_HASH(port, oid_node, hash_uint64(oid),
+                            &sai_port_oid_map) {
+        if (port->oid == oid) {
+            return port;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Get number of physical ports.
+ * @return number of ports in port table, LAGs are not counted.
+ */
+size_t
+ops_sai_api_port_count(void)
+{
+    return hmap_count(&sai_port_hw_id_map) - sai_lag_port_count;
+}
+
+/**
+ * Add LAG to port table, so it can be addressed by label ID like a port.
+ * @param[in] hw_id - LAG label ID.
+ * @param[in] oid - LAG object ID.
+ * @return 0 operation completed successfully
+ * @return errno operation failed
+ */
+int
+ops_sai_api_lag_port_add(uint32_t hw_id, sai_object_id_t oid)
+{
+    struct ops_sai_port_entry *port = NULL;
+    sai_status_t status = SAI_STATUS_SUCCESS;
+
+    if (ops_sai_api_port_get(hw_id)) {
+        status = SAI_STATUS_ITEM_ALREADY_EXISTS;
+        SAI_ERROR_LOG_EXIT(status, "Duplicate port label id (label: %u)",
+                           hw_id);
+    }
+
+    port = xzalloc(sizeof *port);
+    port->hw_id = hw_id;
+    port->oid = oid;
+
+    status = ops_sai_vendor_lag_native_id_get(oid, &port->native_id);
+    if (SAI_ERROR_2_ERRNO(status)) {
+        free(port);
+        goto exit;
+    }
+
+    hmap_insert(&sai_port_hw_id_map, &port->hw_id_node, hash_int(hw_id, 0));
+    hmap_insert(&sai_port_oid_map, &port->oid_node, hash_uint64(oid));
+    sai_lag_port_count++;
+
+exit:
+    return SAI_ERROR_2_ERRNO(status);
+}
+
+/**
+ * Remove LAG from port table.
+ * @param[in] hw_id - LAG label ID.
+ */
+void
+ops_sai_api_lag_port_del(uint32_t hw_id)
+{
+    struct ops_sai_port_entry *port =
+        CONST_CAST(struct ops_sai_port_entry *, ops_sai_api_port_get(hw_id));
+
+    if (NULL == port) {
+        return;
+    }
+
+    hmap_remove(&sai_port_hw_id_map, &port->hw_id_node);
+    hmap_remove(&sai_port_oid_map, &port->oid_node);
+    free(port);
+    sai_lag_port_count--;
 }
 
 /**
@@ -204,7 +441,13 @@ __profile_get_next_value(sai_switch_profile_id_t profile_id,
 static void
 __event_switch_state_changed(sai_switch_oper_status_t switch_oper_status)
 {
+    struct ops_sai_event event = { };
+
     SAI_API_TRACE_FN();
+
+    event.type = OPS_SAI_EVENT_SWITCH_STATE;
+    event.switch_state = switch_oper_status;
+    ops_sai_event_push(&event);
 }
 
 /*
@@ -218,21 +461,24 @@ __event_fdb(uint32_t count, sai_fdb_event_notification_data_t * data)
 
 /*
  * Function will be called by SAI when port state changes.
+ * Runs in SAI thread context, so only posts events for main loop.
  */
 static void
 __event_port_state(uint32_t count,
                    sai_port_oper_status_notification_t * data)
 {
     uint32_t i = 0;
+    struct ops_sai_event event = { };
 
     SAI_API_TRACE_FN();
 
     NULL_PARAM_LOG_ABORT(data);
 
+    event.type = OPS_SAI_EVENT_PORT_STATE;
     for (i = 0; i < count; i++) {
-        netdev_sai_port_oper_state_changed(data[i].port_id,
-                                           SAI_PORT_OPER_STATUS_UP ==
-                                           data[i].port_state);
+        event.port_state.oid = data[i].port_id;
+        event.port_state.up = SAI_PORT_OPER_STATUS_UP == data[i].port_state;
+        ops_sai_event_push(&event);
     }
 }
 
@@ -251,36 +497,52 @@ __event_port(uint32_t count, sai_port_event_notification_t * data)
 static void
 __event_switch_shutdown(void)
 {
+    struct ops_sai_event event = { };
+
     SAI_API_TRACE_FN();
+
+    event.type = OPS_SAI_EVENT_SWITCH_SHUTDOWN;
+    ops_sai_event_push(&event);
 }
 
 /*
- * Function will be called by SAI on rx packet.
+ * Function will be called by SAI on rx packet. Packet is queued to receive
+ * engine and handed to consumers from main loop.
  */
 static void
 __event_rx_packet(const void *buffer, sai_size_t buffer_size,
                   uint32_t attr_count, const sai_attribute_t * attr_list)
 {
-    SAI_API_TRACE_FN();
+    ops_sai_rx_packet_post(buffer, buffer_size, attr_count, attr_list);
 }
 
 /*
- * Get port label ID bi sai_object_id_t.
+ * Read port HW lane list and derive port label ID from it. Lanes are not
+ * shared between ports, so label is first lane plus one, which stays unique
+ * when ports of different width are mixed by breakout.
  */
 static sai_status_t
-__get_port_lable_id(sai_object_id_t oid, uint32_t *label_id)
+__get_port_lanes(sai_object_id_t oid, struct ops_sai_port_entry *port)
 {
     sai_attribute_t attr;
-    uint32_t hw_lanes[SAI_MAX_LANES];
+    uint32_t lanes_size = SAI_MAX_LANES;
+    uint32_t *lanes = xcalloc(lanes_size, sizeof *lanes);
     sai_status_t status = SAI_STATUS_SUCCESS;
 
-    NULL_PARAM_LOG_ABORT(label_id);
+    NULL_PARAM_LOG_ABORT(port);
 
     attr.id = SAI_PORT_ATTR_HW_LANE_LIST;
-    attr.value.u32list.count = SAI_MAX_LANES;
-    attr.value.u32list.list = hw_lanes;
+    attr.value.u32list.count = lanes_size;
+    attr.value.u32list.list = lanes;
 
     status = sai_api.port_api->get_port_attribute(oid, 1, &attr);
+    if (SAI_STATUS_BUFFER_OVERFLOW == status
+        && attr.value.u32list.count > lanes_size) {
+        lanes_size = attr.value.u32list.count;
+        lanes = xrealloc(lanes, lanes_size * sizeof *lanes);
+        attr.value.u32list.list = lanes;
+        status = sai_api.port_api->get_port_attribute(oid, 1, &attr);
+    }
     SAI_ERROR_LOG_EXIT(status, "Failed to get port HW lane list (port: %lu)",
                        oid);
 
@@ -289,48 +551,295 @@ __get_port_lable_id(sai_object_id_t oid, uint32_t *label_id)
         goto exit;
     }
 
-    *label_id = (hw_lanes[0] / attr.value.u32list.count) + 1;
-    VLOG_DBG("Port label id: %u", *label_id);
+    port->oid = oid;
+    port->lanes = lanes;
+    port->lane_count = attr.value.u32list.count;
+    port->hw_id = lanes[0] + 1;
+    lanes = NULL;
+    VLOG_DBG("Port label id: %u", port->hw_id);
 
 exit:
+    free(lanes);
     return status;
 }
 
 /*
- * Initialize physical ports list.
+ * Initialize physical ports table. Port attributes are read by several
+ * threads in parallel, table itself is filled from the calling thread.
  */
 static sai_status_t
 __init_ports(void)
 {
-    uint32_t label_id = 0;
+    uint32_t i = 0;
+    uint32_t n_threads = 0;
     sai_uint32_t port_number = 0;
     sai_attribute_t switch_attrib = { };
+    sai_object_id_t *sai_oids = NULL;
+    sai_status_t *statuses = NULL;
+    struct ops_sai_port_entry *ports = NULL;
+    struct ops_sai_port_entry *port = NULL;
+    struct init_ports_worker workers[SAI_INIT_PORTS_THREADS_MAX] = { };
+    pthread_t threads[SAI_INIT_PORTS_THREADS_MAX];
     sai_status_t status = SAI_STATUS_SUCCESS;
-    static sai_object_id_t sai_oids[SAI_PORTS_MAX];
 
     switch_attrib.id = SAI_SWITCH_ATTR_PORT_NUMBER;
     status = sai_api.switch_api->get_switch_attribute(1, &switch_attrib);
     SAI_ERROR_LOG_EXIT(status, "Failed to get switch port number");
 
     port_number = switch_attrib.value.u32;
+    sai_oids = xcalloc(port_number, sizeof *sai_oids);
+
     switch_attrib.id = SAI_SWITCH_ATTR_PORT_LIST;
     switch_attrib.value.objlist.count = port_number;
     switch_attrib.value.objlist.list = sai_oids;
     status = sai_api.switch_api->get_switch_attribute(1, &switch_attrib);
     SAI_ERROR_LOG_EXIT(status, "Failed to get switch port list");
 
-    for (int i = 0; i < port_number; ++i) {
-        status = __get_port_lable_id(sai_oids[i], &label_id);
-        SAI_ERROR_LOG_EXIT(status, "Failed to get switch port list");
+    port_number = switch_attrib.value.objlist.count;
+    ports = xcalloc(port_number, sizeof *ports);
+    statuses = xcalloc(port_number, sizeof *statuses);
+
+    n_threads = MIN(port_number, SAI_INIT_PORTS_THREADS_MAX);
+    for (i = 0; i < n_threads; i++) {
+        workers[i].oids = sai_oids;
+        workers[i].ports = ports;
+        workers[i].statuses = statuses;
+        workers[i].count = port_number;
+        workers[i].first = i;
+        workers[i].step = n_threads;
+        threads[i] = ovs_thread_create("sai_init_ports", __init_ports_worker,
+                                       &workers[i]);
+    }
+
+    for (i = 0; i < n_threads; i++) {
+        xpthread_join(threads[i], NULL);
+    }
+
+    for (i = 0; i < port_number; ++i) {
+        status = statuses[i];
+        SAI_ERROR_LOG_EXIT(status, "Failed to get port info (port: %lu)",
+                           sai_oids[i]);
+
+        ovs_assert(!ops_sai_api_port_get(ports[i].hw_id));
+
+        port = xmemdup(&ports[i], sizeof ports[i]);
+        ports[i].lanes = NULL;
+        hmap_insert(&sai_port_hw_id_map, &port->hw_id_node,
+                    hash_int(port->hw_id, 0));
+        hmap_insert(&sai_port_oid_map, &port->oid_node,
+                    hash_uint64(port->oid));
+    }
+
+    VLOG_INFO("Initialized %"PRIuSIZE" ports using %u threads",
+              ops_sai_api_port_count(), n_threads);
+
+exit:
+    for (i = 0; ports && i < port_number; i++) {
+        free(ports[i].lanes);
+    }
+    free(ports);
+    free(statuses);
+    free(sai_oids);
+    return status;
+}
+
+/*
+ * Read lanes and vendor ID of every 'step'-th port starting from 'first'.
+ */
+static void *
+__init_ports_worker(void *arg)
+{
+    uint32_t i = 0;
+    struct init_ports_worker *worker = arg;
 
-        if (label_id > port_number) {
-            status = SAI_STATUS_BUFFER_OVERFLOW;
-            SAI_ERROR_LOG_EXIT(status, "label_id is too large");
+    for (i = worker->first; i < worker->count; i += worker->step) {
+        worker->statuses[i] = __get_port_lanes(worker->oids[i],
+                                               &worker->ports[i]);
+        if (SAI_ERROR_2_ERRNO(worker->statuses[i])) {
+            continue;
         }
 
-        sai_lable_id_to_oid_map[label_id] = sai_oids[i];
+        worker->statuses[i] =
+            ops_sai_vendor_port_native_id_get(worker->ports[i].oid,
+                                              &worker->ports[i].native_id);
     }
 
+    return NULL;
+}
+
+/*
+ * Release physical ports table.
+ */
+static void
+__deinit_ports(void)
+{
+    struct ops_sai_port_entry *port = NULL, *next_port = NULL;
+
+    HMAP_FOR_EACH_SAFE(port, next_port, hw_id_node, &sai_port_hw_id_map) {
+        hmap_remove(&sai_port_hw_id_map, &port->hw_id_node);
+        hmap_remove(&sai_port_oid_map, &port->oid_node);
+        free(port->lanes);
+        free(port);
+    }
+    sai_lag_port_count = 0;
+}
+
+/*
+ * Get base MAC address and SAI config file path. Values are taken from
+ * cache file when available, otherwise are read from hardware in parallel
+ * and stored to cache file for next start.
+ */
+static sai_status_t
+__platform_identity_get(void)
+{
+    pthread_t mac_thread;
+    sai_status_t mac_status = SAI_STATUS_SUCCESS;
+    sai_status_t status = SAI_STATUS_SUCCESS;
+
+    if (!__platform_cache_load()) {
+        sai_platform_cached = true;
+        goto exit;
+    }
+
+    mac_thread = ovs_thread_create("sai_base_mac", __base_mac_worker,
+                                   &mac_status);
+
+    status = ops_sai_vendor_config_path_get(sai_config_file_path,
+                                            sizeof(sai_config_file_path));
+    xpthread_join(mac_thread, NULL);
+    SAI_ERROR_LOG_EXIT(status, "Failed to get config file path");
+
+    status = mac_status;
+    SAI_ERROR_LOG_EXIT(status, "Failed to get base MAC address");
+
+    __platform_cache_store();
+
 exit:
     return status;
 }
+
+static void *
+__base_mac_worker(void *arg)
+{
+    sai_status_t *status = arg;
+
+    *status = ops_sai_vendor_base_mac_get(sai_api_mac.ea);
+
+    return NULL;
+}
+
+/*
+ * Read platform identity from cache file.
+ *
+ * @return 0 if cache is valid, errno otherwise.
+ */
+static int
+__platform_cache_load(void)
+{
+    int status = 0;
+    FILE *file = NULL;
+    bool mac_found = false;
+    bool path_found = false;
+    char line[PATH_MAX + 32] = { };
+    struct eth_addr mac = { };
+
+    file = fopen(SAI_PLATFORM_CACHE_FILE_PATH, "r");
+    if (NULL == file) {
+        status = errno;
+        goto exit;
+    }
+
+    while (fgets(line, sizeof line, file)) {
+        line[strcspn(line, "\n")] = '\0';
+
+        if (ovs_scan(line, "base_mac="ETH_ADDR_SCAN_FMT,
+                     ETH_ADDR_SCAN_ARGS(mac))) {
+            mac_found = true;
+        } else if (!strncmp(line, "config_path=", strlen("config_path="))) {
+            ovs_strlcpy(sai_config_file_path, line + strlen("config_path="),
+                        sizeof(sai_config_file_path));
+            path_found = true;
+        }
+    }
+
+    if (!mac_found || !path_found || eth_addr_is_zero(mac)
+        || eth_addr_is_multicast(mac)
+        || access(sai_config_file_path, R_OK)) {
+        VLOG_WARN("Ignoring invalid platform cache (file: %s)",
+                  SAI_PLATFORM_CACHE_FILE_PATH);
+        status = EINVAL;
+        goto exit;
+    }
+
+    sai_api_mac = mac;
+    VLOG_INFO("Using cached platform identity (config: %s)",
+              sai_config_file_path);
+
+exit:
+    if (file) {
+        fclose(file);
+    }
+    return status;
+}
+
+/*
+ * Write platform identity to cache file. Failure is not fatal.
+ */
+static void
+__platform_cache_store(void)
+{
+    FILE *file = NULL;
+    char tmp_path[PATH_MAX] = { };
+
+    snprintf(tmp_path, sizeof tmp_path, "%s.tmp",
+             SAI_PLATFORM_CACHE_FILE_PATH);
+
+    file = fopen(tmp_path, "w");
+    if (NULL == file) {
+        VLOG_WARN("Failed to create platform cache (file: %s, error: %s)",
+                  tmp_path, ovs_strerror(errno));
+        return;
+    }
+
+    fprintf(file, "base_mac="ETH_ADDR_FMT"\nconfig_path=%s\n",
+            ETH_ADDR_ARGS(sai_api_mac), sai_config_file_path);
+
+    if (fclose(file) || rename(tmp_path, SAI_PLATFORM_CACHE_FILE_PATH)) {
+        VLOG_WARN("Failed to store platform cache (file: %s, error: %s)",
+                  SAI_PLATFORM_CACHE_FILE_PATH, ovs_strerror(errno));
+        unlink(tmp_path);
+    }
+}
+
+/*
+ * Account time spent in boot phase and start next one.
+ */
+static void
+__boot_phase_done(enum sai_boot_phase phase, long long int *phase_start)
+{
+    long long int now = time_msec();
+
+    sai_boot_phase_msec[phase] = now - *phase_start;
+    *phase_start = now;
+}
+
+/*
+ * Print boot time breakdown.
+ */
+static void
+__boot_timing_log(void)
+{
+    int i = 0;
+    long long int total = 0;
+    struct ds ds = DS_EMPTY_INITIALIZER;
+
+    for (i = 0; i < SAI_BOOT_PHASE_MAX; i++) {
+        ds_put_format(&ds, "%s%s: %lld ms", i ? ", " : "",
+                      sai_boot_phase_names[i], sai_boot_phase_msec[i]);
+        total += sai_boot_phase_msec[i];
+    }
+
+    VLOG_INFO("SAI boot time %lld ms (%s%s)", total, ds_cstr(&ds),
+              sai_platform_cached ? ", platform identity cached" : "");
+    ds_destroy(&ds);
+}
@@ -0,0 +1,209 @@
+/*
+ * Copyright Mellanox Technologies, Ltd. 2001-2016.
+ * This software product is licensed under Apache version 2, as detailed in
+ * the COPYING file.
+ */
+
+#include <hmap.h>
+#include <hash.h>
+#include <seq.h>
+#include <connectivity.h>
+
+#include <sai-log.h>
+#include <sai-api-class.h>
+#include <sai-lag.h>
+#include <sai-ring.h>
+#include <sai-event.h>
+#include <sai-netdev.h>
+
+/* Must be power of 2. */
+#define SAI_EVENT_RING_SIZE   (4096)
+/* Maximum number of events handled in single main loop iteration. */
+#define SAI_EVENT_BATCH_MAX   (1024)
+
+VLOG_DEFINE_THIS_MODULE(sai_event);
+
+struct port_state_entry {
+    struct hmap_node node;
+    sai_object_id_t oid;
+    bool up;
+    bool was_up;
+};
+
+static struct ops_sai_ring sai_event_ring;
+static bool sai_event_ring_initialized = false;
+static uint64_t sai_event_dropped = 0;
+
+static void __port_state_coalesce(struct hmap *, sai_object_id_t, bool);
+static void __port_state_flush(struct hmap *);
+static void __event_handle(const struct ops_sai_event *, struct hmap *);
+
+/**
+ * Initialize event mailbox. Must be called before SAI notifications are
+ * registered.
+ */
+void
+ops_sai_event_init(void)
+{
+    int status = 0;
+
+    status = ops_sai_ring_init(&sai_event_ring, SAI_EVENT_RING_SIZE,
+                               sizeof(struct ops_sai_event));
+    ERRNO_LOG_ABORT(status, "Failed to initialize event ring");
+
+    sai_event_dropped = 0;
+    sai_event_ring_initialized = true;
+}
+
+/**
+ * De-initialize event mailbox. Must be called after SAI notifications are
+ * unregistered.
+ */
+void
+ops_sai_event_deinit(void)
+{
+    if (!sai_event_ring_initialized) {
+        return;
+    }
+
+    sai_event_ring_initialized = false;
+    ops_sai_ring_destroy(&sai_event_ring);
+}
+
+/**
+ * Post event for main loop. Lock-free, may be called from SAI threads.
+ *
+ * @param[in] event - pointer to event. Event is copied.
+ */
+void
+ops_sai_event_push(const struct ops_sai_event *event)
+{
+    NULL_PARAM_LOG_ABORT(event);
+
+    ops_sai_ring_push(&sai_event_ring, event);
+}
+
+/**
+ * Drain posted events and handle them in main loop context. Consecutive port
+ * state changes of the same port are coalesced.
+ */
+void
+ops_sai_event_run(void)
+{
+    size_t n = 0;
+    uint64_t dropped = 0;
+    struct ops_sai_event event = { };
+    struct hmap port_states = HMAP_INITIALIZER(&port_states);
+    static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 5);
+
+    if (!sai_event_ring_initialized) {
+        return;
+    }
+
+    ops_sai_ring_wake_clear(&sai_event_ring);
+
+    while (n < SAI_EVENT_BATCH_MAX && ops_sai_ring_pop(&sai_event_ring,
+                                                       &event)) {
+        __event_handle(&event, &port_states);
+        n++;
+    }
+
+    __port_state_flush(&port_states);
+    hmap_destroy(&port_states);
+
+    dropped = ops_sai_ring_dropped_get(&sai_event_ring);
+    if (dropped != sai_event_dropped) {
+        VLOG_WARN_RL(&rl, "Event ring overflow, %"PRIu64" events dropped",
+                     dropped - sai_event_dropped);
+        sai_event_dropped = dropped;
+        /* Port states were lost, make OVS re-read carrier of all ports. */
+        seq_change(connectivity_seq_get());
+    }
+}
+
+/**
+ * Make main loop wake up when events are posted.
+ */
+void
+ops_sai_event_wait(void)
+{
+    if (!sai_event_ring_initialized) {
+        return;
+    }
+
+    ops_sai_ring_wait(&sai_event_ring);
+}
+
+/*
+ * Remember last state of port. Link up is not lost even if port went down
+ * again within the same batch, so carrier resets are still accounted.
+ */
+static void
+__port_state_coalesce(struct hmap *port_states, sai_object_id_t oid, bool up)
+{
+    struct port_state_entry *entry = NULL;
+
+    HMAP_FOR_EACH_WITH_HASH(entry, node, hash_uint64(oid), port_states) {
+        if (entry->oid == oid) {
+            entry->was_up |= up;
+            entry->up = up;
+            return;
+        }
+    }
+
+    entry = xzalloc(sizeof *entry);
+    entry->oid = oid;
+    entry->up = up;
+    entry->was_up = up;
+    hmap_insert(port_states, &entry->node, hash_uint64(oid));
+}
+
+/*
+ * Notify netdevs about coalesced port state changes. LAG members are
+ * excluded from or returned to distribution first, without waiting for OVS
+ * to reconfigure the bundle.
+ */
+static void
+__port_state_flush(struct hmap *port_states)
+{
+    int status = 0;
+    uint32_t hw_id = 0;
+    struct port_state_entry *entry = NULL, *next_entry = NULL;
+
+    HMAP_FOR_EACH_SAFE(entry, next_entry, node, port_states) {
+        if (!ops_sai_api_port_id2hw_id(entry->oid, &hw_id)) {
+            status = ops_sai_lag_port_state_set(hw_id, entry->up);
+            ERRNO_LOG(status, "Failed to update LAG member state "
+                      "(port: %u)", hw_id);
+        }
+
+        if (entry->was_up && !entry->up) {
+            netdev_sai_port_oper_state_changed(entry->oid, true);
+        }
+        netdev_sai_port_oper_state_changed(entry->oid, entry->up);
+
+        hmap_remove(port_states, &entry->node);
+        free(entry);
+    }
+}
+
+static void
+__event_handle(const struct ops_sai_event *event, struct hmap *port_states)
+{
+    switch (event->type) {
+    case OPS_SAI_EVENT_PORT_STATE:
+        __port_state_coalesce(port_states, event->port_state.oid,
+                              event->port_state.up);
+        break;
+    case OPS_SAI_EVENT_SWITCH_STATE:
+        VLOG_INFO("Switch operational state changed (state: %d)",
+                  event->switch_state);
+        break;
+    case OPS_SAI_EVENT_SWITCH_SHUTDOWN:
+        VLOG_ERR("Switch shutdown requested by SAI");
+        break;
+    default:
+        VLOG_WARN("Unknown event type %d", event->type);
+        break;
+    }
+}
@@ -4,6 +4,15 @@
  * the COPYING file.
  */
 
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <hash.h>
+#include <packets.h>
+#include <unixctl.h>
+#include <dynamic-string.h>
+
 #include <sai-log.h>
 #include <sai-common.h>
 #include <sai-hash.h>
@@ -11,6 +20,158 @@
 
 VLOG_DEFINE_THIS_MODULE(sai_hash);
 
+/* ECMP hash parameters applied at init or with appctl. */
+static struct ops_sai_ecmp_hash_params ecmp_hash_params;
+/* LAG hash fields and seed applied at init or with appctl. */
+static uint32_t lag_hash_fields;
+static uint32_t lag_hash_seed;
+
+static const sai_hash_algorithm_t ecmp_hash_sai_algorithms[] = {
+    [OPS_SAI_ECMP_HASH_ALGORITHM_CRC] = SAI_HASH_ALGORITHM_CRC,
+    [OPS_SAI_ECMP_HASH_ALGORITHM_XOR] = SAI_HASH_ALGORITHM_XOR,
+    [OPS_SAI_ECMP_HASH_ALGORITHM_RANDOM] = SAI_HASH_ALGORITHM_RANDOM,
+};
+
+static const char *const ecmp_hash_algorithm_names[] = {
+    [OPS_SAI_ECMP_HASH_ALGORITHM_CRC] = "crc",
+    [OPS_SAI_ECMP_HASH_ALGORITHM_XOR] = "xor",
+    [OPS_SAI_ECMP_HASH_ALGORITHM_RANDOM] = "random",
+};
+
+static void __ecmp_hash_params_cmd(struct unixctl_conn *, int, const char *[],
+                                   void *);
+static void __lag_hash_cmd(struct unixctl_conn *, int, const char *[],
+                           void *);
+static bool __lag_hash_fields_parse(const char *, uint32_t *);
+static void __lag_hash_fields_format(uint32_t, struct ds *);
+
+static const struct {
+    uint32_t field;
+    sai_native_hash_field_t native;
+} lag_hash_native_fields[] = {
+    { OPS_SAI_LAG_HASH_SRC_MAC, SAI_NATIVE_HASH_FIELD_SRC_MAC },
+    { OPS_SAI_LAG_HASH_DST_MAC, SAI_NATIVE_HASH_FIELD_DST_MAC },
+    { OPS_SAI_LAG_HASH_ETHERTYPE, SAI_NATIVE_HASH_FIELD_ETHERTYPE },
+    { OPS_SAI_LAG_HASH_VLAN_ID, SAI_NATIVE_HASH_FIELD_VLAN_ID },
+    { OPS_SAI_LAG_HASH_SRC_IP, SAI_NATIVE_HASH_FIELD_SRC_IP },
+    { OPS_SAI_LAG_HASH_DST_IP, SAI_NATIVE_HASH_FIELD_DST_IP },
+    { OPS_SAI_LAG_HASH_IP_PROTO, SAI_NATIVE_HASH_FIELD_IP_PROTOCOL },
+    { OPS_SAI_LAG_HASH_SRC_PORT, SAI_NATIVE_HASH_FIELD_L4_SRC_PORT },
+    { OPS_SAI_LAG_HASH_DST_PORT, SAI_NATIVE_HASH_FIELD_L4_DST_PORT },
+};
+
+static const struct {
+    uint32_t field;
+    const char *name;
+} lag_hash_field_names[] = {
+    { OPS_SAI_LAG_HASH_SRC_MAC, "src-mac" },
+    { OPS_SAI_LAG_HASH_DST_MAC, "dst-mac" },
+    { OPS_SAI_LAG_HASH_ETHERTYPE, "ethertype" },
+    { OPS_SAI_LAG_HASH_VLAN_ID, "vlan" },
+    { OPS_SAI_LAG_HASH_SRC_IP, "src-ip" },
+    { OPS_SAI_LAG_HASH_DST_IP, "dst-ip" },
+    { OPS_SAI_LAG_HASH_IP_PROTO, "ip-proto" },
+    { OPS_SAI_LAG_HASH_SRC_PORT, "src-port" },
+    { OPS_SAI_LAG_HASH_DST_PORT, "dst-port" },
+    { OPS_SAI_LAG_HASH_INNER, "inner" },
+};
+
+/**
+ * Get default LAG hash seed. It is derived from switch base MAC address, so
+ * neighbor switches hashing the same flows pick members independently.
+ *
+ * @return hash seed.
+ */
+uint32_t
+ops_sai_lag_hash_seed_default(void)
+{
+    struct eth_addr mac = { };
+
+    ops_sai_api_base_mac_get(&mac);
+
+    return hash_bytes(&mac, sizeof mac, 0);
+}
+
+/**
+ * Get default ECMP hash parameters. Seed is derived from switch base MAC
+ * address, so that switches of different tiers split flows independently.
+ *
+ * @param[out] params - hash parameters.
+ */
+void
+ops_sai_ecmp_hash_params_default(struct ops_sai_ecmp_hash_params *params)
+{
+    struct eth_addr mac = { };
+
+    ops_sai_api_base_mac_get(&mac);
+
+    params->seed = hash_bytes(&mac, sizeof mac, 1);
+    params->algorithm = OPS_SAI_ECMP_HASH_ALGORITHM_CRC;
+    params->symmetric = false;
+}
+
+/**
+ * Get name of ECMP hash algorithm.
+ *
+ * @param[in] algorithm - hash algorithm.
+ *
+ * @return name of algorithm.
+ */
+const char *
+ops_sai_ecmp_hash_algorithm_str(enum ops_sai_ecmp_hash_algorithm algorithm)
+{
+    ovs_assert(algorithm < ARRAY_SIZE(ecmp_hash_algorithm_names));
+    return ecmp_hash_algorithm_names[algorithm];
+}
+
+/**
+ * Register appctl commands of hashing. Should be called after hashing is
+ * initialized with default parameters.
+ */
+void
+ops_sai_hash_unixctl_register(void)
+{
+    ops_sai_ecmp_hash_params_default(&ecmp_hash_params);
+    lag_hash_fields = OPS_SAI_LAG_HASH_DEFAULT;
+    lag_hash_seed = ops_sai_lag_hash_seed_default();
+
+    unixctl_command_register("sai/ecmp/hash",
+                             "[seed N] [algorithm crc|xor|random] "
+                             "[symmetric on|off]", 0, 6,
+                             __ecmp_hash_params_cmd, NULL);
+    unixctl_command_register("sai/lag/hash",
+                             "[fields FIELD[,FIELD...]] [seed N]", 0, 4,
+                             __lag_hash_cmd, NULL);
+}
+
+/**
+ * Apply current ECMP hash parameters and LAG hash again. Hashing may be
+ * configured per port, so this should be called when port is created after
+ * hashing was initialized, e.g. for new LAG.
+ *
+ * @return 0 operation completed successfully
+ * @return errno operation failed
+ */
+int
+ops_sai_hash_reapply(void)
+{
+    int status = 0;
+
+    /* Hashing is not initialized yet. */
+    if (!lag_hash_fields) {
+        return 0;
+    }
+
+    status = ops_sai_ecmp_hash_params_set(&ecmp_hash_params);
+    ERRNO_EXIT(status);
+
+    status = ops_sai_lag_hash_set(lag_hash_fields, lag_hash_seed);
+    ERRNO_EXIT(status);
+
+exit:
+    return status;
+}
+
 /*
  * Initialize hashing. Set default hash fields.
  *
@@ -20,7 +181,18 @@ VLOG_DEFINE_THIS_MODULE(sai_hash);
 static void
 __ecmp_hash_init(void)
 {
-    SAI_API_TRACE_NOT_IMPLEMENTED_FN();
+    int status = 0;
+    struct ops_sai_ecmp_hash_params params = { };
+
+    SAI_API_TRACE_FN();
+
+    ops_sai_ecmp_hash_params_default(&params);
+    status = ops_sai_ecmp_hash_params_set(&params);
+    ERRNO_LOG(status, "Failed to initialize ECMP hash parameters");
+
+    status = ops_sai_lag_hash_set(OPS_SAI_LAG_HASH_DEFAULT,
+                                  ops_sai_lag_hash_seed_default());
+    ERRNO_LOG(status, "Failed to initialize LAG hashing");
 }
 
 /*
@@ -39,6 +211,95 @@ __ecmp_hash_set(uint64_t fields_to_set, bool enable)
     return 0;
 }
 
+/*
+ * Set ECMP hash seed, algorithm and symmetric mode.
+ *
+ * @param[in] params - hash parameters.
+ *
+ * @return 0 operation completed successfully
+ * @return errno operation failed
+ */
+static int
+__ecmp_hash_params_set(const struct ops_sai_ecmp_hash_params *params)
+{
+    sai_attribute_t attr = { };
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
+
+    NULL_PARAM_LOG_ABORT(params);
+
+    attr.id = SAI_SWITCH_ATTR_ECMP_DEFAULT_HASH_SEED;
+    attr.value.u32 = params->seed;
+    status = sai_api->switch_api->set_switch_attribute(&attr);
+    SAI_ERROR_LOG_EXIT(status, "Failed to set ECMP hash seed (seed: %u)",
+                       params->seed);
+
+    attr.id = SAI_SWITCH_ATTR_ECMP_DEFAULT_HASH_ALGORITHM;
+    attr.value.s32 = ecmp_hash_sai_algorithms[params->algorithm];
+    status = sai_api->switch_api->set_switch_attribute(&attr);
+    SAI_ERROR_LOG_EXIT(status, "Failed to set ECMP hash algorithm "
+                       "(algorithm: %s)",
+                       ops_sai_ecmp_hash_algorithm_str(params->algorithm));
+
+    attr.id = SAI_SWITCH_ATTR_ECMP_DEFAULT_SYMMETRIC_HASH;
+    attr.value.booldata = params->symmetric;
+    status = sai_api->switch_api->set_switch_attribute(&attr);
+    SAI_ERROR_LOG_EXIT(status, "Failed to set ECMP symmetric hash "
+                       "(symmetric: %s)", params->symmetric ? "on" : "off");
+
+exit:
+    return SAI_ERROR_2_ERRNO(status);
+}
+
+/*
+ * Set LAG hash fields and seed. SAI native hash fields have no notion of
+ * inner headers, so they are hashed only if SAI does it on its own.
+ *
+ * @param[in] fields - bitmap of LAG hash fields.
+ * @param[in] seed   - hash seed.
+ *
+ * @return 0 operation completed successfully
+ * @return errno operation failed
+ */
+static int
+__lag_hash_set(uint32_t fields, uint32_t seed)
+{
+    size_t i = 0;
+    uint32_t n_fields = 0;
+    sai_attribute_t attr = { };
+    sai_object_id_t hash_oid = SAI_NULL_OBJECT_ID;
+    int32_t native_fields[ARRAY_SIZE(lag_hash_native_fields)];
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
+
+    attr.id = SAI_SWITCH_ATTR_LAG_HASH;
+    status = sai_api->switch_api->get_switch_attribute(1, &attr);
+    SAI_ERROR_LOG_EXIT(status, "Failed to get LAG hash object");
+    hash_oid = attr.value.oid;
+
+    for (i = 0; i < ARRAY_SIZE(lag_hash_native_fields); i++) {
+        if (fields & lag_hash_native_fields[i].field) {
+            native_fields[n_fields++] = lag_hash_native_fields[i].native;
+        }
+    }
+
+    attr.id = SAI_HASH_ATTR_NATIVE_FIELD_LIST;
+    attr.value.s32list.count = n_fields;
+    attr.value.s32list.list = native_fields;
+    status = sai_api->hash_api->set_hash_attribute(hash_oid, &attr);
+    SAI_ERROR_LOG_EXIT(status, "Failed to set LAG hash fields "
+                       "(fields: 0x%x)", fields);
+
+    attr.id = SAI_SWITCH_ATTR_LAG_DEFAULT_HASH_SEED;
+    attr.value.u32 = seed;
+    status = sai_api->switch_api->set_switch_attribute(&attr);
+    SAI_ERROR_LOG_EXIT(status, "Failed to set LAG hash seed (seed: %u)",
+                       seed);
+
+exit:
+    return SAI_ERROR_2_ERRNO(status);
+}
+
 /*
  * De-initialize hashing.
  *
@@ -51,9 +312,198 @@ __ecmp_hash_deinit(void)
     SAI_API_TRACE_NOT_IMPLEMENTED_FN();
 }
 
+/*
+ * appctl sai/ecmp/hash: show or change ECMP hash parameters. Parameters
+ * which are not given keep their value.
+ */
+static void
+__ecmp_hash_params_cmd(struct unixctl_conn *conn, int argc,
+                       const char *argv[], void *aux OVS_UNUSED)
+{
+    int i = 0;
+    int err = 0;
+    size_t alg = 0;
+    char *end = NULL;
+    unsigned long seed = 0;
+    struct ds ds = DS_EMPTY_INITIALIZER;
+    struct ops_sai_ecmp_hash_params params = ecmp_hash_params;
+
+    if (0 == argc % 2) {
+        unixctl_command_reply_error(conn, "Missing parameter value");
+        return;
+    }
+
+    for (i = 1; i < argc; i += 2) {
+        if (!strcmp(argv[i], "seed")) {
+            errno = 0;
+            seed = strtoul(argv[i + 1], &end, 0);
+            if (errno || *end || seed > UINT32_MAX) {
+                unixctl_command_reply_error(conn, "Invalid seed");
+                return;
+            }
+            params.seed = seed;
+        } else if (!strcmp(argv[i], "algorithm")) {
+            for (alg = 0; alg < ARRAY_SIZE(ecmp_hash_algorithm_names); alg++) {
+                if (!strcmp(argv[i + 1], ecmp_hash_algorithm_names[alg])) {
+                    break;
+                }
+            }
+            if (alg == ARRAY_SIZE(ecmp_hash_algorithm_names)) {
+                unixctl_command_reply_error(conn, "Invalid algorithm");
+                return;
+            }
+            params.algorithm = alg;
+        } else if (!strcmp(argv[i], "symmetric")) {
+            if (strcmp(argv[i + 1], "on") && strcmp(argv[i + 1], "off")) {
+                unixctl_command_reply_error(conn, "Invalid symmetric mode");
+                return;
+            }
+            params.symmetric = !strcmp(argv[i + 1], "on");
+        } else {
+            unixctl_command_reply_error(conn, "Unknown parameter");
+            return;
+        }
+    }
+
+    if (argc > 1) {
+        err = ops_sai_ecmp_hash_params_set(&params);
+        if (err) {
+            unixctl_command_reply_error(conn, "Failed to set hash parameters");
+            return;
+        }
+        ecmp_hash_params = params;
+    }
+
+    ds_put_format(&ds, "seed: %u\nalgorithm: %s\nsymmetric: %s\n",
+                  ecmp_hash_params.seed,
+                  ops_sai_ecmp_hash_algorithm_str(ecmp_hash_params.algorithm),
+                  ecmp_hash_params.symmetric ? "on" : "off");
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
+}
+
+/*
+ * appctl sai/lag/hash: show or change LAG hash fields and seed. Parameters
+ * which are not given keep their value.
+ */
+static void
+__lag_hash_cmd(struct unixctl_conn *conn, int argc, const char *argv[],
+               void *aux OVS_UNUSED)
+{
+    int i = 0;
+    int err = 0;
+    char *end = NULL;
+    unsigned long seed = 0;
+    uint32_t fields = lag_hash_fields;
+    uint32_t new_seed = lag_hash_seed;
+    struct ds ds = DS_EMPTY_INITIALIZER;
+
+    if (0 == argc % 2) {
+        unixctl_command_reply_error(conn, "Missing parameter value");
+        return;
+    }
+
+    for (i = 1; i < argc; i += 2) {
+        if (!strcmp(argv[i], "fields")) {
+            if (!__lag_hash_fields_parse(argv[i + 1], &fields)) {
+                unixctl_command_reply_error(conn, "Invalid fields");
+                return;
+            }
+        } else if (!strcmp(argv[i], "seed")) {
+            errno = 0;
+            seed = strtoul(argv[i + 1], &end, 0);
+            if (errno || *end || seed > UINT32_MAX) {
+                unixctl_command_reply_error(conn, "Invalid seed");
+                return;
+            }
+            new_seed = seed;
+        } else {
+            unixctl_command_reply_error(conn, "Unknown parameter");
+            return;
+        }
+    }
+
+    if (argc > 1) {
+        err = ops_sai_lag_hash_set(fields, new_seed);
+        if (err) {
+            unixctl_command_reply_error(conn, "Failed to set LAG hash");
+            return;
+        }
+        lag_hash_fields = fields;
+        lag_hash_seed = new_seed;
+    }
+
+    ds_put_cstr(&ds, "fields: ");
+    __lag_hash_fields_format(lag_hash_fields, &ds);
+    ds_put_format(&ds, "\nseed: %u\n", lag_hash_seed);
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
+}
+
+/*
+ * Parse comma separated list of LAG hash field names. "default" stands for
+ * all fields.
+ *
+ * @return false if list is empty or has unknown name.
+ */
+static bool
+__lag_hash_fields_parse(const char *s, uint32_t *fields)
+{
+    size_t i = 0;
+    char *name = NULL;
+    char *save_ptr = NULL;
+    char *copy = xstrdup(s);
+    uint32_t result = 0;
+
+    for (name = strtok_r(copy, ",", &save_ptr); name;
+         name = strtok_r(NULL, ",", &save_ptr)) {
+        if (!strcmp(name, "default")) {
+            result |= OPS_SAI_LAG_HASH_DEFAULT;
+            continue;
+        }
+
+        for (i = 0; i < ARRAY_SIZE(lag_hash_field_names); i++) {
+            if (!strcmp(name, lag_hash_field_names[i].name)) {
+                break;
+            }
+        }
+        if (i == ARRAY_SIZE(lag_hash_field_names)) {
+            result = 0;
+            break;
+        }
+        result |= lag_hash_field_names[i].field;
+    }
+    free(copy);
+
+    /* Inner headers alone select no field. */
+    if (!(result & ~OPS_SAI_LAG_HASH_INNER)) {
+        return false;
+    }
+
+    *fields = result;
+    return true;
+}
+
+static void
+__lag_hash_fields_format(uint32_t fields, struct ds *ds)
+{
+    size_t i = 0;
+    bool first = true;
+
+    for (i = 0; i < ARRAY_SIZE(lag_hash_field_names); i++) {
+        if (fields & lag_hash_field_names[i].field) {
+            ds_put_format(ds, "%s%s", first ? "" : ",",
+                          lag_hash_field_names[i].name);
+            first = false;
+        }
+    }
+}
+
 DEFINE_GENERIC_CLASS(struct hash_class, hash) = {
     .init = __ecmp_hash_init,
     .ecmp_hash_set = __ecmp_hash_set,
+    .ecmp_hash_params_set = __ecmp_hash_params_set,
+    .lag_hash_set = __lag_hash_set,
     .deinit = __ecmp_hash_deinit
 };
 
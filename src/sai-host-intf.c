@@ -5,11 +5,16 @@
  */
 
 #include <inttypes.h>
+#include <sys/stat.h>
 
 #include <util.h>
 #include <hmap.h>
 #include <hash.h>
 #include <list.h>
+#include <timeval.h>
+#include <poll-loop.h>
+#include <unixctl.h>
+#include <dynamic-string.h>
 #include <sai-log.h>
 #include <sai-handle.h>
 
@@ -17,6 +22,8 @@
 #include <sai-policer.h>
 #include <sai-api-class.h>
 #include <sai-port.h>
+#include <sai-rx.h>
+#include <sai-trap-config.h>
 
 #define SAI_TRAP_GROUP_ARP "sai_trap_group_arp"
 #define SAI_TRAP_GROUP_BGP "sai_trap_group_bgp"
@@ -28,6 +35,19 @@
 #define SAI_TRAP_GROUP_S_FLOW "sai_trap_group_s_flow"
 #define SAI_TRAP_GROUP_STP "sai_trap_group_stp"
 
+/* Trap group counters cache refresh interval. */
+#define SAI_TRAP_GROUP_STATS_INTERVAL_MS (5000)
+/* Adaptive policer control loop period. */
+#define SAI_POLICER_TUNE_INTERVAL_MS (1000)
+/* Trap groups of this or higher priority carry critical protocols. */
+#define SAI_POLICER_TUNE_CRITICAL_PRIO (4)
+/* Trap group configuration file change polling interval. */
+#define SAI_TRAP_GROUP_CONFIG_CHECK_INTERVAL_MS (2000)
+
+#ifndef SAI_TRAP_GROUP_CONFIG_FILE_PATH
+#define SAI_TRAP_GROUP_CONFIG_FILE_PATH "/etc/openswitch/sai-trap-groups.yaml"
+#endif
+
 VLOG_DEFINE_THIS_MODULE(sai_host_intf);
 
 static const struct ops_sai_trap_group_config trap_group_config_table[] = { {
@@ -45,6 +65,8 @@ static const struct ops_sai_trap_group_config trap_group_config_table[] = { {
         },
         .is_log = true,
         .is_l3 = true,
+        .rate_min = 100,
+        .rate_ceil = 1000,
     }, {
         .name = SAI_TRAP_GROUP_DHCP,
         .trap_ids = {
@@ -58,6 +80,8 @@ static const struct ops_sai_trap_group_config trap_group_config_table[] = { {
         },
         .is_log = true,
         .is_l3 = true,
+        .rate_min = 100,
+        .rate_ceil = 1000,
     }, {
         .name = SAI_TRAP_GROUP_DHCPV6,
         .trap_ids = {
@@ -71,6 +95,8 @@ static const struct ops_sai_trap_group_config trap_group_config_table[] = { {
         },
         .is_log = true,
         .is_l3 = true,
+        .rate_min = 100,
+        .rate_ceil = 1000,
     }, {
         .name = SAI_TRAP_GROUP_LACP,
         .trap_ids = {
@@ -84,6 +110,8 @@ static const struct ops_sai_trap_group_config trap_group_config_table[] = { {
         },
         .is_log = false,
         .is_l3 = false,
+        .rate_min = 1000,
+        .rate_ceil = 4000,
     }, {
         .name = SAI_TRAP_GROUP_LLDP,
         .trap_ids = {
@@ -97,6 +125,8 @@ static const struct ops_sai_trap_group_config trap_group_config_table[] = { {
         },
         .is_log = false,
         .is_l3 = false,
+        .rate_min = 1000,
+        .rate_ceil = 4000,
     }, {
         .name = SAI_TRAP_GROUP_OSFP,
         .trap_ids = {
@@ -111,6 +141,8 @@ static const struct ops_sai_trap_group_config trap_group_config_table[] = { {
         },
         .is_log = false,
         .is_l3 = true,
+        .rate_min = 5000,
+        .rate_ceil = 10000,
     }, {
         .name = SAI_TRAP_GROUP_S_FLOW,
         .trap_ids = {
@@ -124,6 +156,12 @@ static const struct ops_sai_trap_group_config trap_group_config_table[] = { {
         },
         .is_log = false,
         .is_l3 = true,
+        /* Samples are encoded by sFlow agent in its own thread. */
+        .is_cb = true,
+        .has_rx_worker = true,
+        .rx_core = -1,
+        .rate_min = 200,
+        .rate_ceil = 2000,
     }, {
         .name = SAI_TRAP_GROUP_STP,
         .trap_ids = {
@@ -137,14 +175,62 @@ static const struct ops_sai_trap_group_config trap_group_config_table[] = { {
         },
         .is_log = false,
         .is_l3 = false,
+        .rate_min = 1000,
+        .rate_ceil = 4000,
     },
 };
 
 static struct ovs_list sai_trap_group_list
     = OVS_LIST_INITIALIZER(&sai_trap_group_list);
+/* Generic host interface has no vendor trap groups. */
+static struct ovs_list sai_vendor_trap_group_list
+    = OVS_LIST_INITIALIZER(&sai_vendor_trap_group_list);
 
-static void
-__traps_bind(const int *, const handle_t *, bool, bool);
+static struct ops_sai_host_intf_tx_stats sai_host_intf_tx_stats;
+static struct ops_sai_trap_group_stats_list sai_trap_group_stats;
+static long long int sai_policer_tune_time = 0;
+static long long int sai_trap_config_check_time = 0;
+static struct stat sai_trap_config_stat;
+
+/* Packet action trap had before it was bound first time, restored when trap
+ * is unbound. */
+struct trap_default_action {
+    struct hmap_node hmap_node;
+    int trap_id;
+    int32_t action;
+};
+
+static struct hmap sai_trap_default_actions
+    = HMAP_INITIALIZER(&sai_trap_default_actions);
+
+static int
+__traps_bind(const int *, const handle_t *, bool, bool, const char *);
+static int __traps_unbind(const int *, const int *);
+static void __trap_default_action_save(int);
+static int32_t __trap_default_action_get(int);
+static void __trap_config_reload(bool);
+static void __trap_config_stat(struct stat *);
+static void __trap_config_check_run(void);
+static void __trap_groups_apply(const struct ops_sai_trap_group_config *,
+                                size_t);
+static struct ops_sai_trap_group_entry *__trap_group_find(const char *);
+static int __trap_group_create(const struct ops_sai_trap_group_config *);
+static int __trap_group_update(struct ops_sai_trap_group_entry *,
+                               const struct ops_sai_trap_group_config *);
+static int __trap_group_destroy(struct ops_sai_trap_group_entry *);
+static int __trap_group_rx_worker(const struct ops_sai_trap_group_config *);
+static void __trap_config_reload_cmd(struct unixctl_conn *, int,
+                                     const char *[], void *);
+static void __trap_group_stats_refresh(void);
+static void __policer_tune_run(void);
+static bool __policer_tune_is_tuned(const struct ops_sai_trap_group_entry *);
+static bool __policer_tune_is_flooded(struct ops_sai_trap_group_entry *);
+static uint32_t __policer_tune_rate(const struct ops_sai_trap_group_entry *,
+                                    bool);
+static void __policer_rate_set(struct ops_sai_trap_group_entry *, uint32_t);
+static void __trap_group_stats_show(struct unixctl_conn *, int,
+                                    const char *[], void *);
+static void __stat_format(struct ds *, uint64_t);
 
 /**
  * Returns host interface type string representation.
@@ -175,6 +261,97 @@ ops_sai_host_intf_type_to_str(enum host_intf_type type)
     return str;
 }
 
+/**
+ * Returns counters of packets sent from CPU.
+ *
+ * @param[out] stats - transmit counters.
+ */
+void
+ops_sai_host_intf_tx_stats_get(struct ops_sai_host_intf_tx_stats *stats)
+{
+    NULL_PARAM_LOG_ABORT(stats);
+
+    *stats = sai_host_intf_tx_stats;
+}
+
+/**
+ * Appends zeroed entry to trap group counters list.
+ *
+ * @param[in,out] list - trap group counters.
+ * @param[in]     name - trap group name.
+ *
+ * @return pointer to new entry.
+ */
+struct ops_sai_trap_group_stats *
+ops_sai_trap_group_stats_list_add(struct ops_sai_trap_group_stats_list *list,
+                                  const char *name)
+{
+    struct ops_sai_trap_group_stats *entry = NULL;
+
+    NULL_PARAM_LOG_ABORT(list);
+    NULL_PARAM_LOG_ABORT(name);
+
+    if (list->n == list->allocated) {
+        list->entries = x2nrealloc(list->entries, &list->allocated,
+                                   sizeof *list->entries);
+    }
+
+    entry = &list->entries[list->n++];
+    memset(entry, 0, sizeof *entry);
+    ovs_strlcpy(entry->name, name, sizeof entry->name);
+
+    return entry;
+}
+
+/**
+ * Returns trap group counters collected by last
+ * ops_sai_host_intf_stats_run() without accessing hardware.
+ *
+ * @return pointer to cached trap group counters.
+ */
+const struct ops_sai_trap_group_stats_list *
+ops_sai_host_intf_trap_group_stats_get(void)
+{
+    return &sai_trap_group_stats;
+}
+
+/**
+ * Refreshes cached trap group counters, adjusts policer rates and reloads
+ * changed trap group configuration periodically.
+ */
+void
+ops_sai_host_intf_run(void)
+{
+    __trap_config_check_run();
+    __policer_tune_run();
+
+    if (time_msec() - sai_trap_group_stats.updated
+        < SAI_TRAP_GROUP_STATS_INTERVAL_MS) {
+        return;
+    }
+
+    __trap_group_stats_refresh();
+}
+
+/**
+ * Makes main loop wake up when next of policer tuning, trap group counters
+ * refresh or trap group configuration check is due.
+ */
+void
+ops_sai_host_intf_wait(void)
+{
+    long long int deadline = 0;
+
+    deadline = sai_trap_group_stats.updated
+               + SAI_TRAP_GROUP_STATS_INTERVAL_MS;
+    deadline = MIN(deadline,
+                   sai_policer_tune_time + SAI_POLICER_TUNE_INTERVAL_MS);
+    deadline = MIN(deadline, sai_trap_config_check_time
+                             + SAI_TRAP_GROUP_CONFIG_CHECK_INTERVAL_MS);
+
+    poll_timer_wait_until(deadline);
+}
+
 /*
  * Initialize host interface.
  */
@@ -182,6 +359,11 @@ static void
 __host_intf_init(void)
 {
     VLOG_INFO("Initializing host interface");
+
+    unixctl_command_register("sai/trap-group/stats", "[group]", 0, 1,
+                             __trap_group_stats_show, NULL);
+    unixctl_command_register("sai/trap-group/reload", "", 0, 0,
+                             __trap_config_reload_cmd, NULL);
 }
 
 /*
@@ -191,6 +373,9 @@ static void
 __host_intf_deinit(void)
 {
     VLOG_INFO("De-initializing host interface");
+
+    free(sai_trap_group_stats.entries);
+    memset(&sai_trap_group_stats, 0, sizeof sai_trap_group_stats);
 }
 
 /*
@@ -230,82 +415,626 @@ __host_intf_netdev_remove(const char *name)
 }
 
 /*
- * Registers traps for packets.
+ * Sends packet from CPU. Packet bypasses pipeline if egress port is given.
+ *
+ * @param[in] data  - packet data.
+ * @param[in] size  - packet size.
+ * @param[in] hw_id - egress port label id, or NULL to let pipeline
+ *                    forward the packet.
+ *
+ * @return 0 operation completed successfully
+ * @return errno operation failed
  */
-static void
-__host_intf_traps_register(void)
+static int
+__host_intf_packet_send(void *data, size_t size, const uint32_t *hw_id)
 {
-    int i = 0;
+    uint32_t attr_count = 1;
     sai_attribute_t attr[2] = { };
     sai_status_t status = SAI_STATUS_SUCCESS;
-    struct ops_sai_trap_group_entry *group_entry = NULL;
     const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
 
-    VLOG_INFO("Registering traps");
+    NULL_PARAM_LOG_ABORT(data);
+
+    attr[0].id = SAI_HOSTIF_PACKET_TX_TYPE;
+    attr[0].value.s32 = hw_id ? SAI_HOSTIF_TX_TYPE_PIPELINE_BYPASS
+                              : SAI_HOSTIF_TX_TYPE_PIPELINE_LOOKUP;
+
+    if (hw_id) {
+        attr[1].id = SAI_HOSTIF_PACKET_EGRESS_PORT_OR_LAG;
+        attr[1].value.oid = ops_sai_api_hw_id2port_id(*hw_id);
+        if (SAI_NULL_OBJECT_ID == attr[1].value.oid) {
+            status = SAI_STATUS_ITEM_NOT_FOUND;
+            SAI_ERROR_LOG_EXIT(status, "Unknown egress port (hw_id: %u)",
+                               *hw_id);
+        }
+        attr_count++;
+    }
 
-    for (i = 0; i < ARRAY_SIZE(trap_group_config_table); ++i) {
-        /* create entry */
-        group_entry = xzalloc(sizeof *group_entry);
+    status = sai_api->host_interface_api->send_packet(SAI_NULL_OBJECT_ID,
+                                                      data, size,
+                                                      attr_count, attr);
+    SAI_ERROR_LOG_EXIT(status, "Failed to send packet (size: %"PRIuSIZE")",
+                       size);
 
-        /* create policer */
-        status = ops_sai_policer_create(&group_entry->policer,
-                                        &trap_group_config_table[i].policer_config)
-                                        ? SAI_STATUS_FAILURE
-                                        : SAI_STATUS_SUCCESS;
-        SAI_ERROR_LOG_ABORT(status, "Failed to register traps");
+exit:
+    if (SAI_ERROR_2_ERRNO(status)) {
+        sai_host_intf_tx_stats.errors++;
+    } else {
+        sai_host_intf_tx_stats.packets++;
+        sai_host_intf_tx_stats.bytes += size;
+    }
 
-        /* create group */
-        attr[0].id = SAI_HOSTIF_TRAP_GROUP_ATTR_PRIO;
-        attr[0].value.u32 = trap_group_config_table[i].priority;
-        attr[1].id = SAI_HOSTIF_TRAP_GROUP_ATTR_POLICER;
-        attr[1].value.oid = (sai_object_id_t)group_entry->policer.data;
+    return SAI_ERROR_2_ERRNO(status);
+}
 
-        status = sai_api->host_interface_api->create_hostif_trap_group(&group_entry->trap_group.data,
-                                                                       ARRAY_SIZE(attr),
-                                                                       attr);
-        SAI_ERROR_LOG_ABORT(status, "Failed to create group %s",
-                            trap_group_config_table[i].name);
+/*
+ * Reads policer and receive queue counters of trap groups created from
+ * trap group configuration.
+ *
+ * @param[in,out] list - trap group counters.
+ */
+static void
+__host_intf_trap_group_stats_collect(struct ops_sai_trap_group_stats_list *list)
+{
+    int err = 0;
+    struct ops_sai_trap_group_stats *stats = NULL;
+    struct ops_sai_trap_group_entry *entry = NULL;
+
+    LIST_FOR_EACH(entry, list_node, &sai_trap_group_list) {
+        stats = ops_sai_trap_group_stats_list_add(list, entry->name);
+        stats->rate = entry->rate;
 
-        /* register traps */
-        __traps_bind(trap_group_config_table[i].trap_ids,
-                     &group_entry->trap_group,
-                     trap_group_config_table[i].is_l3,
-                     trap_group_config_table[i].is_log);
+        err = ops_sai_policer_stats_get(&entry->policer, &stats->policer);
+        if (err) {
+            stats->policer.green_packets = OPS_SAI_POLICER_STAT_NA;
+            stats->policer.yellow_packets = OPS_SAI_POLICER_STAT_NA;
+            stats->policer.red_packets = OPS_SAI_POLICER_STAT_NA;
+        }
 
-        strncpy(group_entry->name, trap_group_config_table[i].name,
-                sizeof(group_entry->name));
-        group_entry->name[strnlen(group_entry->name,
-                                  SAI_TRAP_GROUP_MAX_NAME_LEN - 1)] = '\0';
-        list_push_back(&sai_trap_group_list, &group_entry->list_node);
+        stats->has_rx = !ops_sai_rx_stats_get(entry->name, &stats->rx);
     }
 }
 
+static struct ovs_list *
+__host_intf_vendor_trap_groups_get(void)
+{
+    return &sai_vendor_trap_group_list;
+}
+
+static int
+__host_intf_trap_group_policer_stats_get(
+                                const struct ops_sai_trap_group_entry *entry,
+                                struct ops_sai_policer_stats *stats)
+{
+    return ops_sai_policer_stats_get(&entry->policer, stats);
+}
+
+static int
+__host_intf_trap_group_policer_update(
+                                const struct ops_sai_trap_group_entry *entry,
+                                const struct ops_sai_policer_config *config)
+{
+    return ops_sai_policer_update(&entry->policer, config);
+}
+
+/*
+ * Registers traps for packets. Trap groups are read from
+ * SAI_TRAP_GROUP_CONFIG_FILE_PATH, built-in trap_group_config_table is used if
+ * file does not exist or is invalid.
+ */
+static void
+__host_intf_traps_register(void)
+{
+    VLOG_INFO("Registering traps");
+
+    __trap_config_stat(&sai_trap_config_stat);
+    __trap_config_reload(true);
+}
+
 /*
  * Unregisters traps for packets.
  */
 static void
 __hostint_traps_unregister(void)
 {
-    sai_status_t status = SAI_STATUS_SUCCESS;
+    struct trap_default_action *def = NULL, *next_def = NULL;
     struct ops_sai_trap_group_entry *entry = NULL, *next_entry = NULL;
-    const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
 
     LIST_FOR_EACH_SAFE(entry, next_entry, list_node, &sai_trap_group_list) {
-        list_remove(&entry->list_node);
+        __trap_group_destroy(entry);
+    }
 
-        status = ops_sai_policer_remove(&entry->policer) ? SAI_STATUS_SUCCESS
-                                                         : SAI_STATUS_FAILURE;
-        SAI_ERROR_LOG_ABORT(status, "Failed to uninitialize traps %s",
-                            entry->name);
+    HMAP_FOR_EACH_SAFE(def, next_def, hmap_node, &sai_trap_default_actions) {
+        hmap_remove(&sai_trap_default_actions, &def->hmap_node);
+        free(def);
+    }
+}
 
-        status = sai_api->host_interface_api->remove_hostif_trap_group(entry->trap_group.data);
-        SAI_ERROR_LOG_ABORT(status, "Failed to remove trap group %s",
-                            entry->name);
+/*
+ * Reads trap group configuration file and applies it. If file does not exist
+ * built-in configuration is applied. Invalid file is ignored, and current
+ * configuration is kept unless use_default is set.
+ *
+ * @param[in] use_default - apply built-in configuration if file is invalid.
+ */
+static void
+__trap_config_reload(bool use_default)
+{
+    int err = 0;
+    size_t n_configs = 0;
+    struct ops_sai_trap_group_config *configs = NULL;
 
-        free(entry);
+    err = ops_sai_trap_config_load(SAI_TRAP_GROUP_CONFIG_FILE_PATH, &configs,
+                                   &n_configs);
+    if (!err) {
+        VLOG_INFO("Applying trap groups from %s",
+                  SAI_TRAP_GROUP_CONFIG_FILE_PATH);
+        __trap_groups_apply(configs, n_configs);
+        ops_sai_trap_config_destroy(configs, n_configs);
+    } else if (ENOENT == err || use_default) {
+        VLOG_INFO("Applying built-in trap groups (%s: %s)",
+                  SAI_TRAP_GROUP_CONFIG_FILE_PATH, ovs_strerror(err));
+        __trap_groups_apply(trap_group_config_table,
+                            ARRAY_SIZE(trap_group_config_table));
+    } else {
+        VLOG_WARN("Keeping current trap groups, %s is invalid",
+                  SAI_TRAP_GROUP_CONFIG_FILE_PATH);
     }
 }
 
+/*
+ * Fills file identity used to detect changes of configuration file. Identity
+ * is zeroed if file does not exist.
+ */
+static void
+__trap_config_stat(struct stat *st)
+{
+    if (stat(SAI_TRAP_GROUP_CONFIG_FILE_PATH, st)) {
+        memset(st, 0, sizeof *st);
+    }
+}
+
+/*
+ * Reloads trap group configuration if file was created, removed or modified.
+ */
+static void
+__trap_config_check_run(void)
+{
+    struct stat st = { };
+
+    if (time_msec() - sai_trap_config_check_time
+        < SAI_TRAP_GROUP_CONFIG_CHECK_INTERVAL_MS) {
+        return;
+    }
+    sai_trap_config_check_time = time_msec();
+
+    __trap_config_stat(&st);
+    if (st.st_ino == sai_trap_config_stat.st_ino
+        && st.st_dev == sai_trap_config_stat.st_dev
+        && st.st_size == sai_trap_config_stat.st_size
+        && st.st_mtime == sai_trap_config_stat.st_mtime) {
+        return;
+    }
+    sai_trap_config_stat = st;
+
+    __trap_config_reload(false);
+}
+
+/*
+ * Brings trap groups in line with configuration. Traps which leave a group are
+ * unbound before any trap is bound, so trap moved between groups ends up in
+ * its new group regardless of order of groups. Groups whose configuration did
+ * not change are not touched. Group which fails to be changed keeps its
+ * previous configuration, so change is retried on next reload.
+ *
+ * @param[in] configs   - trap group configurations.
+ * @param[in] n_configs - number of trap groups.
+ */
+static void
+__trap_groups_apply(const struct ops_sai_trap_group_config *configs,
+                    size_t n_configs)
+{
+    int err = 0;
+    size_t i = 0;
+    struct ops_sai_trap_group_entry *entry = NULL, *next_entry = NULL;
+
+    LIST_FOR_EACH_SAFE(entry, next_entry, list_node, &sai_trap_group_list) {
+        for (i = 0; i < n_configs; i++) {
+            if (!strcmp(configs[i].name, entry->name)) {
+                break;
+            }
+        }
+
+        if (i == n_configs) {
+            VLOG_INFO("Removing trap group %s", entry->name);
+            /* Errors are logged, group is kept if it is not removed. */
+            __trap_group_destroy(entry);
+        } else {
+            err = __traps_unbind(entry->config->trap_ids,
+                                 configs[i].trap_ids);
+            ERRNO_LOG(err, "Failed to unbind traps of trap group %s",
+                      entry->name);
+        }
+    }
+
+    for (i = 0; i < n_configs; i++) {
+        entry = __trap_group_find(configs[i].name);
+        if (entry) {
+            err = __trap_group_update(entry, &configs[i]);
+            ERRNO_LOG(err, "Failed to update trap group %s, keeping "
+                      "previous configuration", configs[i].name);
+        } else {
+            err = __trap_group_create(&configs[i]);
+            ERRNO_LOG(err, "Failed to create trap group %s",
+                      configs[i].name);
+        }
+    }
+}
+
+static struct ops_sai_trap_group_entry *
+__trap_group_find(const char *name)
+{
+    struct ops_sai_trap_group_entry *entry = NULL;
+
+    LIST_FOR_EACH(entry, list_node, &sai_trap_group_list) {
+        if (!strcmp(entry->name, name)) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Creates trap group with its policer and binds its traps. Policer, group and
+ * receive queue are removed again if any step fails.
+ *
+ * @param[in] config - trap group configuration.
+ *
+ * @return 0 operation completed successfully
+ * @return errno operation failed
+ */
+static int
+__trap_group_create(const struct ops_sai_trap_group_config *config)
+{
+    int err = 0;
+    static const int no_trap_ids[] = { -1 };
+    sai_attribute_t attr[3] = { };
+    uint32_t attr_count = 2;
+    bool has_policer = false;
+    bool has_group = false;
+    bool has_rx_queue = false;
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    struct ops_sai_trap_group_entry *group_entry = NULL;
+    const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
+
+    VLOG_INFO("Creating trap group %s", config->name);
+
+    /* create entry */
+    group_entry = xzalloc(sizeof *group_entry);
+
+    /* create policer */
+    err = ops_sai_policer_create(&group_entry->policer,
+                                 &config->policer_config);
+    ERRNO_LOG_EXIT(err, "Failed to create policer of trap group %s",
+                   config->name);
+    has_policer = true;
+
+    /* create group */
+    attr[0].id = SAI_HOSTIF_TRAP_GROUP_ATTR_PRIO;
+    attr[0].value.u32 = config->priority;
+    attr[1].id = SAI_HOSTIF_TRAP_GROUP_ATTR_POLICER;
+    attr[1].value.oid = (sai_object_id_t)group_entry->policer.data;
+    if (config->has_queue) {
+        attr[2].id = SAI_HOSTIF_TRAP_GROUP_ATTR_QUEUE;
+        attr[2].value.u32 = config->queue;
+        attr_count++;
+    }
+
+    status = sai_api->host_interface_api->create_hostif_trap_group(&group_entry->trap_group.data,
+                                                                   attr_count,
+                                                                   attr);
+    err = SAI_ERROR_2_ERRNO(status);
+    SAI_ERROR_LOG_EXIT(status, "Failed to create group %s", config->name);
+    has_group = true;
+
+    /* packets of callback groups are received by rx engine */
+    if (config->is_cb) {
+        err = ops_sai_rx_queue_create(config->name, config->priority,
+                                      __trap_group_rx_worker(config));
+        ERRNO_LOG_EXIT(err, "Failed to create receive queue %s",
+                       config->name);
+        has_rx_queue = true;
+    }
+
+    /* register traps */
+    err = __traps_bind(config->trap_ids, &group_entry->trap_group,
+                       config->is_l3, config->is_log,
+                       config->is_cb ? config->name : NULL);
+    ERRNO_LOG_EXIT(err, "Failed to bind traps of trap group %s",
+                   config->name);
+
+    group_entry->config = ops_sai_trap_config_clone(config);
+    group_entry->rate = config->policer_config.rate_max;
+    group_entry->red_packets = OPS_SAI_POLICER_STAT_NA;
+
+    ovs_strlcpy(group_entry->name, config->name, sizeof group_entry->name);
+    list_push_back(&sai_trap_group_list, &group_entry->list_node);
+
+exit:
+    if (err) {
+        if (has_group) {
+            __traps_unbind(config->trap_ids, no_trap_ids);
+            sai_api->host_interface_api->remove_hostif_trap_group(group_entry->trap_group.data);
+        }
+        if (has_rx_queue) {
+            ops_sai_rx_queue_destroy(config->name);
+        }
+        if (has_policer) {
+            ops_sai_policer_remove(&group_entry->policer);
+        }
+        free(group_entry);
+    }
+
+    return err;
+}
+
+/*
+ * Applies changed configuration to existing trap group. Traps which left the
+ * group must be already unbound. If any step fails, group configuration
+ * records steps applied before it, so it matches hardware and next reload
+ * retries the rest.
+ *
+ * @param[in] entry  - trap group.
+ * @param[in] config - new trap group configuration.
+ *
+ * @return 0 operation completed successfully
+ * @return errno operation failed
+ */
+static int
+__trap_group_update(struct ops_sai_trap_group_entry *entry,
+                    const struct ops_sai_trap_group_config *config)
+{
+    int err = 0;
+    sai_attribute_t attr = { };
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    struct ops_sai_trap_group_config *old = entry->config;
+    struct ops_sai_trap_group_config *applied = ops_sai_trap_config_clone(old);
+    const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
+
+    if (old->policer_config.rate_max != config->policer_config.rate_max
+        || old->policer_config.burst_max != config->policer_config.burst_max) {
+        VLOG_INFO("Updating policer of trap group %s (rate: %u, burst: %u)",
+                  entry->name, config->policer_config.rate_max,
+                  config->policer_config.burst_max);
+        err = ops_sai_policer_update(&entry->policer,
+                                     &config->policer_config);
+        ERRNO_LOG_EXIT(err, "Failed to update policer of trap group %s",
+                       entry->name);
+        applied->policer_config = config->policer_config;
+        entry->rate = config->policer_config.rate_max;
+        entry->red_packets = OPS_SAI_POLICER_STAT_NA;
+        entry->is_flooded = false;
+    }
+
+    if (old->priority != config->priority) {
+        attr.id = SAI_HOSTIF_TRAP_GROUP_ATTR_PRIO;
+        attr.value.u32 = config->priority;
+        status = sai_api->host_interface_api->set_hostif_trap_group_attribute(entry->trap_group.data,
+                                                                              &attr);
+        err = SAI_ERROR_2_ERRNO(status);
+        SAI_ERROR_LOG_EXIT(status, "Failed to set priority of trap group %s",
+                           entry->name);
+        applied->priority = config->priority;
+    }
+
+    if (old->has_queue != config->has_queue || old->queue != config->queue) {
+        attr.id = SAI_HOSTIF_TRAP_GROUP_ATTR_QUEUE;
+        attr.value.u32 = config->has_queue ? config->queue : 0;
+        status = sai_api->host_interface_api->set_hostif_trap_group_attribute(entry->trap_group.data,
+                                                                              &attr);
+        err = SAI_ERROR_2_ERRNO(status);
+        SAI_ERROR_LOG_EXIT(status, "Failed to set queue of trap group %s",
+                           entry->name);
+        applied->has_queue = config->has_queue;
+        applied->queue = config->queue;
+    }
+
+    if (config->is_cb
+        && (!old->is_cb || old->priority != config->priority
+            || __trap_group_rx_worker(old)
+               != __trap_group_rx_worker(config))) {
+        err = ops_sai_rx_queue_create(config->name, config->priority,
+                                      __trap_group_rx_worker(config));
+        ERRNO_LOG_EXIT(err, "Failed to create receive queue %s",
+                       config->name);
+        applied->has_rx_worker = config->has_rx_worker;
+        applied->rx_core = config->rx_core;
+    }
+
+    if (memcmp(old->trap_ids, config->trap_ids, sizeof old->trap_ids)
+        || old->is_l3 != config->is_l3 || old->is_log != config->is_log
+        || old->is_cb != config->is_cb) {
+        VLOG_INFO("Rebinding traps of trap group %s", entry->name);
+        err = __traps_bind(config->trap_ids, &entry->trap_group,
+                           config->is_l3, config->is_log,
+                           config->is_cb ? config->name : NULL);
+        ERRNO_LOG_EXIT(err, "Failed to rebind traps of trap group %s",
+                       entry->name);
+    }
+
+    /* Queue may be left over by group which failed to become callback
+     * group, so it is looked up regardless of old configuration. */
+    if (!config->is_cb) {
+        ops_sai_rx_queue_destroy(entry->name);
+    }
+
+    ops_sai_trap_config_free(applied);
+    applied = ops_sai_trap_config_clone(config);
+
+exit:
+    entry->config = applied;
+    ops_sai_trap_config_free(old);
+    return err;
+}
+
+/*
+ * Unbinds traps of trap group, removes the group and its policer. Group is
+ * kept if it can't be removed, so removal is retried on next reload.
+ *
+ * @param[in] entry - trap group.
+ *
+ * @return 0 operation completed successfully
+ * @return errno operation failed
+ */
+static int
+__trap_group_destroy(struct ops_sai_trap_group_entry *entry)
+{
+    int err = 0;
+    static const int no_trap_ids[] = { -1 };
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
+
+    err = __traps_unbind(entry->config->trap_ids, no_trap_ids);
+    ERRNO_LOG_EXIT(err, "Failed to unbind traps of trap group %s",
+                   entry->name);
+
+    status = sai_api->host_interface_api->remove_hostif_trap_group(entry->trap_group.data);
+    err = SAI_ERROR_2_ERRNO(status);
+    SAI_ERROR_LOG_EXIT(status, "Failed to remove trap group %s",
+                       entry->name);
+
+    err = ops_sai_policer_remove(&entry->policer);
+    ERRNO_LOG(err, "Failed to remove policer of trap group %s", entry->name);
+
+    ops_sai_rx_queue_destroy(entry->name);
+
+    list_remove(&entry->list_node);
+    ops_sai_trap_config_free(entry->config);
+    free(entry);
+
+exit:
+    return err;
+}
+
+/*
+ * Returns receive worker of callback trap group in ops_sai_rx_queue_create()
+ * terms.
+ */
+static int
+__trap_group_rx_worker(const struct ops_sai_trap_group_config *config)
+{
+    return config->has_rx_worker ? config->rx_core : SAI_RX_WORKER_NONE;
+}
+
+/*
+ * Stops trapping packets of traps which are not kept. Traps get back packet
+ * action they had before they were bound.
+ *
+ * @param[in] trap_ids - list of trap ids, -1 terminated.
+ * @param[in] keep_ids - list of trap ids which stay bound, -1 terminated.
+ *
+ * @return 0 operation completed successfully
+ * @return errno of first trap which failed to be unbound
+ */
+static int
+__traps_unbind(const int *trap_ids, const int *keep_ids)
+{
+    int i = 0;
+    int j = 0;
+    int err = 0;
+    bool is_kept = false;
+    sai_attribute_t attr = { };
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
+
+    for (i = 0; trap_ids[i] != -1; i++) {
+        is_kept = false;
+        for (j = 0; keep_ids[j] != -1; j++) {
+            is_kept = is_kept || keep_ids[j] == trap_ids[i];
+        }
+        if (is_kept) {
+            continue;
+        }
+
+        attr.id = SAI_HOSTIF_TRAP_ATTR_PACKET_ACTION;
+        attr.value.s32 = __trap_default_action_get(trap_ids[i]);
+        status = sai_api->host_interface_api->set_trap_attribute(trap_ids[i],
+                                                                 &attr);
+        if (SAI_ERROR_2_ERRNO(status)) {
+            VLOG_ERR("SAI error %d Failed to unbind trap, id %d", status,
+                     trap_ids[i]);
+            err = err ? err : SAI_ERROR_2_ERRNO(status);
+        }
+    }
+
+    return err;
+}
+
+/*
+ * Remembers packet action of trap before it is bound first time.
+ */
+static void
+__trap_default_action_save(int trap_id)
+{
+    sai_attribute_t attr = { };
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    struct trap_default_action *def = NULL;
+    const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
+
+    HMAP_FOR_EACH_WITH_HASH(def, hmap_node, hash_int(trap_id, 0),
+                            &sai_trap_default_actions) {
+        if (def->trap_id == trap_id) {
+            return;
+        }
+    }
+
+    attr.id = SAI_HOSTIF_TRAP_ATTR_PACKET_ACTION;
+    status = sai_api->host_interface_api->get_trap_attribute(trap_id, 1,
+                                                             &attr);
+    if (SAI_ERROR_2_ERRNO(status)) {
+        VLOG_WARN("Failed to get default action of trap, forward is "
+                  "restored on unbind (id: %d, status: %d)", trap_id, status);
+        return;
+    }
+
+    def = xzalloc(sizeof *def);
+    def->trap_id = trap_id;
+    def->action = attr.value.s32;
+    hmap_insert(&sai_trap_default_actions, &def->hmap_node,
+                hash_int(trap_id, 0));
+}
+
+/*
+ * Returns packet action trap had before it was bound first time.
+ */
+static int32_t
+__trap_default_action_get(int trap_id)
+{
+    struct trap_default_action *def = NULL;
+
+    HMAP_FOR_EACH_WITH_HASH(def, hmap_node, hash_int(trap_id, 0),
+                            &sai_trap_default_actions) {
+        if (def->trap_id == trap_id) {
+            return def->action;
+        }
+    }
+
+    return SAI_PACKET_ACTION_FORWARD;
+}
+
+/*
+ * appctl sai/trap-group/reload: re-read trap group configuration file.
+ */
+static void
+__trap_config_reload_cmd(struct unixctl_conn *conn, int argc OVS_UNUSED,
+                         const char *argv[] OVS_UNUSED, void *aux OVS_UNUSED)
+{
+    __trap_config_stat(&sai_trap_config_stat);
+    __trap_config_reload(false);
+    unixctl_command_reply(conn, NULL);
+}
+
 /*
  * Binds trap ids to trap groups.
  *
@@ -313,15 +1042,18 @@ __hostint_traps_unregister(void)
  * @param[in] group    - pointer to trap group handle.
  * @param[in] is_l3    - boolean indicating if trap channel is L3 netdev.
  * @param[in] is_log   - boolean indicating if packet should be forwarded.
+ * @param[in] rx_queue - receive queue name if trap channel is callback,
+ *                       NULL otherwise.
  *
  * @return 0 operation completed successfully
  * @return errno operation failed
  */
-static void
+static int
 __traps_bind(const int *trap_ids, const handle_t *group, bool is_l3,
-             bool is_log)
+             bool is_log, const char *rx_queue)
 {
     int i = 0;
+    int err = 0;
     sai_attribute_t attr = { };
     sai_status_t status = SAI_STATUS_SUCCESS;
     const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
@@ -330,16 +1062,26 @@ __traps_bind(const int *trap_ids, const handle_t *group, bool is_l3,
     NULL_PARAM_LOG_ABORT(trap_ids);
 
     for (i = 0; trap_ids[i] != -1; i++) {
+        __trap_default_action_save(trap_ids[i]);
+
         attr.id = SAI_HOSTIF_TRAP_ATTR_PACKET_ACTION;
         attr.value.u32 = is_log ? SAI_PACKET_ACTION_LOG
                                 : SAI_PACKET_ACTION_TRAP;
         status = sai_api->host_interface_api->set_trap_attribute(trap_ids[i],
                                                                  &attr);
-        SAI_ERROR_LOG_ABORT(status, "Failed to set trap packet action, id %d",
-                            trap_ids[i]);
+        err = SAI_ERROR_2_ERRNO(status);
+        SAI_ERROR_LOG_EXIT(status, "Failed to set trap packet action, id %d",
+                           trap_ids[i]);
+
+        if (rx_queue) {
+            err = ops_sai_rx_trap_bind(rx_queue, trap_ids[i]);
+            ERRNO_LOG_EXIT(err, "Failed to bind trap to receive queue, id %d",
+                           trap_ids[i]);
+        }
 
         attr.id = SAI_HOSTIF_TRAP_ATTR_TRAP_CHANNEL;
-        attr.value.u32 = is_l3 ? SAI_HOSTIF_TRAP_CHANNEL_NETDEV
+        attr.value.u32 = rx_queue ? SAI_HOSTIF_TRAP_CHANNEL_CB
+                       : is_l3 ? SAI_HOSTIF_TRAP_CHANNEL_NETDEV
 #ifdef MLNX_SAI
                                : SAI_HOSTIF_TRAP_CHANNEL_L2_NETDEV;
 #else
@@ -347,15 +1089,220 @@ __traps_bind(const int *trap_ids, const handle_t *group, bool is_l3,
 #endif
         status = sai_api->host_interface_api->set_trap_attribute(trap_ids[i],
                                                                  &attr);
-        SAI_ERROR_LOG_ABORT(status, "Failed to set trap channel, id %d",
-                            trap_ids[i]);
+        err = SAI_ERROR_2_ERRNO(status);
+        SAI_ERROR_LOG_EXIT(status, "Failed to set trap channel, id %d",
+                           trap_ids[i]);
 
         attr.id = SAI_HOSTIF_TRAP_ATTR_TRAP_GROUP;
         attr.value.oid = (sai_object_id_t)group->data;
         status = sai_api->host_interface_api->set_trap_attribute(trap_ids[i],
                                                                  &attr);
-        SAI_ERROR_LOG_ABORT(status, "Failed to bind trap to group, id %d",
-                            trap_ids[i]);
+        err = SAI_ERROR_2_ERRNO(status);
+        SAI_ERROR_LOG_EXIT(status, "Failed to bind trap to group, id %d",
+                           trap_ids[i]);
+    }
+
+exit:
+    return err;
+}
+
+/*
+ * Adaptive policer control loop. Trap group is flooded when its policer
+ * dropped packets or its receive queue is half full since last iteration.
+ * While any non critical group is flooded CPU is congested: flooded non
+ * critical groups are squeezed multiplicatively down to rate_min and critical
+ * groups drop back to their nominal rate. Otherwise non critical groups
+ * recover additively to nominal rate and critical groups get additive
+ * headroom up to rate_ceil. Vendor trap groups are tuned the same way.
+ */
+static void
+__policer_tune_run(void)
+{
+    size_t i = 0;
+    uint32_t rate = 0;
+    bool congested = false;
+    struct ops_sai_trap_group_entry *entry = NULL;
+    struct ovs_list *lists[] = {
+        &sai_trap_group_list,
+        ops_sai_host_intf_vendor_trap_groups_get(),
+    };
+
+    if (time_msec() - sai_policer_tune_time < SAI_POLICER_TUNE_INTERVAL_MS) {
+        return;
+    }
+    sai_policer_tune_time = time_msec();
+
+    for (i = 0; i < ARRAY_SIZE(lists); i++) {
+        LIST_FOR_EACH(entry, list_node, lists[i]) {
+            if (!__policer_tune_is_tuned(entry)) {
+                continue;
+            }
+
+            entry->is_flooded = __policer_tune_is_flooded(entry);
+            if (entry->is_flooded
+                && entry->config->priority < SAI_POLICER_TUNE_CRITICAL_PRIO) {
+                congested = true;
+            }
+        }
+    }
+
+    for (i = 0; i < ARRAY_SIZE(lists); i++) {
+        LIST_FOR_EACH(entry, list_node, lists[i]) {
+            if (!__policer_tune_is_tuned(entry)) {
+                continue;
+            }
+
+            rate = __policer_tune_rate(entry, congested);
+            if (rate != entry->rate) {
+                __policer_rate_set(entry, rate);
+            }
+        }
+    }
+}
+
+static bool
+__policer_tune_is_tuned(const struct ops_sai_trap_group_entry *entry)
+{
+    return entry->config && entry->config->rate_min;
+}
+
+static bool
+__policer_tune_is_flooded(struct ops_sai_trap_group_entry *entry)
+{
+    bool is_flooded = false;
+    struct ops_sai_rx_stats rx_stats = { };
+    struct ops_sai_policer_stats stats = { };
+
+    if (!ops_sai_host_intf_trap_group_policer_stats_get(entry, &stats)
+        && OPS_SAI_POLICER_STAT_NA != stats.red_packets) {
+        is_flooded = OPS_SAI_POLICER_STAT_NA != entry->red_packets
+                     && stats.red_packets != entry->red_packets;
+        entry->red_packets = stats.red_packets;
+    }
+
+    if (!ops_sai_rx_stats_get(entry->name, &rx_stats)
+        && rx_stats.depth >= rx_stats.capacity / 2) {
+        is_flooded = true;
+    }
+
+    return is_flooded;
+}
+
+static uint32_t
+__policer_tune_rate(const struct ops_sai_trap_group_entry *entry,
+                    bool congested)
+{
+    uint32_t nominal = entry->config->policer_config.rate_max;
+    uint32_t floor = MIN(entry->config->rate_min, nominal);
+    uint32_t ceil = MAX(entry->config->rate_ceil, nominal);
+
+    /* Steps are at least 1, rates of some groups are in 10^3 units. */
+    if (entry->config->priority >= SAI_POLICER_TUNE_CRITICAL_PRIO) {
+        return congested ? nominal
+                         : MIN(entry->rate + MAX(nominal / 4, 1), ceil);
+    }
+
+    if (entry->is_flooded) {
+        return MAX(entry->rate / 2, floor);
+    }
+
+    return MIN(entry->rate + MAX(nominal / 8, 1), nominal);
+}
+
+/*
+ * Apply new policer rate, burst is scaled with rate.
+ */
+static void
+__policer_rate_set(struct ops_sai_trap_group_entry *entry, uint32_t rate)
+{
+    int err = 0;
+    const struct ops_sai_policer_config *nominal =
+        &entry->config->policer_config;
+    struct ops_sai_policer_config config = {
+        .rate_max = rate,
+        .burst_max = MAX((uint64_t) nominal->burst_max * rate
+                         / nominal->rate_max, 1),
+    };
+
+    err = ops_sai_host_intf_trap_group_policer_update(entry, &config);
+    ERRNO_LOG_EXIT(err, "Failed to tune policer of group %s (rate: %u)",
+                   entry->name, rate);
+
+    VLOG_DBG("Tuned policer of group %s (rate: %u -> %u, burst: %u)",
+             entry->name, entry->rate, rate, config.burst_max);
+    entry->rate = rate;
+
+exit:
+    return;
+}
+
+/*
+ * Re-reads trap group counters from hardware into cache.
+ */
+static void
+__trap_group_stats_refresh(void)
+{
+    sai_trap_group_stats.n = 0;
+    ops_sai_host_intf_trap_group_stats_collect(&sai_trap_group_stats);
+    sai_trap_group_stats.updated = time_msec();
+}
+
+/*
+ * appctl sai/trap-group/stats [group]: show fresh trap group counters.
+ */
+static void
+__trap_group_stats_show(struct unixctl_conn *conn, int argc,
+                        const char *argv[], void *aux OVS_UNUSED)
+{
+    size_t i = 0;
+    struct ds ds = DS_EMPTY_INITIALIZER;
+    struct ops_sai_host_intf_tx_stats tx_stats = { };
+    const struct ops_sai_trap_group_stats *stats = NULL;
+
+    __trap_group_stats_refresh();
+
+    ds_put_format(&ds, "%-32s %10s %14s %14s %14s %14s %14s\n",
+                  "Trap group", "Rate", "Green", "Yellow", "Red",
+                  "Rx accepted", "Rx dropped");
+
+    for (i = 0; i < sai_trap_group_stats.n; i++) {
+        stats = &sai_trap_group_stats.entries[i];
+        if (argc > 1 && strcmp(argv[1], stats->name)) {
+            continue;
+        }
+
+        ds_put_format(&ds, "%-32s", stats->name);
+        if (stats->rate) {
+            ds_put_format(&ds, " %10"PRIu32, stats->rate);
+        } else {
+            ds_put_format(&ds, " %10s", "n/a");
+        }
+        __stat_format(&ds, stats->policer.green_packets);
+        __stat_format(&ds, stats->policer.yellow_packets);
+        __stat_format(&ds, stats->policer.red_packets);
+        __stat_format(&ds, stats->has_rx ? stats->rx.accepted
+                                         : OPS_SAI_POLICER_STAT_NA);
+        __stat_format(&ds, stats->has_rx ? stats->rx.dropped
+                                         : OPS_SAI_POLICER_STAT_NA);
+        ds_put_char(&ds, '\n');
+    }
+
+    ops_sai_host_intf_tx_stats_get(&tx_stats);
+    ds_put_format(&ds, "\nCPU tx: %"PRIu64" packets, %"PRIu64" bytes, "
+                  "%"PRIu64" errors\n", tx_stats.packets, tx_stats.bytes,
+                  tx_stats.errors);
+
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
+}
+
+static void
+__stat_format(struct ds *ds, uint64_t value)
+{
+    if (OPS_SAI_POLICER_STAT_NA == value) {
+        ds_put_format(ds, " %14s", "n/a");
+    } else {
+        ds_put_format(ds, " %14"PRIu64, value);
     }
 }
 
@@ -365,6 +1312,12 @@ DEFINE_GENERIC_CLASS(struct host_intf_class, host_intf) = {
         .remove = __host_intf_netdev_remove,
         .traps_register = __host_intf_traps_register,
         .traps_unregister = __hostint_traps_unregister,
+        .packet_send = __host_intf_packet_send,
+        .trap_group_stats_collect = __host_intf_trap_group_stats_collect,
+        .vendor_trap_groups_get = __host_intf_vendor_trap_groups_get,
+        .trap_group_policer_stats_get =
+            __host_intf_trap_group_policer_stats_get,
+        .trap_group_policer_update = __host_intf_trap_group_policer_update,
         .deinit = __host_intf_deinit
 };
 
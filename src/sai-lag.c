@@ -0,0 +1,368 @@
+/*
+ * Copyright Mellanox Technologies, Ltd. 2001-2016.
+ * This software product is licensed under Apache version 2, as detailed in
+ * the COPYING file.
+ */
+
+#include <hmap.h>
+#include <hash.h>
+#include <util.h>
+
+#include <sai-log.h>
+#include <sai-api-class.h>
+#include <sai-common.h>
+#include <sai-port.h>
+#include <sai-hash.h>
+#include <sai-lag.h>
+
+VLOG_DEFINE_THIS_MODULE(sai_lag);
+
+struct lag_entry {
+    struct hmap_node node;          /* In 'lags', hashed by label ID. */
+    uint32_t hw_id;                 /* LAG label ID. */
+    sai_object_id_t oid;
+};
+
+/* Port can be member of single LAG only, so members are indexed globally. */
+struct lag_member_entry {
+    struct hmap_node node;          /* In 'lag_members', by port label ID. */
+    uint32_t port_hw_id;
+    sai_object_id_t oid;            /* LAG member object ID. */
+    struct lag_entry *lag;
+    bool egress_disabled;           /* Excluded from distribution. */
+};
+
+static struct hmap lags = HMAP_INITIALIZER(&lags);
+static struct hmap lag_members = HMAP_INITIALIZER(&lag_members);
+
+static struct lag_entry *__lag_find(uint32_t);
+static struct lag_member_entry *__lag_member_find(uint32_t);
+static uint32_t __lag_hw_id_alloc(void);
+static int __lag_member_remove(struct lag_member_entry *);
+static int __lag_member_egress_set(struct lag_member_entry *, bool);
+
+/*
+ * Initialize LAGs.
+ */
+static void
+__lag_init(void)
+{
+    VLOG_INFO("Initializing LAGs");
+
+    hmap_init(&lags);
+    hmap_init(&lag_members);
+}
+
+/*
+ * Create LAG without members and register it in port table.
+ *
+ * @param[out] hw_id label id assigned to LAG.
+ *
+ * @return 0 on success, sai status converted to errno value.
+ */
+static int
+__lag_create(uint32_t *hw_id)
+{
+    int err = 0;
+    int hash_err = 0;
+    struct lag_entry *lag = NULL;
+    sai_object_id_t oid = SAI_NULL_OBJECT_ID;
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
+
+    NULL_PARAM_LOG_ABORT(hw_id);
+
+    status = sai_api->lag_api->create_lag(&oid, 0, NULL);
+    SAI_ERROR_LOG_EXIT(status, "Failed to create LAG");
+
+    lag = xzalloc(sizeof *lag);
+    lag->hw_id = __lag_hw_id_alloc();
+    lag->oid = oid;
+
+    err = ops_sai_api_lag_port_add(lag->hw_id, oid);
+    if (err) {
+        (void) sai_api->lag_api->remove_lag(oid);
+        free(lag);
+        ERRNO_LOG_EXIT(err, "Failed to register LAG (oid: %lu)", oid);
+    }
+
+    hmap_insert(&lags, &lag->node, hash_int(lag->hw_id, 0));
+    *hw_id = lag->hw_id;
+
+    /* Hashing may be configured per port, new LAG port has defaults. LAG
+     * still forwards with them, so failure is not fatal. */
+    hash_err = ops_sai_hash_reapply();
+    ERRNO_LOG(hash_err, "Failed to apply hashing to LAG (label: %u)",
+              lag->hw_id);
+
+    VLOG_INFO("Created LAG (label: %u, oid: %lu)", lag->hw_id, oid);
+
+exit:
+    return err ? err : SAI_ERROR_2_ERRNO(status);
+}
+
+/*
+ * Remove LAG. Remaining members are removed first.
+ *
+ * @param[in] hw_id LAG label id.
+ *
+ * @return 0 on success, sai status converted to errno value.
+ */
+static int
+__lag_remove(uint32_t hw_id)
+{
+    int err = 0;
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    struct lag_entry *lag = __lag_find(hw_id);
+    struct lag_member_entry *member = NULL, *next_member = NULL;
+    const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
+
+    if (NULL == lag) {
+        err = ENOENT;
+        ERRNO_LOG_EXIT(err, "LAG does not exist (label: %u)", hw_id);
+    }
+
+    HMAP_FOR_EACH_SAFE(member, next_member, node, &lag_members) {
+        if (member->lag != lag) {
+            continue;
+        }
+
+        err = __lag_member_remove(member);
+        ERRNO_EXIT(err);
+    }
+
+    status = sai_api->lag_api->remove_lag(lag->oid);
+    SAI_ERROR_LOG_EXIT(status, "Failed to remove LAG (label: %u)", hw_id);
+
+    ops_sai_api_lag_port_del(hw_id);
+    hmap_remove(&lags, &lag->node);
+    free(lag);
+
+exit:
+    return err ? err : SAI_ERROR_2_ERRNO(status);
+}
+
+/*
+ * Add port to LAG.
+ *
+ * @param[in] hw_id LAG label id.
+ * @param[in] port_hw_id port label id.
+ *
+ * @return 0 on success, sai status converted to errno value.
+ */
+static int
+__lag_member_add(uint32_t hw_id, uint32_t port_hw_id)
+{
+    int err = 0;
+    bool carrier = true;
+    sai_attribute_t attr[2] = { };
+    struct lag_entry *lag = __lag_find(hw_id);
+    struct lag_member_entry *member = __lag_member_find(port_hw_id);
+    sai_object_id_t oid = SAI_NULL_OBJECT_ID;
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
+
+    if (NULL == lag) {
+        err = ENOENT;
+        ERRNO_LOG_EXIT(err, "LAG does not exist (label: %u)", hw_id);
+    }
+
+    if (NULL != member) {
+        if (member->lag != lag) {
+            err = EEXIST;
+            ERRNO_LOG_EXIT(err, "Port is member of other LAG "
+                           "(port: %u, lag: %u)", port_hw_id,
+                           member->lag->hw_id);
+        }
+        goto exit;
+    }
+
+    attr[0].id = SAI_LAG_MEMBER_ATTR_LAG_ID;
+    attr[0].value.oid = lag->oid;
+    attr[1].id = SAI_LAG_MEMBER_ATTR_PORT_ID;
+    attr[1].value.oid = ops_sai_api_hw_id2port_id(port_hw_id);
+
+    status = sai_api->lag_api->create_lag_member(&oid, ARRAY_SIZE(attr),
+                                                 attr);
+    SAI_ERROR_LOG_EXIT(status, "Failed to add LAG member (port: %u, lag: %u)",
+                       port_hw_id, hw_id);
+
+    member = xzalloc(sizeof *member);
+    member->port_hw_id = port_hw_id;
+    member->oid = oid;
+    member->lag = lag;
+    hmap_insert(&lag_members, &member->node, hash_int(port_hw_id, 0));
+
+    /* Link state events of port are not repeated, exclude port that is
+     * already down right away. Failure is logged and left to next event. */
+    if (!ops_sai_port_carrier_get(port_hw_id, &carrier) && !carrier) {
+        (void) __lag_member_egress_set(member, false);
+    }
+
+exit:
+    return err ? err : SAI_ERROR_2_ERRNO(status);
+}
+
+/*
+ * Remove port from LAG.
+ *
+ * @param[in] hw_id LAG label id.
+ * @param[in] port_hw_id port label id.
+ *
+ * @return 0 on success, sai status converted to errno value.
+ */
+static int
+__lag_member_del(uint32_t hw_id, uint32_t port_hw_id)
+{
+    int err = 0;
+    struct lag_member_entry *member = __lag_member_find(port_hw_id);
+
+    if (NULL == member || member->lag->hw_id != hw_id) {
+        err = ENOENT;
+        ERRNO_LOG_EXIT(err, "Port is not LAG member (port: %u, lag: %u)",
+                       port_hw_id, hw_id);
+    }
+
+    err = __lag_member_remove(member);
+
+exit:
+    return err;
+}
+
+/*
+ * Exclude LAG member from traffic distribution when its link goes down, and
+ * return it when link comes back up.
+ *
+ * @param[in] port_hw_id port label id.
+ * @param[in] up port operational state.
+ *
+ * @return 0 on success, sai status converted to errno value.
+ */
+static int
+__lag_port_state_set(uint32_t port_hw_id, bool up)
+{
+    struct lag_member_entry *member = __lag_member_find(port_hw_id);
+
+    if (NULL == member || member->egress_disabled == !up) {
+        return 0;
+    }
+
+    return __lag_member_egress_set(member, up);
+}
+
+/*
+ * De-initialize LAGs.
+ */
+static void
+__lag_deinit(void)
+{
+    int err = 0;
+    struct lag_entry *lag = NULL, *next_lag = NULL;
+
+    VLOG_INFO("De-initializing LAGs");
+
+    HMAP_FOR_EACH_SAFE(lag, next_lag, node, &lags) {
+        err = __lag_remove(lag->hw_id);
+        ERRNO_LOG(err, "Failed to remove LAG (label: %u)", lag->hw_id);
+    }
+    hmap_destroy(&lags);
+    hmap_destroy(&lag_members);
+}
+
+static struct lag_entry *
+__lag_find(uint32_t hw_id)
+{
+    struct lag_entry *lag = NULL;
+
+    HMAP_FOR_EACH_WITH_HASH(lag, node, hash_int(hw_id, 0), &lags) {
+        if (lag->hw_id == hw_id) {
+            return lag;
+        }
+    }
+
+    return NULL;
+}
+
+static struct lag_member_entry *
+__lag_member_find(uint32_t port_hw_id)
+{
+    struct lag_member_entry *member = NULL;
+
+    HMAP_FOR_EACH_WITH_HASH(member, node, hash_int(port_hw_id, 0),
+                            &lag_members) {
+        if (member->port_hw_id == port_hw_id) {
+            return member;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Get lowest free LAG label ID.
+ */
+static uint32_t
+__lag_hw_id_alloc(void)
+{
+    uint32_t hw_id = OPS_SAI_LAG_HW_ID_BASE;
+
+    while (__lag_find(hw_id)) {
+        hw_id++;
+    }
+
+    return hw_id;
+}
+
+static int
+__lag_member_remove(struct lag_member_entry *member)
+{
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
+
+    status = sai_api->lag_api->remove_lag_member(member->oid);
+    SAI_ERROR_LOG_EXIT(status, "Failed to remove LAG member "
+                       "(port: %u, lag: %u)", member->port_hw_id,
+                       member->lag->hw_id);
+
+    hmap_remove(&lag_members, &member->node);
+    free(member);
+
+exit:
+    return SAI_ERROR_2_ERRNO(status);
+}
+
+static int
+__lag_member_egress_set(struct lag_member_entry *member, bool enable)
+{
+    sai_attribute_t attr = { };
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
+
+    attr.id = SAI_LAG_MEMBER_ATTR_EGRESS_DISABLE;
+    attr.value.booldata = !enable;
+
+    status = sai_api->lag_api->set_lag_member_attribute(member->oid, &attr);
+    SAI_ERROR_LOG_EXIT(status, "Failed to %s LAG member egress "
+                       "(port: %u, lag: %u)", enable ? "enable" : "disable",
+                       member->port_hw_id, member->lag->hw_id);
+
+    member->egress_disabled = !enable;
+    VLOG_INFO("LAG member %s distribution (port: %u, lag: %u)",
+              enable ? "returned to" : "excluded from", member->port_hw_id,
+              member->lag->hw_id);
+
+exit:
+    return SAI_ERROR_2_ERRNO(status);
+}
+
+DEFINE_GENERIC_CLASS(struct lag_class, lag) = {
+    .init = __lag_init,
+    .create = __lag_create,
+    .remove = __lag_remove,
+    .member_add = __lag_member_add,
+    .member_del = __lag_member_del,
+    .port_state_set = __lag_port_state_set,
+    .deinit = __lag_deinit,
+};
+
+DEFINE_GENERIC_CLASS_GETTER(struct lag_class, lag);
@@ -14,6 +14,8 @@
 #include <openflow/openflow.h>
 #include <openswitch-idl.h>
 #include <openswitch-dflt.h>
+#include <hash.h>
+#include <hmap.h>
 #include <sai-api-class.h>
 #include <sai-log.h>
 #include <sai-common.h>
@@ -23,16 +25,25 @@
 
 VLOG_DEFINE_THIS_MODULE(netdev_sai);
 
-/* Protects 'sai_list'. */
+/* Protects 'sai_netdev_list' and port indexes. */
 static struct ovs_mutex sai_netdev_list_mutex = OVS_MUTEX_INITIALIZER;
 static struct ovs_list sai_netdev_list OVS_GUARDED_BY(sai_netdev_list_mutex)
     = OVS_LIST_INITIALIZER(&sai_netdev_list);
+/* Initialized port netdevs indexed by port object id and by hw_id. */
+static struct hmap sai_netdev_oid_map OVS_GUARDED_BY(sai_netdev_list_mutex)
+    = HMAP_INITIALIZER(&sai_netdev_oid_map);
+static struct hmap sai_netdev_hw_id_map OVS_GUARDED_BY(sai_netdev_list_mutex)
+    = HMAP_INITIALIZER(&sai_netdev_hw_id_map);
 
 struct netdev_sai {
     struct netdev up;
     struct ovs_list list_node OVS_GUARDED_BY(sai_netdev_list_mutex);
+    struct hmap_node oid_node OVS_GUARDED_BY(sai_netdev_list_mutex);
+    struct hmap_node hw_id_node OVS_GUARDED_BY(sai_netdev_list_mutex);
+    bool is_indexed OVS_GUARDED_BY(sai_netdev_list_mutex);
     struct ovs_mutex mutex OVS_ACQ_AFTER(sai_netdev_list_mutex);
     uint32_t hw_id;
+    sai_object_id_t port_oid;
     bool is_port_initialized;
     long long int carrier_resets;
     struct ops_sai_port_config default_config;
@@ -48,6 +59,10 @@ static struct netdev *__alloc(void);
 static int __construct(struct netdev *);
 static void __destruct(struct netdev *);
 static void __dealloc(struct netdev *);
+static void __netdev_sai_index_add(struct netdev_sai *);
+static void __netdev_sai_index_remove(struct netdev_sai *);
+static struct netdev_sai *__netdev_sai_lookup_by_oid(sai_object_id_t);
+static struct netdev_sai *__netdev_sai_lookup_by_hw_id(uint32_t);
 static int __set_hw_intf_info(struct netdev *, const struct smap *);
 static int __set_hw_intf_info_internal(struct netdev *netdev_,
                                                 const struct smap *args);
@@ -216,17 +231,13 @@ netdev_sai_hw_id_get(struct netdev *netdev_)
 void
 netdev_sai_port_oper_state_changed(sai_object_id_t oid, int link_status)
 {
-    struct netdev_sai *dev = NULL, *next_dev = NULL;
+    struct netdev_sai *dev = NULL;
 
-    LIST_FOR_EACH_SAFE(dev, next_dev, list_node, &sai_netdev_list) {
-        if (dev->is_port_initialized
-            && ops_sai_api_hw_id2port_id(dev->hw_id) == oid) {
-            break;
-        }
-    }
+    ovs_mutex_lock(&sai_netdev_list_mutex);
 
+    dev = __netdev_sai_lookup_by_oid(oid);
     if (NULL == dev) {
-        return;
+        goto exit;
     }
 
     if (link_status) {
@@ -235,6 +246,9 @@ netdev_sai_port_oper_state_changed(sai_object_id_t oid, int link_status)
 
     netdev_change_seq_changed(&(dev->up));
     seq_change(connectivity_seq_get());
+
+exit:
+    ovs_mutex_unlock(&sai_netdev_list_mutex);
 }
 
 /**
@@ -328,6 +342,7 @@ __destruct(struct netdev *netdev_)
         ops_sai_host_intf_netdev_remove(netdev_get_name(netdev_));
     }
 
+    __netdev_sai_index_remove(netdev);
     list_remove(&netdev->list_node);
     ovs_mutex_unlock(&sai_netdev_list_mutex);
     ovs_mutex_destroy(&netdev->mutex);
@@ -343,10 +358,89 @@ __dealloc(struct netdev *netdev_)
     free(netdev);
 }
 
+/*
+ * Add port netdev to object id and hw_id indexes.
+ */
+static void
+__netdev_sai_index_add(struct netdev_sai *netdev)
+{
+    ovs_mutex_lock(&sai_netdev_list_mutex);
+
+    if (__netdev_sai_lookup_by_hw_id(netdev->hw_id)) {
+        VLOG_ERR("Port already indexed (name: %s, hw_id: %u)",
+                 netdev_get_name(&netdev->up), netdev->hw_id);
+        goto exit;
+    }
+
+    hmap_insert(&sai_netdev_oid_map, &netdev->oid_node,
+                hash_uint64(netdev->port_oid));
+    hmap_insert(&sai_netdev_hw_id_map, &netdev->hw_id_node,
+                hash_int(netdev->hw_id, 0));
+    netdev->is_indexed = true;
+
+exit:
+    ovs_mutex_unlock(&sai_netdev_list_mutex);
+}
+
+/*
+ * Remove port netdev from indexes. Caller must hold sai_netdev_list_mutex.
+ */
+static void
+__netdev_sai_index_remove(struct netdev_sai *netdev)
+    OVS_REQUIRES(sai_netdev_list_mutex)
+{
+    if (!netdev->is_indexed) {
+        return;
+    }
+
+    hmap_remove(&sai_netdev_oid_map, &netdev->oid_node);
+    hmap_remove(&sai_netdev_hw_id_map, &netdev->hw_id_node);
+    netdev->is_indexed = false;
+}
+
+/*
+ * Find port netdev by port object id. Caller must hold sai_netdev_list_mutex.
+ */
+static struct netdev_sai *
+__netdev_sai_lookup_by_oid(sai_object_id_t oid)
+    OVS_REQUIRES(sai_netdev_list_mutex)
+{
+    struct netdev_sai *dev = NULL;
+
+    HMAP_FOR_EACH_WITH_HASH(dev, oid_node, hash_uint64(oid),
+                            &sai_netdev_oid_map) {
+        if (dev->port_oid == oid) {
+            return dev;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Find port netdev by hw_id. Caller must hold sai_netdev_list_mutex.
+ */
+static struct netdev_sai *
+__netdev_sai_lookup_by_hw_id(uint32_t hw_id)
+    OVS_REQUIRES(sai_netdev_list_mutex)
+{
+    struct netdev_sai *dev = NULL;
+
+    HMAP_FOR_EACH_WITH_HASH(dev, hw_id_node, hash_int(hw_id, 0),
+                            &sai_netdev_hw_id_map) {
+        if (dev->hw_id == hw_id) {
+            return dev;
+        }
+    }
+
+    return NULL;
+}
+
 static int
 __set_hw_intf_info(struct netdev *netdev_, const struct smap *args)
 {
     int status = 0;
+    bool initialized = false;
     struct eth_addr mac = { };
     handle_t hw_id_handle;
     struct netdev_sai *netdev = __netdev_sai_cast(netdev_);
@@ -365,6 +459,7 @@ __set_hw_intf_info(struct netdev *netdev_, const struct smap *args)
     }
 
     netdev->hw_id = hw_id;
+    netdev->port_oid = ops_sai_api_hw_id2port_id(hw_id);
 
     status = ops_sai_api_base_mac_get(&mac);
     ERRNO_EXIT(status);
@@ -386,9 +481,16 @@ __set_hw_intf_info(struct netdev *netdev_, const struct smap *args)
     ERRNO_EXIT(status);
 
     netdev->is_port_initialized = true;
+    initialized = true;
 
 exit:
     ovs_mutex_unlock(&netdev->mutex);
+
+    /* Index is guarded by the list mutex which must be taken first. */
+    if (initialized) {
+        __netdev_sai_index_add(netdev);
+    }
+
     return status;
 }
 
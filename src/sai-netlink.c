@@ -0,0 +1,503 @@
+/*
+ * Copyright Mellanox Technologies, Ltd. 2001-2016.
+ * This software product is licensed under Apache version 2, as detailed in
+ * the COPYING file.
+ */
+
+#include <errno.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <linux/if_link.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_addr.h>
+
+#include <util.h>
+#include <packets.h>
+#include <netlink.h>
+
+#include <sai-log.h>
+#include <sai-netlink.h>
+
+VLOG_DEFINE_THIS_MODULE(sai_netlink);
+
+static struct nl_sock *sai_rtnl_sock = NULL;
+
+static int __sock_get(void);
+static struct ofpbuf *__link_msg_start(struct ops_sai_netlink_batch *,
+                                       uint16_t, uint32_t, const char *);
+static void __vlan_info_data_put(struct ofpbuf *, const void *);
+static int __link_info_get(int, struct ops_sai_netlink_link_state *);
+static int __link_addrs_get(int, struct ops_sai_netlink_link_state *);
+static void __addr_add(struct ops_sai_netlink_batch *, int,
+                       const struct ops_sai_netlink_addr *);
+
+/**
+ * Initialize empty batch.
+ *
+ * @param[in] batch - pointer to batch.
+ */
+void
+ops_sai_netlink_batch_init(struct ops_sai_netlink_batch *batch)
+{
+    NULL_PARAM_LOG_ABORT(batch);
+
+    batch->n = 0;
+}
+
+/**
+ * Drop all requests in batch without sending them.
+ *
+ * @param[in] batch - pointer to batch.
+ */
+void
+ops_sai_netlink_batch_destroy(struct ops_sai_netlink_batch *batch)
+{
+    size_t i = 0;
+
+    NULL_PARAM_LOG_ABORT(batch);
+
+    for (i = 0; i < batch->n; i++) {
+        ofpbuf_uninit(&batch->requests[i]);
+    }
+    batch->n = 0;
+}
+
+/**
+ * Send all requests in batch to kernel and wait for acknowledgements.
+ * Batch is empty after commit.
+ *
+ * @param[in] batch - pointer to batch.
+ *
+ * @return 0 operation completed successfully
+ * @return errno of first failed request
+ */
+int
+ops_sai_netlink_batch_commit(struct ops_sai_netlink_batch *batch)
+{
+    size_t i = 0;
+    int status = 0;
+    struct nl_transaction *txnsp[OPS_SAI_NETLINK_BATCH_MAX];
+
+    NULL_PARAM_LOG_ABORT(batch);
+
+    if (!batch->n) {
+        goto exit;
+    }
+
+    status = __sock_get();
+    ERRNO_EXIT(status);
+
+    for (i = 0; i < batch->n; i++) {
+        batch->txns[i].request = &batch->requests[i];
+        batch->txns[i].reply = NULL;
+        batch->txns[i].error = 0;
+        txnsp[i] = &batch->txns[i];
+    }
+
+    nl_sock_transact_multiple(sai_rtnl_sock, txnsp, batch->n);
+
+    for (i = 0; i < batch->n; i++) {
+        if (batch->txns[i].error) {
+            VLOG_ERR("Netlink link request failed (request: %"PRIuSIZE
+                     ", error: %s)", i, ovs_strerror(batch->txns[i].error));
+            status = status ? status : batch->txns[i].error;
+        }
+    }
+
+exit:
+    ops_sai_netlink_batch_destroy(batch);
+    return status;
+}
+
+/**
+ * Queue creation of link.
+ *
+ * @param[in] batch   - pointer to batch.
+ * @param[in] name    - link name.
+ * @param[in] ifindex - requested link index or 0 to let kernel pick one.
+ * @param[in] kind    - link kind (IFLA_INFO_KIND).
+ * @param[in] parent  - name of lower link or NULL.
+ * @param[in] mac     - MAC address or NULL.
+ * @param[in] cb      - puts kind specific attributes or NULL.
+ * @param[in] aux     - argument of cb.
+ */
+void
+ops_sai_netlink_link_add(struct ops_sai_netlink_batch *batch, const char *name,
+                         int ifindex, const char *kind, const char *parent,
+                         const struct eth_addr *mac,
+                         ops_sai_netlink_info_data_cb cb, const void *aux)
+{
+    size_t linkinfo_off = 0;
+    size_t data_off = 0;
+    struct ofpbuf *msg = NULL;
+    struct ifinfomsg *ifi = NULL;
+
+    NULL_PARAM_LOG_ABORT(kind);
+
+    msg = __link_msg_start(batch, RTM_NEWLINK, NLM_F_CREATE | NLM_F_EXCL,
+                           name);
+    ifi = ofpbuf_at_assert(msg, NLMSG_HDRLEN, sizeof *ifi);
+    ifi->ifi_index = ifindex;
+
+    if (parent) {
+        nl_msg_put_u32(msg, IFLA_LINK, if_nametoindex(parent));
+    }
+
+    if (mac) {
+        nl_msg_put_unspec(msg, IFLA_ADDRESS, mac->ea, ETH_ADDR_LEN);
+    }
+
+    linkinfo_off = nl_msg_start_nested(msg, IFLA_LINKINFO);
+    nl_msg_put_string(msg, IFLA_INFO_KIND, kind);
+    if (cb) {
+        data_off = nl_msg_start_nested(msg, IFLA_INFO_DATA);
+        cb(msg, aux);
+        nl_msg_end_nested(msg, data_off);
+    }
+    nl_msg_end_nested(msg, linkinfo_off);
+}
+
+/**
+ * Queue creation of 802.1Q link.
+ *
+ * @param[in] batch  - pointer to batch.
+ * @param[in] name   - link name.
+ * @param[in] parent - name of lower link.
+ * @param[in] vid    - VLAN ID.
+ * @param[in] mac    - MAC address or NULL.
+ */
+void
+ops_sai_netlink_vlan_add(struct ops_sai_netlink_batch *batch, const char *name,
+                         const char *parent, uint16_t vid,
+                         const struct eth_addr *mac)
+{
+    NULL_PARAM_LOG_ABORT(parent);
+
+    ops_sai_netlink_link_add(batch, name, 0, "vlan", parent, mac,
+                             __vlan_info_data_put, &vid);
+}
+
+/**
+ * Queue removal of link.
+ *
+ * @param[in] batch - pointer to batch.
+ * @param[in] name  - link name.
+ */
+void
+ops_sai_netlink_link_del(struct ops_sai_netlink_batch *batch, const char *name)
+{
+    __link_msg_start(batch, RTM_DELLINK, 0, name);
+}
+
+/**
+ * Queue MAC address change of link.
+ *
+ * @param[in] batch - pointer to batch.
+ * @param[in] name  - link name.
+ * @param[in] mac   - MAC address.
+ */
+void
+ops_sai_netlink_link_set_address(struct ops_sai_netlink_batch *batch,
+                                 const char *name,
+                                 const struct eth_addr *mac)
+{
+    struct ofpbuf *msg = NULL;
+
+    NULL_PARAM_LOG_ABORT(mac);
+
+    msg = __link_msg_start(batch, RTM_NEWLINK, 0, name);
+    nl_msg_put_unspec(msg, IFLA_ADDRESS, mac->ea, ETH_ADDR_LEN);
+}
+
+/**
+ * Queue administrative state change of link.
+ *
+ * @param[in] batch - pointer to batch.
+ * @param[in] name  - link name.
+ * @param[in] up    - true to set link up.
+ */
+void
+ops_sai_netlink_link_set_up(struct ops_sai_netlink_batch *batch,
+                            const char *name, bool up)
+{
+    struct ofpbuf *msg = __link_msg_start(batch, RTM_NEWLINK, 0, name);
+    struct ifinfomsg *ifi = ofpbuf_at_assert(msg, NLMSG_HDRLEN, sizeof *ifi);
+
+    ifi->ifi_change = IFF_UP;
+    ifi->ifi_flags = up ? IFF_UP : 0;
+}
+
+/**
+ * Read index, administrative state, MTU and IP addresses of link. IPv6 link
+ * addresses are skipped as kernel configures them.
+ *
+ * @param[in]  name  - link name.
+ * @param[out] state - link state.
+ *
+ * @return 0 operation completed successfully
+ * @return errno operation failed
+ */
+int
+ops_sai_netlink_link_state_get(const char *name,
+                               struct ops_sai_netlink_link_state *state)
+{
+    int status = 0;
+    int ifindex = 0;
+
+    NULL_PARAM_LOG_ABORT(name);
+    NULL_PARAM_LOG_ABORT(state);
+
+    memset(state, 0, sizeof *state);
+
+    ifindex = if_nametoindex(name);
+    if (!ifindex) {
+        status = ENODEV;
+        ERRNO_LOG_EXIT(status, "Failed to get link index (name: %s)", name);
+    }
+
+    state->ifindex = ifindex;
+
+    status = __link_info_get(ifindex, state);
+    ERRNO_LOG_EXIT(status, "Failed to get link info (name: %s)", name);
+
+    status = __link_addrs_get(ifindex, state);
+    ERRNO_LOG_EXIT(status, "Failed to get link addresses (name: %s)", name);
+
+exit:
+    return status;
+}
+
+/**
+ * Queue restore of state read by ops_sai_netlink_link_state_get(). MTU and
+ * administrative state go in one request, followed by one request per
+ * address, so link re-created in the same batch is restored with single
+ * commit.
+ *
+ * @param[in] batch   - pointer to batch.
+ * @param[in] name    - link name.
+ * @param[in] ifindex - link index addresses are assigned to.
+ * @param[in] state   - link state.
+ */
+void
+ops_sai_netlink_link_state_put(struct ops_sai_netlink_batch *batch,
+                               const char *name, int ifindex,
+                               const struct ops_sai_netlink_link_state *state)
+{
+    size_t i = 0;
+    struct ofpbuf *msg = NULL;
+    struct ifinfomsg *ifi = NULL;
+
+    NULL_PARAM_LOG_ABORT(state);
+
+    msg = __link_msg_start(batch, RTM_NEWLINK, 0, name);
+    ifi = ofpbuf_at_assert(msg, NLMSG_HDRLEN, sizeof *ifi);
+    ifi->ifi_change = IFF_UP;
+    ifi->ifi_flags = state->up ? IFF_UP : 0;
+    if (state->mtu) {
+        nl_msg_put_u32(msg, IFLA_MTU, state->mtu);
+    }
+
+    for (i = 0; i < state->n_addrs; i++) {
+        __addr_add(batch, ifindex, &state->addrs[i]);
+    }
+}
+
+/*
+ * Create rtnetlink socket on first use.
+ */
+static int
+__sock_get(void)
+{
+    int status = 0;
+
+    if (sai_rtnl_sock) {
+        goto exit;
+    }
+
+    status = nl_sock_create(NETLINK_ROUTE, &sai_rtnl_sock);
+    ERRNO_LOG_EXIT(status, "Failed to create rtnetlink socket");
+
+exit:
+    return status;
+}
+
+/*
+ * Read flags and MTU of link.
+ */
+static int
+__link_info_get(int ifindex, struct ops_sai_netlink_link_state *state)
+{
+    static const struct nl_policy policy[] = {
+        [IFLA_MTU] = { .type = NL_A_U32, .optional = true },
+    };
+    int status = 0;
+    struct ofpbuf request;
+    struct ofpbuf *reply = NULL;
+    struct ifinfomsg *ifi = NULL;
+    struct nlattr *attrs[ARRAY_SIZE(policy)];
+
+    status = __sock_get();
+    ERRNO_EXIT(status);
+
+    ofpbuf_init(&request, 0);
+    nl_msg_put_nlmsghdr(&request, sizeof *ifi, RTM_GETLINK, NLM_F_REQUEST);
+    ifi = ofpbuf_put_zeros(&request, sizeof *ifi);
+    ifi->ifi_family = AF_UNSPEC;
+    ifi->ifi_index = ifindex;
+
+    status = nl_sock_transact(sai_rtnl_sock, &request, &reply);
+    ofpbuf_uninit(&request);
+    ERRNO_EXIT(status);
+
+    ifi = ofpbuf_at(reply, NLMSG_HDRLEN, sizeof *ifi);
+    if (!ifi || !nl_policy_parse(reply, NLMSG_HDRLEN + sizeof *ifi,
+                                 policy, attrs, ARRAY_SIZE(policy))) {
+        status = EPROTO;
+        goto exit;
+    }
+
+    state->up = !!(ifi->ifi_flags & IFF_UP);
+    state->mtu = attrs[IFLA_MTU] ? nl_attr_get_u32(attrs[IFLA_MTU]) : 0;
+
+exit:
+    ofpbuf_delete(reply);
+    return status;
+}
+
+/*
+ * Dump IP addresses of link.
+ */
+static int
+__link_addrs_get(int ifindex, struct ops_sai_netlink_link_state *state)
+{
+    struct nl_dump dump;
+    struct ofpbuf request, reply, buf;
+    struct ifaddrmsg *ifa = NULL;
+    struct ops_sai_netlink_addr *addr = NULL;
+    const struct nlattr *addr_attr = NULL;
+    uint64_t reply_stub[NL_DUMP_BUFSIZE / 8];
+    static const struct nl_policy policy[] = {
+        [IFA_ADDRESS] = { .type = NL_A_UNSPEC, .optional = true },
+        [IFA_LOCAL] = { .type = NL_A_UNSPEC, .optional = true },
+    };
+    struct nlattr *attrs[ARRAY_SIZE(policy)];
+
+    ofpbuf_init(&request, 0);
+    nl_msg_put_nlmsghdr(&request, sizeof *ifa, RTM_GETADDR, NLM_F_REQUEST);
+    ifa = ofpbuf_put_zeros(&request, sizeof *ifa);
+    ifa->ifa_family = AF_UNSPEC;
+
+    nl_dump_start(&dump, NETLINK_ROUTE, &request);
+    ofpbuf_uninit(&request);
+
+    ofpbuf_use_stub(&buf, reply_stub, sizeof reply_stub);
+    while (nl_dump_next(&dump, &reply, &buf)) {
+        ifa = ofpbuf_at(&reply, NLMSG_HDRLEN, sizeof *ifa);
+        if (!ifa || ifa->ifa_index != ifindex
+            || (ifa->ifa_family != AF_INET && ifa->ifa_family != AF_INET6)) {
+            continue;
+        }
+
+        if (!nl_policy_parse(&reply, NLMSG_HDRLEN + sizeof *ifa, policy,
+                             attrs, ARRAY_SIZE(policy))) {
+            continue;
+        }
+
+        addr_attr = attrs[IFA_LOCAL] ? attrs[IFA_LOCAL] : attrs[IFA_ADDRESS];
+        if (!addr_attr) {
+            continue;
+        }
+
+        if (state->n_addrs == OPS_SAI_NETLINK_ADDR_MAX) {
+            VLOG_WARN("Too many addresses on link (ifindex: %d)", ifindex);
+            break;
+        }
+
+        addr = &state->addrs[state->n_addrs];
+        addr->family = ifa->ifa_family;
+        addr->prefixlen = ifa->ifa_prefixlen;
+
+        if (AF_INET == ifa->ifa_family
+            && nl_attr_get_size(addr_attr) == sizeof addr->ip4) {
+            memcpy(&addr->ip4, nl_attr_get(addr_attr), sizeof addr->ip4);
+        } else if (AF_INET6 == ifa->ifa_family
+                   && nl_attr_get_size(addr_attr) == sizeof addr->ip6) {
+            memcpy(&addr->ip6, nl_attr_get(addr_attr), sizeof addr->ip6);
+            if (IN6_IS_ADDR_LINKLOCAL(&addr->ip6)) {
+                continue;
+            }
+        } else {
+            continue;
+        }
+
+        state->n_addrs++;
+    }
+    ofpbuf_uninit(&buf);
+
+    return nl_dump_done(&dump);
+}
+
+/*
+ * Queue IP address assignment to link.
+ */
+static void
+__addr_add(struct ops_sai_netlink_batch *batch, int ifindex,
+           const struct ops_sai_netlink_addr *addr)
+{
+    struct ofpbuf *msg = NULL;
+    struct ifaddrmsg *ifa = NULL;
+    size_t len = AF_INET == addr->family ? sizeof addr->ip4
+                                         : sizeof addr->ip6;
+
+    ovs_assert(batch->n < OPS_SAI_NETLINK_BATCH_MAX);
+
+    msg = &batch->requests[batch->n++];
+    ofpbuf_init(msg, 0);
+
+    nl_msg_put_nlmsghdr(msg, sizeof *ifa, RTM_NEWADDR,
+                        NLM_F_REQUEST | NLM_F_ACK | NLM_F_CREATE
+                        | NLM_F_REPLACE);
+    ifa = ofpbuf_put_zeros(msg, sizeof *ifa);
+    ifa->ifa_family = addr->family;
+    ifa->ifa_prefixlen = addr->prefixlen;
+    ifa->ifa_index = ifindex;
+
+    if (AF_INET == addr->family) {
+        nl_msg_put_unspec(msg, IFA_LOCAL, &addr->ip4, len);
+    }
+    nl_msg_put_unspec(msg, IFA_ADDRESS, &addr->ip4, len);
+}
+
+/*
+ * Append new link request addressed by name to batch.
+ */
+static struct ofpbuf *
+__link_msg_start(struct ops_sai_netlink_batch *batch, uint16_t type,
+                 uint32_t flags, const char *name)
+{
+    struct ofpbuf *msg = NULL;
+    struct ifinfomsg *ifi = NULL;
+
+    NULL_PARAM_LOG_ABORT(batch);
+    NULL_PARAM_LOG_ABORT(name);
+    ovs_assert(batch->n < OPS_SAI_NETLINK_BATCH_MAX);
+
+    msg = &batch->requests[batch->n++];
+    ofpbuf_init(msg, 0);
+
+    nl_msg_put_nlmsghdr(msg, sizeof *ifi, type,
+                        NLM_F_REQUEST | NLM_F_ACK | flags);
+    ifi = ofpbuf_put_zeros(msg, sizeof *ifi);
+    ifi->ifi_family = AF_UNSPEC;
+    nl_msg_put_string(msg, IFLA_IFNAME, name);
+
+    return msg;
+}
+
+static void
+__vlan_info_data_put(struct ofpbuf *msg, const void *aux)
+{
+    const uint16_t *vid = aux;
+
+    nl_msg_put_u16(msg, IFLA_VLAN_ID, *vid);
+}
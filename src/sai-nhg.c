@@ -0,0 +1,722 @@
+/*
+ * Copyright Mellanox Technologies, Ltd. 2001-2016.
+ * This software product is licensed under Apache version 2, as detailed in
+ * the COPYING file.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <util.h>
+#include <hash.h>
+#include <unixctl.h>
+#include <dynamic-string.h>
+
+#include <sai-log.h>
+#include <sai-route.h>
+#include <sai-nhg.h>
+
+/* Upper bound of buckets accepted from user, hardware limit may be lower. */
+#define NHG_BUCKETS_MAX (4096)
+/* Weight of next hop that has neither configured nor derived one. */
+#define NHG_WEIGHT_DEFAULT (1)
+
+VLOG_DEFINE_THIS_MODULE(sai_nhg);
+
+/* Weights of next hops, shared by all routes of virtual router. */
+struct nhg_weight {
+    struct hmap_node node;          /* In 'nhg_weights', by vrid and next
+                                     * hop. */
+    uint64_t vrid;
+    char *next_hop;
+    uint32_t configured;            /* Set by user, 0 if not set. */
+    uint32_t derived;               /* From egress port speed, 0 if unknown. */
+    bool down;                      /* Egress ports are down. */
+};
+
+static struct hmap nhgs = HMAP_INITIALIZER(&nhgs);
+static struct hmap nhg_weights = HMAP_INITIALIZER(&nhg_weights);
+/* Number of buckets of new groups, 0 if resilient hashing is disabled. */
+static size_t nhg_resilient_buckets = 0;
+
+static uint32_t __nhg_hash(uint64_t, const char *);
+static struct ops_sai_nhg_member *__nhg_member_find(struct ops_sai_nhg *,
+                                                    const char *);
+static struct nhg_weight *__nhg_weight_find(uint64_t, const char *);
+static uint32_t __nhg_weight_effective(const struct nhg_weight *);
+static void __nhg_targets_get(const struct ops_sai_nhg *, size_t *);
+static long __nhg_shortage(const struct ops_sai_nhg *, const size_t *,
+                           size_t);
+static void __nhg_rebalance(struct ops_sai_nhg *, bool);
+static void __nhg_member_add(struct ops_sai_nhg *, const char *);
+static void __nhg_member_del(struct ops_sai_nhg *,
+                             struct ops_sai_nhg_member *);
+static void __nhg_show(struct unixctl_conn *, int, const char *[], void *);
+static void __nhg_resilient(struct unixctl_conn *, int, const char *[],
+                            void *);
+static void __nhg_weight_cmd(struct unixctl_conn *, int, const char *[],
+                             void *);
+
+/**
+ * Initialize next hop groups.
+ */
+void
+ops_sai_nhg_init(void)
+{
+    hmap_init(&nhgs);
+    hmap_init(&nhg_weights);
+    nhg_resilient_buckets = 0;
+
+    unixctl_command_register("sai/ecmp/buckets", "[prefix]", 0, 1,
+                             __nhg_show, NULL);
+    unixctl_command_register("sai/ecmp/resilient", "[buckets|off]", 0, 1,
+                             __nhg_resilient, NULL);
+    unixctl_command_register("sai/ecmp/weight",
+                             "vrid next_hop [weight|default]",
+                             2, 3, __nhg_weight_cmd, NULL);
+}
+
+/**
+ * De-initialize next hop groups. Routes are not touched.
+ */
+void
+ops_sai_nhg_deinit(void)
+{
+    struct ops_sai_nhg *nhg = NULL, *next_nhg = NULL;
+    struct nhg_weight *weight = NULL, *next_weight = NULL;
+
+    HMAP_FOR_EACH_SAFE(nhg, next_nhg, node, &nhgs) {
+        ops_sai_nhg_destroy(nhg);
+    }
+    hmap_destroy(&nhgs);
+
+    HMAP_FOR_EACH_SAFE(weight, next_weight, node, &nhg_weights) {
+        hmap_remove(&nhg_weights, &weight->node);
+        free(weight->next_hop);
+        free(weight);
+    }
+    hmap_destroy(&nhg_weights);
+}
+
+/**
+ * Get number of buckets new next hop groups are created with.
+ *
+ * @return number of buckets, 0 if resilient hashing is disabled.
+ */
+size_t
+ops_sai_nhg_resilient_buckets(void)
+{
+    return nhg_resilient_buckets;
+}
+
+/**
+ * Find next hop group of route.
+ *
+ * @param[in] vrid   - virtual router ID.
+ * @param[in] prefix - route prefix.
+ *
+ * @return pointer to group, NULL if route has no next hops.
+ */
+struct ops_sai_nhg *
+ops_sai_nhg_find(uint64_t vrid, const char *prefix)
+{
+    struct ops_sai_nhg *nhg = NULL;
+
+    HMAP_FOR_EACH_WITH_HASH(nhg, node, __nhg_hash(vrid, prefix), &nhgs) {
+        if (nhg->vrid == vrid && !strcmp(nhg->prefix, prefix)) {
+            return nhg;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Create empty next hop group of route.
+ *
+ * @param[in] vrid      - virtual router ID.
+ * @param[in] prefix    - route prefix.
+ * @param[in] n_buckets - number of buckets, 0 for plain ECMP.
+ *
+ * @return pointer to group.
+ */
+struct ops_sai_nhg *
+ops_sai_nhg_create(uint64_t vrid, const char *prefix, size_t n_buckets)
+{
+    struct ops_sai_nhg *nhg = xzalloc(sizeof *nhg);
+
+    nhg->vrid = vrid;
+    nhg->prefix = xstrdup(prefix);
+    nhg->n_buckets = n_buckets;
+    nhg->buckets = xcalloc(n_buckets, sizeof *nhg->buckets);
+    hmap_insert(&nhgs, &nhg->node, __nhg_hash(vrid, prefix));
+
+    return nhg;
+}
+
+/**
+ * Destroy next hop group.
+ *
+ * @param[in] nhg - next hop group.
+ */
+void
+ops_sai_nhg_destroy(struct ops_sai_nhg *nhg)
+{
+    size_t i = 0;
+
+    if (NULL == nhg) {
+        return;
+    }
+
+    for (i = 0; i < nhg->n_members; i++) {
+        free(nhg->members[i].next_hop);
+    }
+
+    hmap_remove(&nhgs, &nhg->node);
+    free(nhg->members);
+    free(nhg->buckets);
+    free(nhg->prefix);
+    free(nhg);
+}
+
+/**
+ * Add next hops to group. Each new next hop takes its share of buckets from
+ * next hops owning more than theirs.
+ *
+ * @param[in] nhg            - next hop group.
+ * @param[in] next_hop_count - count of next hops.
+ * @param[in] next_hops      - list of next hops.
+ *
+ * @return true if buckets were reassigned.
+ */
+bool
+ops_sai_nhg_members_add(struct ops_sai_nhg *nhg, uint32_t next_hop_count,
+                        char *const *const next_hops)
+{
+    uint32_t i = 0;
+    bool changed = false;
+
+    for (i = 0; i < next_hop_count; i++) {
+        if (__nhg_member_find(nhg, next_hops[i])) {
+            continue;
+        }
+
+        __nhg_member_add(nhg, next_hops[i]);
+        changed = true;
+    }
+
+    return changed;
+}
+
+/**
+ * Remove next hops from group. Only buckets of removed next hops are
+ * reassigned, to next hops owning less than their share.
+ *
+ * @param[in] nhg            - next hop group.
+ * @param[in] next_hop_count - count of next hops.
+ * @param[in] next_hops      - list of next hops.
+ *
+ * @return true if buckets were reassigned.
+ */
+bool
+ops_sai_nhg_members_del(struct ops_sai_nhg *nhg, uint32_t next_hop_count,
+                        char *const *const next_hops)
+{
+    uint32_t i = 0;
+    bool changed = false;
+    struct ops_sai_nhg_member *member = NULL;
+
+    for (i = 0; i < next_hop_count; i++) {
+        member = __nhg_member_find(nhg, next_hops[i]);
+        if (NULL == member) {
+            continue;
+        }
+
+        __nhg_member_del(nhg, member);
+        changed = true;
+    }
+
+    return changed;
+}
+
+/**
+ * Spread next hops of plain ECMP group over buckets, so that they can be
+ * weighted.
+ *
+ * @param[in] nhg       - next hop group without buckets.
+ * @param[in] n_buckets - number of buckets.
+ */
+void
+ops_sai_nhg_buckets_set(struct ops_sai_nhg *nhg, size_t n_buckets)
+{
+    ovs_assert(!nhg->n_buckets);
+    ovs_assert(n_buckets);
+
+    free(nhg->buckets);
+    nhg->buckets = xcalloc(n_buckets, sizeof *nhg->buckets);
+    nhg->n_buckets = n_buckets;
+
+    __nhg_rebalance(nhg, false);
+}
+
+/**
+ * Check if next hops of group have different weights.
+ *
+ * @param[in] nhg - next hop group.
+ *
+ * @return true if traffic should not be shared equally.
+ */
+bool
+ops_sai_nhg_is_weighted(const struct ops_sai_nhg *nhg)
+{
+    size_t i = 0;
+
+    for (i = 1; i < nhg->n_members; i++) {
+        if (nhg->members[i].weight != nhg->members[0].weight) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Get weight of next hop. Weight configured by user takes precedence over
+ * weight derived from egress port speed.
+ *
+ * @param[in] vrid     - virtual router ID.
+ * @param[in] next_hop - next hop IP address.
+ *
+ * @return weight, 1 if next hop has none, 0 if its egress ports are down.
+ */
+uint32_t
+ops_sai_nhg_weight_get(uint64_t vrid, const char *next_hop)
+{
+    return __nhg_weight_effective(__nhg_weight_find(vrid, next_hop));
+}
+
+/**
+ * Set weight of next hop and rebalance buckets of groups of virtual router
+ * it is member of.
+ *
+ * @param[in] vrid       - virtual router ID.
+ * @param[in] next_hop   - next hop IP address.
+ * @param[in] weight     - weight, 0 to unset, OPS_SAI_ROUTE_NH_WEIGHT_DOWN
+ *                         if egress ports are down.
+ * @param[in] configured - weight is configured by user, otherwise it is
+ *                         derived from egress port speed.
+ * @param[in] program    - called for every group the next hop is member of,
+ *                         if its effective weight changed.
+ *
+ * @return 0 operation completed successfully
+ * @return errno returned by 'program' for the last failed group
+ */
+int
+ops_sai_nhg_weight_set(uint64_t vrid, const char *next_hop, uint32_t weight,
+                       bool configured, int (*program)(struct ops_sai_nhg *))
+{
+    int err = 0;
+    int status = 0;
+    uint32_t old_weight = 0;
+    uint32_t new_weight = 0;
+    struct ops_sai_nhg *nhg = NULL;
+    struct ops_sai_nhg_member *member = NULL;
+    struct nhg_weight *entry = __nhg_weight_find(vrid, next_hop);
+
+    old_weight = __nhg_weight_effective(entry);
+
+    if (NULL == entry) {
+        entry = xzalloc(sizeof *entry);
+        entry->vrid = vrid;
+        entry->next_hop = xstrdup(next_hop);
+        hmap_insert(&nhg_weights, &entry->node, __nhg_hash(vrid, next_hop));
+    }
+
+    if (configured) {
+        entry->configured = weight;
+    } else {
+        entry->down = OPS_SAI_ROUTE_NH_WEIGHT_DOWN == weight;
+        entry->derived = entry->down ? 0 : weight;
+    }
+
+    new_weight = __nhg_weight_effective(entry);
+
+    if (!entry->configured && !entry->derived && !entry->down) {
+        hmap_remove(&nhg_weights, &entry->node);
+        free(entry->next_hop);
+        free(entry);
+    }
+
+    if (old_weight == new_weight) {
+        return 0;
+    }
+
+    VLOG_INFO("Setting next hop weight (vrid: %"PRIu64", next hop: %s, "
+              "weight: %u)", vrid, next_hop, new_weight);
+
+    HMAP_FOR_EACH(nhg, node, &nhgs) {
+        if (nhg->vrid != vrid) {
+            continue;
+        }
+
+        member = __nhg_member_find(nhg, next_hop);
+        if (NULL == member) {
+            continue;
+        }
+
+        member->weight = new_weight;
+        __nhg_rebalance(nhg, false);
+
+        status = program(nhg);
+        ERRNO_LOG(status, "Failed to apply next hop weight "
+                  "(prefix: %s, next hop: %s)", nhg->prefix, next_hop);
+        if (status) {
+            err = status;
+        }
+    }
+
+    return err;
+}
+
+static uint32_t
+__nhg_hash(uint64_t vrid, const char *prefix)
+{
+    return hash_string(prefix, hash_uint64(vrid));
+}
+
+static struct ops_sai_nhg_member *
+__nhg_member_find(struct ops_sai_nhg *nhg, const char *next_hop)
+{
+    size_t i = 0;
+
+    for (i = 0; i < nhg->n_members; i++) {
+        if (!strcmp(nhg->members[i].next_hop, next_hop)) {
+            return &nhg->members[i];
+        }
+    }
+
+    return NULL;
+}
+
+static struct nhg_weight *
+__nhg_weight_find(uint64_t vrid, const char *next_hop)
+{
+    struct nhg_weight *weight = NULL;
+
+    HMAP_FOR_EACH_WITH_HASH(weight, node, __nhg_hash(vrid, next_hop),
+                            &nhg_weights) {
+        if (weight->vrid == vrid && !strcmp(weight->next_hop, next_hop)) {
+            return weight;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Next hop with egress ports down gets no buckets, even if its weight is
+ * configured, as traffic sent to it is lost.
+ */
+static uint32_t
+__nhg_weight_effective(const struct nhg_weight *weight)
+{
+    if (NULL == weight) {
+        return NHG_WEIGHT_DEFAULT;
+    }
+
+    if (weight->down) {
+        return 0;
+    }
+
+    return weight->configured ? weight->configured :
+           weight->derived ? weight->derived : NHG_WEIGHT_DEFAULT;
+}
+
+/*
+ * Get number of buckets each member is entitled to. Buckets are shared in
+ * proportion to weights, remainder goes to members with largest fractions.
+ * Members with weight 0 get no buckets, unless all members have weight 0.
+ */
+static void
+__nhg_targets_get(const struct ops_sai_nhg *nhg, size_t *targets)
+{
+    size_t i = 0;
+    size_t best = 0;
+    size_t assigned = 0;
+    uint64_t total = 0;
+    uint64_t *weights = xcalloc(nhg->n_members, sizeof *weights);
+    uint64_t *remainders = xcalloc(nhg->n_members, sizeof *remainders);
+
+    for (i = 0; i < nhg->n_members; i++) {
+        total += nhg->members[i].weight;
+    }
+
+    /* Route is blackholed anyway, keep buckets spread evenly. */
+    for (i = 0; i < nhg->n_members; i++) {
+        weights[i] = total ? nhg->members[i].weight : 1;
+    }
+    total = total ? total : nhg->n_members;
+
+    for (i = 0; i < nhg->n_members; i++) {
+        targets[i] = (uint64_t) nhg->n_buckets * weights[i] / total;
+        remainders[i] = (uint64_t) nhg->n_buckets * weights[i] % total;
+        assigned += targets[i];
+    }
+
+    for (; assigned < nhg->n_buckets; assigned++) {
+        best = 0;
+        for (i = 1; i < nhg->n_members; i++) {
+            if (remainders[i] > remainders[best]) {
+                best = i;
+            }
+        }
+        targets[best]++;
+        remainders[best] = 0;
+    }
+
+    free(weights);
+    free(remainders);
+}
+
+static long
+__nhg_shortage(const struct ops_sai_nhg *nhg, const size_t *targets,
+               size_t idx)
+{
+    return (long) targets[idx] - (long) nhg->members[idx].n_buckets;
+}
+
+/*
+ * Move buckets of members owning more than their share to members owning
+ * less, largest shortage first. Buckets of other members are not touched.
+ * If 'orphans_only', only buckets without owner are assigned.
+ */
+static void
+__nhg_rebalance(struct ops_sai_nhg *nhg, bool orphans_only)
+{
+    size_t i = 0;
+    size_t j = 0;
+    size_t owner = 0;
+    size_t taker = 0;
+    size_t *targets = NULL;
+
+    if (!nhg->n_buckets || !nhg->n_members) {
+        return;
+    }
+
+    targets = xcalloc(nhg->n_members, sizeof *targets);
+    __nhg_targets_get(nhg, targets);
+
+    for (i = 0; i < nhg->n_buckets; i++) {
+        for (owner = 0; owner < nhg->n_members; owner++) {
+            if (nhg->buckets[i] == nhg->members[owner].next_hop) {
+                break;
+            }
+        }
+
+        if (owner < nhg->n_members &&
+            (orphans_only || __nhg_shortage(nhg, targets, owner) >= 0)) {
+            continue;
+        }
+
+        taker = 0;
+        for (j = 1; j < nhg->n_members; j++) {
+            if (__nhg_shortage(nhg, targets, j) >
+                __nhg_shortage(nhg, targets, taker)) {
+                taker = j;
+            }
+        }
+
+        /* Bucket without owner is given away even if nobody is short of
+         * buckets, which happens when remaining members already own more
+         * than their share. */
+        if (owner < nhg->n_members &&
+            __nhg_shortage(nhg, targets, taker) <= 0) {
+            continue;
+        }
+
+        if (owner < nhg->n_members) {
+            nhg->members[owner].n_buckets--;
+        }
+        nhg->buckets[i] = nhg->members[taker].next_hop;
+        nhg->members[taker].n_buckets++;
+    }
+
+    free(targets);
+}
+
+static void
+__nhg_member_add(struct ops_sai_nhg *nhg, const char *next_hop)
+{
+    struct ops_sai_nhg_member *member = NULL;
+
+    nhg->members = xrealloc(nhg->members,
+                            (nhg->n_members + 1) * sizeof *nhg->members);
+    member = &nhg->members[nhg->n_members++];
+    member->next_hop = xstrdup(next_hop);
+    member->weight = ops_sai_nhg_weight_get(nhg->vrid, next_hop);
+    member->n_buckets = 0;
+
+    __nhg_rebalance(nhg, false);
+}
+
+static void
+__nhg_member_del(struct ops_sai_nhg *nhg, struct ops_sai_nhg_member *member)
+{
+    size_t i = 0;
+    size_t idx = member - nhg->members;
+
+    for (i = 0; i < nhg->n_buckets; i++) {
+        if (nhg->buckets[i] == member->next_hop) {
+            nhg->buckets[i] = NULL;
+        }
+    }
+
+    free(member->next_hop);
+    memmove(member, member + 1,
+            (nhg->n_members - idx - 1) * sizeof *member);
+    nhg->n_members--;
+
+    __nhg_rebalance(nhg, true);
+}
+
+/*
+ * appctl sai/ecmp/buckets: show next hops of remote routes and bucket to
+ * next hop map of resilient ones.
+ */
+static void
+__nhg_show(struct unixctl_conn *conn, int argc, const char *argv[],
+           void *aux OVS_UNUSED)
+{
+    size_t i = 0;
+    struct ops_sai_nhg *nhg = NULL;
+    struct ds ds = DS_EMPTY_INITIALIZER;
+
+    HMAP_FOR_EACH(nhg, node, &nhgs) {
+        if (argc > 1 && strcmp(argv[1], nhg->prefix)) {
+            continue;
+        }
+
+        ds_put_format(&ds, "Route %s (vrid: %"PRIu64"), ", nhg->prefix,
+                      nhg->vrid);
+        if (nhg->n_buckets) {
+            ds_put_format(&ds, "%"PRIuSIZE" buckets, ", nhg->n_buckets);
+        } else {
+            ds_put_cstr(&ds, "not resilient, ");
+        }
+        ds_put_format(&ds, "%"PRIuSIZE" next hops\n", nhg->n_members);
+        for (i = 0; i < nhg->n_members; i++) {
+            ds_put_format(&ds, "  %-40s weight %-6"PRIu32,
+                          nhg->members[i].next_hop, nhg->members[i].weight);
+            if (nhg->n_buckets) {
+                ds_put_format(&ds, " %"PRIuSIZE" buckets",
+                              nhg->members[i].n_buckets);
+            }
+            ds_put_char(&ds, '\n');
+        }
+        for (i = 0; i < nhg->n_buckets; i++) {
+            ds_put_format(&ds, "  %6"PRIuSIZE": %s\n", i,
+                          nhg->buckets[i] ? nhg->buckets[i] : "-");
+        }
+    }
+
+    if (!ds.length) {
+        ds_put_cstr(&ds, "No next hop groups\n");
+    }
+
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
+}
+
+/*
+ * appctl sai/ecmp/resilient: enable resilient hashing with given number of
+ * buckets, or disable it. Applies to routes added afterwards.
+ */
+static void
+__nhg_resilient(struct unixctl_conn *conn, int argc, const char *argv[],
+                void *aux OVS_UNUSED)
+{
+    char *end = NULL;
+    unsigned long n_buckets = 0;
+    struct ds ds = DS_EMPTY_INITIALIZER;
+
+    if (argc > 1 && strcmp(argv[1], "off")) {
+        errno = 0;
+        n_buckets = strtoul(argv[1], &end, 10);
+        if (errno || *end || !n_buckets || n_buckets > NHG_BUCKETS_MAX) {
+            unixctl_command_reply_error(conn, "Invalid number of buckets");
+            return;
+        }
+    }
+
+    if (argc > 1) {
+        nhg_resilient_buckets = n_buckets;
+    }
+
+    if (nhg_resilient_buckets) {
+        ds_put_format(&ds, "Resilient hashing: %"PRIuSIZE" buckets\n",
+                      nhg_resilient_buckets);
+    } else {
+        ds_put_cstr(&ds, "Resilient hashing: off\n");
+    }
+
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
+}
+
+/*
+ * appctl sai/ecmp/weight: show or configure weight of next hop in virtual
+ * router, vrid is the one shown by sai/ecmp/buckets. Configured weight
+ * overrides the one derived from egress port speed, "default" returns to
+ * derived weight.
+ */
+static void
+__nhg_weight_cmd(struct unixctl_conn *conn, int argc, const char *argv[],
+                 void *aux OVS_UNUSED)
+{
+    int err = 0;
+    char *end = NULL;
+    unsigned long weight = 0;
+    handle_t vrid = HANDLE_INITIALIZAER;
+    struct ds ds = DS_EMPTY_INITIALIZER;
+    const struct nhg_weight *entry = NULL;
+
+    errno = 0;
+    vrid.data = strtoull(argv[1], &end, 10);
+    if (errno || *end || end == argv[1]) {
+        unixctl_command_reply_error(conn, "Invalid vrid");
+        return;
+    }
+
+    if (argc > 3) {
+        if (strcmp(argv[3], "default")) {
+            errno = 0;
+            weight = strtoul(argv[3], &end, 10);
+            if (errno || *end || !weight || weight > UINT32_MAX) {
+                unixctl_command_reply_error(conn, "Invalid weight");
+                return;
+            }
+        }
+
+        err = ops_sai_route_nh_weight_set(&vrid, argv[2], weight, true);
+        if (err) {
+            unixctl_command_reply_error(conn, "Failed to set weight");
+            return;
+        }
+    }
+
+    entry = __nhg_weight_find(vrid.data, argv[2]);
+    ds_put_format(&ds, "Next hop %s (vrid: %"PRIu64"): weight %"PRIu32,
+                  argv[2], vrid.data, __nhg_weight_effective(entry));
+    if (entry && entry->down) {
+        ds_put_cstr(&ds, " (egress down)");
+    } else if (entry && entry->configured) {
+        ds_put_cstr(&ds, " (configured)");
+    } else if (entry && entry->derived) {
+        ds_put_cstr(&ds, " (port speed)");
+    }
+    ds_put_char(&ds, '\n');
+
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
+}
@@ -5,15 +5,21 @@
  */
 
 #include <errno.h>
+#include <net/if.h>
 
 #include <seq.h>
+#include <connectivity.h>
 #include <coverage.h>
 #include <hmap.h>
+#include <hmapx.h>
 #include <vlan-bitmap.h>
 #include <socket-util.h>
 #include <ofproto/ofproto-provider.h>
 #include <ofproto/bond.h>
 #include <ofproto/tunnel.h>
+#include <ofp-actions.h>
+#include <dp-packet.h>
+#include <timeval.h>
 
 #include <vswitch-idl.h>
 #include <openswitch-idl.h>
@@ -30,6 +36,12 @@
 #include <sai-route.h>
 #include <sai-neighbor.h>
 #include <sai-hash.h>
+#include <sai-event.h>
+#include <sai-rx.h>
+#include <sai-acl.h>
+#include <sai-lag.h>
+#include <sai-nhg.h>
+#include <sai-sflow.h>
 
 #define SAI_INTERFACE_TYPE_SYSTEM "system"
 #define SAI_INTERFACE_TYPE_VRF "vrf"
@@ -41,15 +53,21 @@ struct ofproto_sai {
     struct ofproto up;
     struct hmap_node all_ofproto_sai_node;      /* In 'all_ofproto_dpifs'. */
     struct hmap bundles;        /* Contains "struct ofbundle"s. */
+    struct hmap bundle_ports;   /* Contains "struct ofport_sai"s which are in
+                                 * a bundle, by netdev name. */
     struct sset ports;          /* Set of standard port names. */
     struct sset ghost_ports;    /* Ports with no datapath port. */
     handle_t vrid;
+    uint64_t connectivity_seqno;    /* Port state seen by next hop weights
+                                     * of VRF. */
 };
 
 struct ofport_sai {
     struct ofport up;
     struct ofbundle_sai *bundle;        /* Bundle that contains this port */
     struct ovs_list bundle_node;        /* In struct ofbundle's "ports" list. */
+    struct hmap_node name_node;         /* In struct ofproto's "bundle_ports"
+                                         * hmap. */
 };
 
 struct ofbundle_sai {
@@ -65,6 +83,13 @@ struct ofbundle_sai {
     unsigned long *trunks;      /* Bitmap of trunked VLANs, if 'vlan' == -1.
                                  * NULL if all VLANs are trunked. */
 
+    /* LAG of system ports, created when bundle has more than one of them.
+     * VLANs and router interface are bound to LAG instead of ports. */
+    struct {
+        bool created;
+        uint32_t hw_id;         /* LAG label ID. */
+    } lag;
+
     /* L3 interface */
     struct {
         bool created;
@@ -90,6 +115,16 @@ struct ofproto_sai_group {
     struct ofgroup up;
 };
 
+struct rule_sai {
+    struct rule up;
+    struct ops_sai_acl_rule acl;    /* Compiled ACL rule. */
+    bool installed;                 /* 'handle' refers to hardware entry. */
+    handle_t handle;
+    struct ops_sai_acl_stats base;  /* Stats forwarded from replaced rule. */
+    uint64_t last_packets;
+    long long int used;
+};
+
 struct port_dump_state {
     uint32_t bucket;
     uint32_t offset;
@@ -100,6 +135,8 @@ struct port_dump_state {
 
 /* All existing ofproto provider instances, indexed by ->up.name. */
 static struct hmap all_ofproto_sai = HMAP_INITIALIZER(&all_ofproto_sai);
+/* sFlow is switch wide, it is enabled with options of this ofproto. */
+static struct ofproto_sai *sflow_owner = NULL;
 
 static const unsigned long empty_trunks[BITMAP_N_LONGS(VLAN_BITMAP_SIZE)];
 
@@ -140,14 +177,35 @@ static void __rule_get_stats(struct rule *, uint64_t *, uint64_t *,
                              long long int *);
 static enum ofperr __rule_execute(struct rule *, const struct flow *,
                                   struct dp_packet *);
+static inline struct rule_sai *__rule_sai_cast(const struct rule *);
+static enum ofperr __rule_match_compile(const struct ofproto_sai *,
+                                        const struct minimatch *,
+                                        struct ops_sai_acl_rule *);
+static enum ofperr __rule_actions_compile(const struct ofproto_sai *,
+                                          const struct rule_actions *,
+                                          struct ops_sai_acl_rule *);
+static void __rule_uninstall(struct rule_sai *);
+static void __rule_stats_read(struct rule_sai *, struct ops_sai_acl_stats *);
 static bool __set_frag_handling(struct ofproto *, enum ofp_config_flags);
 static enum ofperr __packet_out(struct ofproto *, struct dp_packet *,
                                 const struct flow *, const struct ofpact *,
                                 size_t);
+static enum ofperr __packet_out_port_get(const struct ofproto_sai *,
+                                         const struct flow *,
+                                         const struct ofpact *, uint32_t *,
+                                         bool *);
+static int __set_sflow(struct ofproto *,
+                       const struct ofproto_sflow_options *);
 static int __ofbundle_port_add(struct ofbundle_sai *, struct ofport_sai *);
 static int __ofbundle_port_del(struct ofport_sai *);
 static void __trunks_realloc(struct ofbundle_sai *, const unsigned long *);
 static int __native_tagged_vlan_set(int, uint32_t, bool);
+static bool __ofport_is_system(const struct ofport_sai *);
+static size_t __ofbundle_l2_ids_get(const struct ofbundle_sai *, uint32_t **);
+static int __ofbundle_lag_set(struct ofbundle_sai *, bool);
+static uint32_t __ofbundle_nh_weight_get(const struct ofbundle_sai *);
+static void __ofbundle_nh_weights_update(const struct ofbundle_sai *);
+static void __vrf_nh_weights_run(struct ofproto_sai *);
 static int __vlan_reconfigure(struct ofbundle_sai *,
                               const struct ofproto_bundle_settings *);
 static int __ofbundle_ports_reconfigure(struct ofbundle_sai *,
@@ -212,6 +270,8 @@ static int __l3_route_action(const struct ofproto *, enum ofproto_route_action,
                              struct ofproto_route *);
 static int __l3_ecmp_set(const struct ofproto *, bool);
 static int __l3_ecmp_hash_set(const struct ofproto *, unsigned int, bool);
+static int __type_run(const char *);
+static void __type_wait(const char *);
 static int __run(struct ofproto *);
 static void __wait(struct ofproto *);
 static void __set_tables_version(struct ofproto *, cls_version_t);
@@ -224,8 +284,8 @@ const struct ofproto_class ofproto_sai_class = {
     PROVIDER_INIT_GENERIC(enumerate_names,       __enumerate_names)
     PROVIDER_INIT_GENERIC(del,                   __del)
     PROVIDER_INIT_GENERIC(port_open_type,        __port_open_type)
-    PROVIDER_INIT_GENERIC(type_run,              NULL)
-    PROVIDER_INIT_GENERIC(type_wait,             NULL)
+    PROVIDER_INIT_GENERIC(type_run,              __type_run)
+    PROVIDER_INIT_GENERIC(type_wait,             __type_wait)
     PROVIDER_INIT_GENERIC(alloc,                 __alloc)
     PROVIDER_INIT_GENERIC(construct,             __construct)
     PROVIDER_INIT_GENERIC(destruct,              __destruct)
@@ -267,7 +327,7 @@ const struct ofproto_class ofproto_sai_class = {
     PROVIDER_INIT_GENERIC(packet_out,            __packet_out)
     PROVIDER_INIT_GENERIC(set_netflow,           NULL)
     PROVIDER_INIT_GENERIC(get_netflow_ids,       NULL)
-    PROVIDER_INIT_GENERIC(set_sflow,             NULL)
+    PROVIDER_INIT_GENERIC(set_sflow,             __set_sflow)
     PROVIDER_INIT_GENERIC(set_ipfix,             NULL)
     PROVIDER_INIT_GENERIC(set_cfm,               NULL)
     PROVIDER_INIT_GENERIC(cfm_status_changed,    NULL)
@@ -335,14 +395,20 @@ __init(const struct shash *iface_hints)
     ops_sai_api_init();
     ops_sai_port_init();
     ops_sai_vlan_init();
+    ops_sai_lag_init();
     ops_sai_policer_init();
+    ops_sai_acl_init();
     ops_sai_router_init();
     ops_sai_host_intf_init();
     ops_sai_router_intf_init();
     ops_sai_neighbor_init();
+    ops_sai_nhg_init();
     ops_sai_route_init();
     ops_sai_host_intf_traps_register();
     ops_sai_ecmp_hash_init();
+    ops_sai_hash_unixctl_register();
+    ops_sai_sflow_init();
+    ops_sai_sflow_unixctl_register();
 }
 
 static void
@@ -377,14 +443,20 @@ __del(const char *type, const char *name)
 {
     SAI_API_TRACE_FN();
 
+    ops_sai_sflow_set(NULL);
+    sflow_owner = NULL;
+    ops_sai_sflow_deinit();
     ops_sai_ecmp_hash_deinit();
     ops_sai_host_intf_traps_unregister();
     ops_sai_route_deinit();
+    ops_sai_nhg_deinit();
     ops_sai_neighbor_deinit();
     ops_sai_router_intf_deinit();
     ops_sai_host_intf_deinit();
     ops_sai_router_deinit();
+    ops_sai_acl_deinit();
     ops_sai_policer_deinit();
+    ops_sai_lag_deinit();
     ops_sai_vlan_deinit();
     ops_sai_port_deinit();
     ops_sai_api_uninit();
@@ -442,17 +514,19 @@ __construct(struct ofproto *ofproto_)
 
     sset_init(&ofproto->ports);
     sset_init(&ofproto->ghost_ports);
-    /* Currently ACL is not supported. Implementation will be added in a
-     * future. */
+    /* Single OpenFlow table. Rules of "system" ofproto are offloaded to
+     * switch-wide ingress ACL table. */
     ofproto_init_tables(ofproto_, 1);
 
     hmap_init(&ofproto->bundles);
+    hmap_init(&ofproto->bundle_ports);
     hmap_insert(&all_ofproto_sai, &ofproto->all_ofproto_sai_node,
                 hash_string(ofproto->up.name, 0));
 
     if (STR_EQ(ofproto_->type, SAI_INTERFACE_TYPE_VRF)) {
         error = ops_sai_router_create(&ofproto->vrid);
         ERRNO_EXIT(error);
+        ofproto->connectivity_seqno = seq_read(connectivity_seq_get());
     }
 
 exit:
@@ -462,6 +536,7 @@ exit:
 static void
 __destruct(struct ofproto *ofproto_ OVS_UNUSED)
 {
+    int err = 0;
     struct ofproto_sai *ofproto = __ofproto_sai_cast(ofproto_);
 
     SAI_API_TRACE_FN();
@@ -470,8 +545,15 @@ __destruct(struct ofproto *ofproto_ OVS_UNUSED)
         ops_sai_router_remove(&ofproto->vrid);
     }
 
+    if (sflow_owner == ofproto) {
+        err = ops_sai_sflow_set(NULL);
+        ERRNO_LOG(err, "Failed to disable sFlow of %s", ofproto_->name);
+        sflow_owner = NULL;
+    }
+
     sset_destroy(&ofproto->ghost_ports);
     sset_destroy(&ofproto->ports);
+    hmap_destroy(&ofproto->bundle_ports);
 
     hmap_remove(&all_ofproto_sai, &ofproto->all_ofproto_sai_node);
 }
@@ -505,15 +587,31 @@ __port_alloc(void)
 static int
 __port_construct(struct ofport *port_)
 {
+    struct ofport_sai *port = __ofport_sai_cast(port_);
+
     SAI_API_TRACE_FN();
 
+    /* Front panel ports are sampled whenever sFlow is enabled. Samples
+     * carry index of port host interface, which has the name of netdev. */
+    if (__ofport_is_system(port)) {
+        ops_sai_sflow_port_set(netdev_sai_hw_id_get(port_->netdev),
+                               if_nametoindex(netdev_get_name(port_->netdev)),
+                               true);
+    }
+
     return 0;
 }
 
 static void
-__port_destruct(struct ofport *port_ OVS_UNUSED)
+__port_destruct(struct ofport *port_)
 {
+    struct ofport_sai *port = __ofport_sai_cast(port_);
+
     SAI_API_TRACE_FN();
+
+    if (__ofport_is_system(port)) {
+        ops_sai_sflow_port_set(netdev_sai_hw_id_get(port_->netdev), 0, false);
+    }
 }
 
 static void
@@ -663,61 +761,387 @@ __port_dump_done(const struct ofproto *ofproto_, void *state_)
 static struct rule *
 __rule_alloc(void)
 {
-    struct rule *rule = xzalloc(sizeof *rule);
+    struct rule_sai *rule = xzalloc(sizeof *rule);
 
-    SAI_API_TRACE_NOT_IMPLEMENTED_FN();
+    SAI_API_TRACE_FN();
 
-    return rule;
+    return &rule->up;
 }
 
 static void
 __rule_dealloc(struct rule *rule_)
 {
-    SAI_API_TRACE_NOT_IMPLEMENTED_FN();
+    SAI_API_TRACE_FN();
+
+    free(__rule_sai_cast(rule_));
+}
 
-    free(rule_);
+/*
+ * Cast OpenFlow rule to rule_sai.
+ */
+static inline struct rule_sai *
+__rule_sai_cast(const struct rule *rule)
+{
+    ovs_assert(rule);
+    return CONTAINER_OF(rule, struct rule_sai, up);
 }
 
 static enum ofperr
 __rule_construct(struct rule *rule_)
 {
-    SAI_API_TRACE_NOT_IMPLEMENTED_FN();
+    int status = 0;
+    enum ofperr error = 0;
+    struct rule_sai *rule = __rule_sai_cast(rule_);
+    struct ofproto_sai *ofproto = __ofproto_sai_cast(rule_->ofproto);
+
+    SAI_API_TRACE_FN();
+
+    rule->used = time_msec();
+
+    /* Rules of VRF have no ACL table and would never be enforced. */
+    if (STR_EQ(ofproto->up.type, SAI_INTERFACE_TYPE_VRF)) {
+        return OFPERR_OFPFMFC_UNKNOWN;
+    }
+
+    /* ACL rule priority is 16 bits wide, never truncate it. */
+    if (rule_->cr.priority < 0 || rule_->cr.priority > UINT16_MAX) {
+        return OFPERR_OFPFMFC_BAD_PRIORITY;
+    }
+
+    memset(&rule->acl, 0, sizeof rule->acl);
+    rule->acl.priority = rule_->cr.priority;
+
+    error = __rule_match_compile(ofproto, &rule_->cr.match, &rule->acl);
+    if (error) {
+        return error;
+    }
+
+    error = __rule_actions_compile(ofproto, rule_get_actions(rule_),
+                                   &rule->acl);
+    if (error) {
+        return error;
+    }
+
+    /* Rule which ACL can not take is rejected, rather than reported as
+     * installed while hardware does not enforce it. */
+    status = ops_sai_acl_rule_check(&rule->acl);
+    if (ERANGE == status) {
+        return OFPERR_OFPFMFC_BAD_PRIORITY;
+    } else if (status) {
+        return OFPERR_OFPFMFC_UNKNOWN;
+    }
+
+    return 0;
+}
+
+/*
+ * Translate OpenFlow match to ACL rule fields. IP fields are translated only
+ * for exact IPv4 or IPv6 ethertype, L4 ports only for exact TCP, UDP or SCTP
+ * protocol, so e.g. ICMP type and code are never matched as ports.
+ *
+ * @return OFPERR_OFPBMC_BAD_FIELD if match has field, which can't be offloaded.
+ */
+static enum ofperr
+__rule_match_compile(const struct ofproto_sai *ofproto,
+                     const struct minimatch *minimatch,
+                     struct ops_sai_acl_rule *acl)
+{
+    struct match match;
+    struct flow_wildcards rest;
+    const struct flow *flow = &match.flow;
+    const struct flow_wildcards *wc = &match.wc;
+    struct ofport_sai *port = NULL;
+    bool is_ipv4 = false, is_ipv6 = false, is_l4 = false;
+
+    minimatch_expand(minimatch, &match);
+    rest = match.wc;
+
+    if (wc->masks.dl_type == OVS_BE16_MAX) {
+        is_ipv4 = flow->dl_type == htons(ETH_TYPE_IP);
+        is_ipv6 = flow->dl_type == htons(ETH_TYPE_IPV6);
+    }
+    if ((is_ipv4 || is_ipv6) && wc->masks.nw_proto == UINT8_MAX) {
+        is_l4 = flow->nw_proto == IPPROTO_TCP
+                || flow->nw_proto == IPPROTO_UDP
+                || flow->nw_proto == IPPROTO_SCTP;
+    }
+
+    if (wc->masks.in_port.ofp_port) {
+        port = __get_ofp_port(ofproto, flow->in_port.ofp_port);
+        if (!port || !STR_EQ(netdev_get_type(port->up.netdev),
+                             OVSREC_INTERFACE_TYPE_SYSTEM)) {
+            return OFPERR_OFPBMC_BAD_VALUE;
+        }
+
+        acl->fields |= OPS_SAI_ACL_FIELD_IN_PORT;
+        acl->in_port = netdev_sai_hw_id_get(port->up.netdev);
+        rest.masks.in_port.ofp_port = 0;
+    }
+
+    if (!eth_addr_is_zero(wc->masks.dl_src)) {
+        acl->fields |= OPS_SAI_ACL_FIELD_SRC_MAC;
+        acl->src_mac = flow->dl_src;
+        acl->src_mac_mask = wc->masks.dl_src;
+        rest.masks.dl_src = eth_addr_zero;
+    }
+
+    if (!eth_addr_is_zero(wc->masks.dl_dst)) {
+        acl->fields |= OPS_SAI_ACL_FIELD_DST_MAC;
+        acl->dst_mac = flow->dl_dst;
+        acl->dst_mac_mask = wc->masks.dl_dst;
+        rest.masks.dl_dst = eth_addr_zero;
+    }
+
+    if (wc->masks.dl_type == OVS_BE16_MAX) {
+        acl->fields |= OPS_SAI_ACL_FIELD_ETHER_TYPE;
+        acl->ether_type = ntohs(flow->dl_type);
+        rest.masks.dl_type = 0;
+    }
+
+    /* Only exact VLAN ID match of tagged packets is supported. */
+    if (wc->masks.vlan_tci == htons(VLAN_VID_MASK | VLAN_CFI)
+        && flow->vlan_tci & htons(VLAN_CFI)) {
+        acl->fields |= OPS_SAI_ACL_FIELD_VLAN_ID;
+        acl->vlan_id = vlan_tci_to_vid(flow->vlan_tci);
+        rest.masks.vlan_tci = 0;
+    }
+
+    if (is_ipv4 && wc->masks.nw_src) {
+        acl->fields |= OPS_SAI_ACL_FIELD_SRC_IP;
+        acl->src_ip = ntohl(flow->nw_src);
+        acl->src_ip_mask = ntohl(wc->masks.nw_src);
+        rest.masks.nw_src = 0;
+    }
+
+    if (is_ipv4 && wc->masks.nw_dst) {
+        acl->fields |= OPS_SAI_ACL_FIELD_DST_IP;
+        acl->dst_ip = ntohl(flow->nw_dst);
+        acl->dst_ip_mask = ntohl(wc->masks.nw_dst);
+        rest.masks.nw_dst = 0;
+    }
+
+    if (is_ipv6 && !ipv6_mask_is_any(&wc->masks.ipv6_src)) {
+        acl->fields |= OPS_SAI_ACL_FIELD_SRC_IPV6;
+        acl->src_ipv6 = flow->ipv6_src;
+        acl->src_ipv6_mask = wc->masks.ipv6_src;
+        rest.masks.ipv6_src = in6addr_any;
+    }
+
+    if (is_ipv6 && !ipv6_mask_is_any(&wc->masks.ipv6_dst)) {
+        acl->fields |= OPS_SAI_ACL_FIELD_DST_IPV6;
+        acl->dst_ipv6 = flow->ipv6_dst;
+        acl->dst_ipv6_mask = wc->masks.ipv6_dst;
+        rest.masks.ipv6_dst = in6addr_any;
+    }
+
+    if ((is_ipv4 || is_ipv6) && wc->masks.nw_proto == UINT8_MAX) {
+        acl->fields |= OPS_SAI_ACL_FIELD_IP_PROTO;
+        acl->ip_proto = flow->nw_proto;
+        rest.masks.nw_proto = 0;
+    }
+
+    /* ECN bits can't be matched. */
+    if ((is_ipv4 || is_ipv6) && wc->masks.nw_tos == IP_DSCP_MASK) {
+        acl->fields |= OPS_SAI_ACL_FIELD_DSCP;
+        acl->dscp = (flow->nw_tos & IP_DSCP_MASK) >> 2;
+        rest.masks.nw_tos = 0;
+    }
+
+    if (is_l4 && wc->masks.tp_src) {
+        acl->fields |= OPS_SAI_ACL_FIELD_L4_SRC;
+        acl->l4_src = ntohs(flow->tp_src);
+        acl->l4_src_mask = ntohs(wc->masks.tp_src);
+        rest.masks.tp_src = 0;
+    }
+
+    if (is_l4 && wc->masks.tp_dst) {
+        acl->fields |= OPS_SAI_ACL_FIELD_L4_DST;
+        acl->l4_dst = ntohs(flow->tp_dst);
+        acl->l4_dst_mask = ntohs(wc->masks.tp_dst);
+        rest.masks.tp_dst = 0;
+    }
+
+    /* Only 8 bits of TCP flags are present in hardware. */
+    if (is_l4 && flow->nw_proto == IPPROTO_TCP && wc->masks.tcp_flags
+        && !(wc->masks.tcp_flags & ~htons(UINT8_MAX))) {
+        acl->fields |= OPS_SAI_ACL_FIELD_TCP_FLAGS;
+        acl->tcp_flags = ntohs(flow->tcp_flags);
+        acl->tcp_flags_mask = ntohs(wc->masks.tcp_flags);
+        rest.masks.tcp_flags = 0;
+    }
+
+    if (!flow_wildcards_is_catchall(&rest)) {
+        return OFPERR_OFPBMC_BAD_FIELD;
+    }
+
+    return 0;
+}
+
+/*
+ * Translate OpenFlow actions to ACL rule action. Empty action list drops
+ * packet, output to NORMAL forwards it and output to CONTROLLER traps it.
+ * Single output to other port redirects packet to that port.
+ *
+ * @return OFPERR_OFPBAC_* if actions can't be offloaded.
+ */
+static enum ofperr
+__rule_actions_compile(const struct ofproto_sai *ofproto,
+                       const struct rule_actions *actions,
+                       struct ops_sai_acl_rule *acl)
+{
+    size_t n_outputs = 0;
+    ofp_port_t out_port = OFPP_NONE;
+    const struct ofpact *a = NULL;
+    struct ofport_sai *port = NULL;
+
+    acl->action = OPS_SAI_ACL_ACTION_DROP;
+
+    OFPACT_FOR_EACH (a, actions->ofpacts, actions->ofpacts_len) {
+        if (++n_outputs > 1) {
+            return OFPERR_OFPBAC_TOO_MANY;
+        }
+
+        switch (a->type) {
+        case OFPACT_CONTROLLER:
+            acl->action = OPS_SAI_ACL_ACTION_TRAP;
+            break;
+        case OFPACT_OUTPUT:
+            out_port = ofpact_get_OUTPUT(a)->port;
+            if (OFPP_NORMAL == out_port) {
+                acl->action = OPS_SAI_ACL_ACTION_FORWARD;
+                break;
+            }
+
+            if (OFPP_CONTROLLER == out_port) {
+                acl->action = OPS_SAI_ACL_ACTION_TRAP;
+                break;
+            }
+
+            port = __get_ofp_port(ofproto, out_port);
+            if (!port || !STR_EQ(netdev_get_type(port->up.netdev),
+                                 OVSREC_INTERFACE_TYPE_SYSTEM)) {
+                return OFPERR_OFPBAC_BAD_OUT_PORT;
+            }
+
+            acl->action = OPS_SAI_ACL_ACTION_REDIRECT;
+            acl->redirect_port = netdev_sai_hw_id_get(port->up.netdev);
+            break;
+        default:
+            return OFPERR_OFPBAC_BAD_TYPE;
+        }
+    }
 
     return 0;
 }
 
 static void
-__rule_insert(struct rule *rule_,
-                        struct rule *old_rule,
-                        bool forward_stats)
+__rule_insert(struct rule *rule_, struct rule *old_rule_, bool forward_stats)
 {
-    SAI_API_TRACE_NOT_IMPLEMENTED_FN();
+    int status = 0;
+    struct rule_sai *rule = __rule_sai_cast(rule_);
+    struct rule_sai *old_rule = NULL;
+    static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(5, 5);
+
+    SAI_API_TRACE_FN();
+
+    /* Install new entry first, so there is no window without one. */
+    status = ops_sai_acl_rule_add(&rule->acl, &rule->handle);
+    if (status) {
+        VLOG_WARN_RL(&rl, "Failed to offload OpenFlow rule "
+                     "(priority: %"PRIu16", error: %s)",
+                     rule->acl.priority, ovs_strerror(status));
+    } else {
+        rule->installed = true;
+    }
+
+    if (!old_rule_) {
+        return;
+    }
+
+    old_rule = __rule_sai_cast(old_rule_);
+    if (forward_stats) {
+        rule->used = old_rule->used;
+        /* Old entry keeps counting until next commit, let ACL forward its
+         * final counters. */
+        if (old_rule->installed && rule->installed
+            && !ops_sai_acl_rule_stats_forward(&old_rule->handle,
+                                               &rule->handle)) {
+            rule->base = old_rule->base;
+        } else {
+            __rule_stats_read(old_rule, &rule->base);
+        }
+    }
+    __rule_uninstall(old_rule);
 }
 
 static void
 __rule_delete(struct rule *rule_)
 {
-    SAI_API_TRACE_NOT_IMPLEMENTED_FN();
+    SAI_API_TRACE_FN();
 
-    return;
+    __rule_uninstall(__rule_sai_cast(rule_));
 }
 
 static void
 __rule_destruct(struct rule *rule_)
 {
-    SAI_API_TRACE_NOT_IMPLEMENTED_FN();
+    SAI_API_TRACE_FN();
 
-    return;
+    __rule_uninstall(__rule_sai_cast(rule_));
 }
 
+/*
+ * Remove hardware entry of rule. Safe to call more than once.
+ */
 static void
-__rule_get_stats(struct rule *rule_, uint64_t *packets,
-                           uint64_t *bytes OVS_UNUSED,
-                           long long int *used OVS_UNUSED)
+__rule_uninstall(struct rule_sai *rule)
 {
-    SAI_API_TRACE_NOT_IMPLEMENTED_FN();
+    int status = 0;
 
-    return;
+    if (!rule->installed) {
+        return;
+    }
+
+    status = ops_sai_acl_rule_remove(&rule->handle);
+    ERRNO_LOG(status, "Failed to remove OpenFlow rule from hardware "
+              "(priority: %"PRIu16")", rule->acl.priority);
+    rule->installed = false;
+}
+
+/*
+ * Read rule counters including stats forwarded from replaced rules.
+ */
+static void
+__rule_stats_read(struct rule_sai *rule, struct ops_sai_acl_stats *stats)
+{
+    struct ops_sai_acl_stats hw_stats = { 0 };
+
+    if (rule->installed
+        && !ops_sai_acl_rule_stats_get(&rule->handle, &hw_stats)) {
+        if (hw_stats.packets != rule->last_packets) {
+            rule->last_packets = hw_stats.packets;
+            rule->used = time_msec();
+        }
+    }
+
+    stats->packets = rule->base.packets + hw_stats.packets;
+    stats->bytes = rule->base.bytes + hw_stats.bytes;
+}
+
+static void
+__rule_get_stats(struct rule *rule_, uint64_t *packets, uint64_t *bytes,
+                 long long int *used)
+{
+    struct ops_sai_acl_stats stats = { 0 };
+    struct rule_sai *rule = __rule_sai_cast(rule_);
+
+    SAI_API_TRACE_FN();
+
+    __rule_stats_read(rule, &stats);
+
+    *packets = stats.packets;
+    *bytes = stats.bytes;
+    *used = rule->used;
 }
 
 static enum ofperr
@@ -738,12 +1162,88 @@ __set_frag_handling(struct ofproto *ofproto_,
     return false;
 }
 
+/*
+ * Send packet from CPU. Output to ofport bypasses pipeline, NORMAL and TABLE
+ * outputs are forwarded by pipeline. Packet data is handed to SAI without
+ * copying. Actions are validated before anything is sent, so packet is not
+ * sent partially.
+ *
+ * @return OFPERR_OFPBAC_BAD_TYPE if action other than output is given.
+ * @return OFPERR_OFPBAC_BAD_OUT_PORT if output port is unknown or not
+ *         supported, or if sending to it failed.
+ */
 static enum ofperr
 __packet_out(struct ofproto *ofproto_, struct dp_packet *packet,
                        const struct flow *flow,
                        const struct ofpact *ofpacts, size_t ofpacts_len)
 {
-    SAI_API_TRACE_NOT_IMPLEMENTED_FN();
+    int status = 0;
+    uint32_t hw_id = 0;
+    bool is_bypass = false;
+    enum ofperr error = 0;
+    const struct ofpact *a = NULL;
+    struct ofproto_sai *ofproto = __ofproto_sai_cast(ofproto_);
+    static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(5, 5);
+
+    OFPACT_FOR_EACH (a, ofpacts, ofpacts_len) {
+        error = __packet_out_port_get(ofproto, flow, a, &hw_id, &is_bypass);
+        if (error) {
+            VLOG_WARN_RL(&rl, "Rejected packet out action (type: %s)",
+                         ofpact_name(a->type));
+            return error;
+        }
+    }
+
+    OFPACT_FOR_EACH (a, ofpacts, ofpacts_len) {
+        __packet_out_port_get(ofproto, flow, a, &hw_id, &is_bypass);
+        status = ops_sai_host_intf_packet_send(dp_packet_data(packet),
+                                               dp_packet_size(packet),
+                                               is_bypass ? &hw_id : NULL);
+        if (status) {
+            return OFPERR_OFPBAC_BAD_OUT_PORT;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Resolve output action of packet out.
+ *
+ * @param[out] hw_id     - egress port label id, set if is_bypass is set.
+ * @param[out] is_bypass - false if packet is forwarded by pipeline.
+ *
+ * @return OFPERR_OFPBAC_* if action can't be executed.
+ */
+static enum ofperr
+__packet_out_port_get(const struct ofproto_sai *ofproto,
+                      const struct flow *flow, const struct ofpact *a,
+                      uint32_t *hw_id, bool *is_bypass)
+{
+    ofp_port_t out_port = OFPP_NONE;
+    struct ofport_sai *port = NULL;
+
+    if (OFPACT_OUTPUT != a->type) {
+        return OFPERR_OFPBAC_BAD_TYPE;
+    }
+
+    out_port = ofpact_get_OUTPUT(a)->port;
+    if (OFPP_IN_PORT == out_port) {
+        out_port = flow->in_port.ofp_port;
+    }
+
+    if (OFPP_NORMAL == out_port || OFPP_TABLE == out_port) {
+        *is_bypass = false;
+        return 0;
+    }
+
+    port = __get_ofp_port(ofproto, out_port);
+    if (!port || !__ofport_is_system(port)) {
+        return OFPERR_OFPBAC_BAD_OUT_PORT;
+    }
+
+    *is_bypass = true;
+    *hw_id = netdev_sai_hw_id_get(port->up.netdev);
 
     return 0;
 }
@@ -770,8 +1270,13 @@ __ofbundle_port_add(struct ofbundle_sai *bundle, struct ofport_sai *port)
 
     port->bundle = bundle;
     list_push_back(&bundle->ports, &port->bundle_node);
+    hmap_insert(&bundle->ofproto->bundle_ports, &port->name_node,
+                hash_string(netdev_get_name(port->up.netdev), 0));
 
-    if (STR_EQ(netdev_get_type(port->up.netdev), OVSREC_INTERFACE_TYPE_SYSTEM)) {
+    if (__ofport_is_system(port) && bundle->lag.created) {
+        status = ops_sai_lag_member_add(bundle->lag.hw_id, hw_id);
+        ERRNO_LOG_EXIT(status, "Failed to add port to bundle");
+    } else if (__ofport_is_system(port)) {
         if (-1 != bundle->vlan) {
             status = ops_sai_vlan_access_port_add(bundle->vlan, hw_id);
             ERRNO_LOG_EXIT(status, "Failed to add port to bundle");
@@ -804,7 +1309,10 @@ __ofbundle_port_del(struct ofport_sai *port)
 
     bundle = port->bundle;
 
-    if (STR_EQ(netdev_get_type(port->up.netdev), OVSREC_INTERFACE_TYPE_SYSTEM)) {
+    if (__ofport_is_system(port) && bundle->lag.created) {
+        status = ops_sai_lag_member_del(bundle->lag.hw_id, hw_id);
+        ERRNO_LOG_EXIT(status, "Failed to remove port from bundle");
+    } else if (__ofport_is_system(port)) {
         if (-1 != bundle->vlan) {
             status = ops_sai_vlan_access_port_del(bundle->vlan, hw_id);
             ERRNO_LOG_EXIT(status, "Failed to remove port from bundle");
@@ -818,6 +1326,7 @@ __ofbundle_port_del(struct ofport_sai *port)
 
 exit:
     list_remove(&port->bundle_node);
+    hmap_remove(&bundle->ofproto->bundle_ports, &port->name_node);
     port->bundle = NULL;
 
     return status;
@@ -868,18 +1377,209 @@ exit:
     return status;
 }
 
+/*
+ * Check if port is front panel port, which can be LAG member.
+ */
+static bool
+__ofport_is_system(const struct ofport_sai *port)
+{
+    return STR_EQ(netdev_get_type(port->up.netdev),
+                  OVSREC_INTERFACE_TYPE_SYSTEM);
+}
+
+/*
+ * Collect label IDs VLANs of bundle are configured on: LAG of bundle if
+ * there is one, followed by ports which are not its members.
+ *
+ * @return number of label IDs in 'hw_ids', which caller has to free.
+ */
+static size_t
+__ofbundle_l2_ids_get(const struct ofbundle_sai *bundle, uint32_t **hw_ids)
+{
+    size_t n_ids = 0;
+    struct ofport_sai *port = NULL;
+
+    *hw_ids = xmalloc((list_size(&bundle->ports) + 1) * sizeof **hw_ids);
+
+    if (bundle->lag.created) {
+        (*hw_ids)[n_ids++] = bundle->lag.hw_id;
+    }
+
+    LIST_FOR_EACH(port, bundle_node, &bundle->ports) {
+        if (bundle->lag.created && __ofport_is_system(port)) {
+            continue;
+        }
+        (*hw_ids)[n_ids++] = netdev_sai_hw_id_get(port->up.netdev);
+    }
+
+    return n_ids;
+}
+
+/*
+ * Get weight of next hops reachable over bundle: speed in Gbps of its front
+ * panel ports which are up, 0 if unknown, OPS_SAI_ROUTE_NH_WEIGHT_DOWN if
+ * all of them are down.
+ */
+static uint32_t
+__ofbundle_nh_weight_get(const struct ofbundle_sai *bundle)
+{
+    uint32_t hw_id = 0;
+    uint32_t speed = 0;
+    bool carrier = false;
+    bool known = false;
+    bool up = false;
+    struct ofport_sai *port = NULL;
+    struct ops_sai_port_config conf = { };
+
+    LIST_FOR_EACH(port, bundle_node, &bundle->ports) {
+        if (!__ofport_is_system(port)) {
+            continue;
+        }
+
+        hw_id = netdev_sai_hw_id_get(port->up.netdev);
+        if (ops_sai_port_carrier_get(hw_id, &carrier)) {
+            continue;
+        }
+        known = true;
+        if (!carrier) {
+            continue;
+        }
+        up = true;
+        if (ops_sai_port_config_get(hw_id, &conf) || conf.speed <= 0) {
+            continue;
+        }
+
+        speed += conf.speed;
+    }
+
+    if (known && !up) {
+        return OPS_SAI_ROUTE_NH_WEIGHT_DOWN;
+    }
+
+    return speed / 1000;
+}
+
+/*
+ * Derive weights of neighbors of bundle from its capacity, so that remote
+ * routes share traffic in proportion to bandwidth of egress links.
+ */
+static void
+__ofbundle_nh_weights_update(const struct ofbundle_sai *bundle)
+{
+    int status = 0;
+    uint32_t weight = __ofbundle_nh_weight_get(bundle);
+    struct neigbor_entry *neigh = NULL;
+
+    HMAP_FOR_EACH(neigh, neigh_node, &bundle->neighbors) {
+        status = ops_sai_route_nh_weight_set(&bundle->ofproto->vrid,
+                                             neigh->ip_address, weight,
+                                             false);
+        ERRNO_LOG(status, "Failed to set next hop weight (next hop: %s)",
+                  neigh->ip_address);
+    }
+}
+
+/*
+ * Derive weights of neighbors of VRF again once port state changed, so that
+ * remote routes stop sending share of traffic to links which went down.
+ */
+static void
+__vrf_nh_weights_run(struct ofproto_sai *ofproto)
+{
+    uint64_t seqno = seq_read(connectivity_seq_get());
+    struct ofbundle_sai *bundle = NULL;
+
+    if (seqno == ofproto->connectivity_seqno) {
+        return;
+    }
+
+    ofproto->connectivity_seqno = seqno;
+    HMAP_FOR_EACH(bundle, hmap_node, &ofproto->bundles) {
+        __ofbundle_nh_weights_update(bundle);
+    }
+}
+
+/*
+ * Create or remove LAG of bundle. VLANs are unbound from ports or LAG being
+ * replaced, and have to be applied again with __vlan_reconfigure(). Router
+ * interface is removed as well, it is re-created on new LAG or port by
+ * __ofbundle_router_intf_reconfigure().
+ *
+ * @param[in] bundle - bundle to reconfigure.
+ * @param[in] enable - true if bundle should be backed by LAG.
+ *
+ * @return 0 operation completed successfully
+ * @return errno operation failed
+ */
+static int
+__ofbundle_lag_set(struct ofbundle_sai *bundle, bool enable)
+{
+    int status = 0;
+    uint32_t hw_id = 0;
+    struct ofport_sai *port = NULL;
+    struct ofproto_bundle_settings unbound = {
+        .vlan = -1,
+        .vlan_mode = PORT_VLAN_TRUNK,
+        .trunks = NULL,
+    };
+
+    if (bundle->lag.created == enable) {
+        goto exit;
+    }
+
+    status = __ofbundle_router_intf_remove(bundle);
+    ERRNO_LOG_EXIT(status, "Failed to remove router interface (bundle: %s)",
+                   bundle->name);
+
+    status = __vlan_reconfigure(bundle, &unbound);
+    ERRNO_LOG_EXIT(status, "Failed to unbind VLANs (bundle: %s)",
+                   bundle->name);
+
+    if (enable) {
+        status = ops_sai_lag_create(&bundle->lag.hw_id);
+        ERRNO_LOG_EXIT(status, "Failed to create LAG (bundle: %s)",
+                       bundle->name);
+        bundle->lag.created = true;
+    }
+
+    LIST_FOR_EACH(port, bundle_node, &bundle->ports) {
+        if (!__ofport_is_system(port)) {
+            continue;
+        }
+
+        hw_id = netdev_sai_hw_id_get(port->up.netdev);
+        status = enable ? ops_sai_lag_member_add(bundle->lag.hw_id, hw_id) :
+                          ops_sai_lag_member_del(bundle->lag.hw_id, hw_id);
+        ERRNO_LOG_EXIT(status, "Failed to set LAG members (bundle: %s)",
+                       bundle->name);
+    }
+
+    if (!enable) {
+        status = ops_sai_lag_remove(bundle->lag.hw_id);
+        ERRNO_LOG_EXIT(status, "Failed to remove LAG (bundle: %s)",
+                       bundle->name);
+        bundle->lag.created = false;
+    }
+
+exit:
+    return status;
+}
+
 /*
  * Reconfigure port to vlan settings. Remove ports from vlans that were in
- * bundle and add ports to vlan in new settings.
+ * bundle and add ports to vlan in new settings. Bundle backed by LAG is
+ * configured on LAG instead of its member ports.
  */
 static int
 __vlan_reconfigure(struct ofbundle_sai *bundle,
                               const struct ofproto_bundle_settings *s)
 {
+    size_t i = 0;
     int status = 0;
+    size_t n_ids = 0;
+    uint32_t *hw_ids = NULL;
     bool tag_changed = bundle->vlan != s->vlan;
     bool mod_changed = bundle->vlan_mode != s->vlan_mode;
-    struct ofport_sai *port = NULL, *next_port = NULL;
     static unsigned long added_trunks[BITMAP_N_LONGS(VLAN_BITMAP_SIZE)];
     static unsigned long common_trunks[BITMAP_N_LONGS(VLAN_BITMAP_SIZE)];
     static unsigned long removed_trunks[BITMAP_N_LONGS(VLAN_BITMAP_SIZE)];
@@ -920,48 +1620,43 @@ __vlan_reconfigure(struct ofbundle_sai *bundle,
     }
 
     /* Remove all ports from deleted vlans. */
+    n_ids = __ofbundle_l2_ids_get(bundle, &hw_ids);
     switch (bundle->vlan_mode) {
     case PORT_VLAN_ACCESS:
         if (tag_changed || mod_changed) {
-            LIST_FOR_EACH_SAFE(port, next_port, bundle_node, &bundle->ports) {
-                status = ops_sai_vlan_access_port_del(bundle->vlan,
-                                                      netdev_sai_hw_id_get(port->up.netdev));
+            for (i = 0; i < n_ids; i++) {
+                status = ops_sai_vlan_access_port_del(bundle->vlan, hw_ids[i]);
                 ERRNO_LOG_EXIT(status, "Failed to remove reconfigure vlans");
             }
         }
         break;
 
     case PORT_VLAN_TRUNK:
-        LIST_FOR_EACH_SAFE(port, next_port, bundle_node, &bundle->ports) {
-            status = ops_sai_vlan_trunks_port_del(removed_trunks,
-                                                  netdev_sai_hw_id_get(port->up.netdev));
+        for (i = 0; i < n_ids; i++) {
+            status = ops_sai_vlan_trunks_port_del(removed_trunks, hw_ids[i]);
             ERRNO_LOG_EXIT(status, "Failed to remove reconfigure vlans");
         }
         break;
 
     case PORT_VLAN_NATIVE_UNTAGGED:
-        LIST_FOR_EACH_SAFE(port, next_port, bundle_node, &bundle->ports) {
+        for (i = 0; i < n_ids; i++) {
             if (tag_changed || mod_changed) {
-                status = ops_sai_vlan_access_port_del(bundle->vlan,
-                                                      netdev_sai_hw_id_get(port->up.netdev));
+                status = ops_sai_vlan_access_port_del(bundle->vlan, hw_ids[i]);
                 ERRNO_LOG_EXIT(status, "Failed to remove reconfigure vlans");
             }
-            status = ops_sai_vlan_trunks_port_del(removed_trunks,
-                                                  netdev_sai_hw_id_get(port->up.netdev));
+            status = ops_sai_vlan_trunks_port_del(removed_trunks, hw_ids[i]);
             ERRNO_LOG_EXIT(status, "Failed to remove reconfigure vlans");
         }
         break;
 
     case PORT_VLAN_NATIVE_TAGGED:
-        LIST_FOR_EACH_SAFE(port, next_port, bundle_node, &bundle->ports) {
+        for (i = 0; i < n_ids; i++) {
             if (tag_changed || mod_changed) {
-                status = __native_tagged_vlan_set(bundle->vlan,
-                                                  netdev_sai_hw_id_get(port->up.netdev),
+                status = __native_tagged_vlan_set(bundle->vlan, hw_ids[i],
                                                   false);
                 ERRNO_LOG_EXIT(status, "Failed to remove reconfigure vlans");
             }
-            status = ops_sai_vlan_trunks_port_del(removed_trunks,
-                                                  netdev_sai_hw_id_get(port->up.netdev));
+            status = ops_sai_vlan_trunks_port_del(removed_trunks, hw_ids[i]);
             ERRNO_LOG_EXIT(status, "Failed to remove reconfigure vlans");
         }
         break;
@@ -974,45 +1669,38 @@ __vlan_reconfigure(struct ofbundle_sai *bundle,
     switch (s->vlan_mode) {
     case PORT_VLAN_ACCESS:
         if (tag_changed || mod_changed) {
-            LIST_FOR_EACH_SAFE(port, next_port, bundle_node, &bundle->ports) {
-                status = ops_sai_vlan_access_port_add(s->vlan,
-                                                      netdev_sai_hw_id_get(port->up.netdev));
+            for (i = 0; i < n_ids; i++) {
+                status = ops_sai_vlan_access_port_add(s->vlan, hw_ids[i]);
                 ERRNO_LOG_EXIT(status, "Failed to reconfigure vlans");
             }
         }
         break;
 
     case PORT_VLAN_TRUNK:
-        LIST_FOR_EACH_SAFE(port, next_port, bundle_node, &bundle->ports) {
-            status = ops_sai_vlan_trunks_port_add(added_trunks,
-                                                  netdev_sai_hw_id_get(port->up.netdev));
+        for (i = 0; i < n_ids; i++) {
+            status = ops_sai_vlan_trunks_port_add(added_trunks, hw_ids[i]);
             ERRNO_LOG_EXIT(status, "Failed to reconfigure vlans");
         }
         break;
 
     case PORT_VLAN_NATIVE_UNTAGGED:
-        LIST_FOR_EACH_SAFE(port, next_port, bundle_node, &bundle->ports) {
+        for (i = 0; i < n_ids; i++) {
             if (tag_changed || mod_changed) {
-                status = ops_sai_vlan_access_port_add(s->vlan,
-                                                      netdev_sai_hw_id_get(port->up.netdev));
+                status = ops_sai_vlan_access_port_add(s->vlan, hw_ids[i]);
                 ERRNO_LOG_EXIT(status, "Failed to reconfigure vlans");
             }
-            status = ops_sai_vlan_trunks_port_add(added_trunks,
-                                                  netdev_sai_hw_id_get(port->up.netdev));
+            status = ops_sai_vlan_trunks_port_add(added_trunks, hw_ids[i]);
             ERRNO_LOG_EXIT(status, "Failed to reconfigure vlans");
         }
         break;
 
     case PORT_VLAN_NATIVE_TAGGED:
-        LIST_FOR_EACH_SAFE(port, next_port, bundle_node, &bundle->ports) {
+        for (i = 0; i < n_ids; i++) {
             if (tag_changed || mod_changed) {
-                status = __native_tagged_vlan_set(s->vlan,
-                                                  netdev_sai_hw_id_get(port->up.netdev),
-                                                  true);
+                status = __native_tagged_vlan_set(s->vlan, hw_ids[i], true);
                 ERRNO_LOG_EXIT(status, "Failed to reconfigure vlans");
             }
-            status = ops_sai_vlan_trunks_port_add(added_trunks,
-                                                  netdev_sai_hw_id_get(port->up.netdev));
+            status = ops_sai_vlan_trunks_port_add(added_trunks, hw_ids[i]);
             ERRNO_LOG_EXIT(status, "Failed to reconfigure vlans");
         }
         break;
@@ -1026,58 +1714,64 @@ __vlan_reconfigure(struct ofbundle_sai *bundle,
     __trunks_realloc(bundle, s->trunks);
 
 exit:
+    free(hw_ids);
     return status;
 }
 
+/*
+ * Reconfigure bundle members. New members are collected into a set, and
+ * membership of a port is known from its bundle pointer, so reconfiguration
+ * is linear in number of old and new members. Bundle with more than one
+ * system port is backed by LAG, members of which are updated with the delta.
+ */
 static int
 __ofbundle_ports_reconfigure(struct ofbundle_sai *bundle,
                                const struct ofproto_bundle_settings *s)
 {
     size_t i;
-    bool port_found = false;
     int status = 0;
+    size_t n_system = 0;
+    struct hmapx slaves = HMAPX_INITIALIZER(&slaves);
     struct ofport_sai *port = NULL, *next_port = NULL, *s_port = NULL;
 
+    for (i = 0; i < s->n_slaves; i++) {
+        s_port = __get_ofp_port(bundle->ofproto, s->slaves[i]);
+        if (!s_port) {
+            status = ENOENT;
+            ERRNO_LOG_EXIT(status, "Failed to get port (slave: %u)",
+                           s->slaves[i]);
+        }
+        hmapx_add(&slaves, s_port);
+        if (__ofport_is_system(s_port)) {
+            n_system++;
+        }
+    }
+
     /* Figure out which ports were removed. */
     LIST_FOR_EACH_SAFE(port, next_port, bundle_node, &bundle->ports) {
-        port_found = false;
-        for (i = 0; i < s->n_slaves; i++) {
-            s_port = __get_ofp_port(bundle->ofproto, s->slaves[i]);
-            if (port == s_port) {
-                port_found = true;
-                break;
-            }
-        }
-        if (!port_found) {
+        if (!hmapx_contains(&slaves, port)) {
             status = __ofbundle_port_del(port);
             ERRNO_LOG_EXIT(status, "Failed to reconfigure ports");
         }
     }
 
+    status = __ofbundle_lag_set(bundle, n_system > 1);
+    ERRNO_LOG_EXIT(status, "Failed to reconfigure ports");
+
     status = __vlan_reconfigure(bundle, s);
     ERRNO_LOG_EXIT(status, "Failed to reconfigure ports");
 
-    /* Figure out which ports were added. */
-    port = NULL;
-    next_port = NULL;
+    /* Figure out which ports were added, keeping order of slaves. */
     for (i = 0; i < s->n_slaves; i++) {
-        port_found = false;
         s_port = __get_ofp_port(bundle->ofproto, s->slaves[i]);
-
-        LIST_FOR_EACH_SAFE(port, next_port, bundle_node, &bundle->ports) {
-            if (port == s_port) {
-                port_found = true;
-                break;
-            }
-        }
-
-        if (!port_found) {
+        if (s_port->bundle != bundle) {
             status = __ofbundle_port_add(bundle, s_port);
+            ERRNO_LOG_EXIT(status, "Failed to reconfigure ports");
         }
-        ERRNO_LOG_EXIT(status, "Failed to reconfigure ports");
     }
 
 exit:
+    hmapx_destroy(&slaves);
     return status;
 }
 
@@ -1129,7 +1823,8 @@ __ofbundle_router_intf_reconfigure(struct ofbundle_sai *bundle,
         goto exit;
     } else {
         rif_type = ROUTER_INTF_TYPE_PORT;
-        handle.data = netdev_sai_hw_id_get(port->up.netdev);
+        handle.data = bundle->lag.created ? bundle->lag.hw_id :
+                      netdev_sai_hw_id_get(port->up.netdev);
     }
 
     if (bundle->router_intf.created &&
@@ -1612,6 +2307,10 @@ __ofbundle_destroy(struct ofbundle_sai *bundle)
                   bundle->name);
     }
 
+    status = __ofbundle_lag_set(bundle, false);
+    ERRNO_LOG(status, "Failed to remove bundle LAG (bundle: %s)",
+              bundle->name);
+
     __ofbundle_rename(bundle, NULL);
     __trunks_realloc(bundle, NULL);
     hmap_destroy(&bundle->ipv4_secondary);
@@ -1644,21 +2343,22 @@ __ofbundle_lookup(struct ofproto_sai *ofproto, void *aux)
     return NULL;
 }
 
+/*
+ * Find bundle which contains port with given netdev name.
+ */
 static struct ofbundle_sai *
 __ofbundle_lookup_by_netdev_name(struct ofproto_sai *ofproto,
                                    const char *name)
 {
     struct ofport_sai *port = NULL;
-    struct ofbundle_sai *bundle = NULL;
 
     ovs_assert(ofproto);
     ovs_assert(name);
 
-    HMAP_FOR_EACH(bundle, hmap_node, &ofproto->bundles) {
-        LIST_FOR_EACH(port, bundle_node, &bundle->ports) {
-            if (STR_EQ(netdev_get_name(port->up.netdev), name)) {
-                return bundle;
-            }
+    HMAP_FOR_EACH_WITH_HASH(port, name_node, hash_string(name, 0),
+                            &ofproto->bundle_ports) {
+        if (STR_EQ(netdev_get_name(port->up.netdev), name)) {
+            return port->bundle;
         }
     }
 
@@ -1695,14 +2395,10 @@ __bundle_set(struct ofproto *ofproto_, void *aux,
     status = __ofbundle_ports_reconfigure(bundle, s);
     ERRNO_LOG_EXIT(status, "Failed to set bundle");
 
-    if (s->n_slaves > 1) {
-        status = -1;
-        ERRNO_LOG_EXIT(status, "LAGs are not implemented");
-    }
-
     if (STR_EQ(ofproto_->type, SAI_INTERFACE_TYPE_VRF)) {
         __ofbundle_router_intf_reconfigure(bundle, s);
 	    __ofbundle_ip_reconfigure(bundle, s);
+        __ofbundle_nh_weights_update(bundle);
     }
 
 exit:
@@ -1731,12 +2427,30 @@ exit:
     }
 }
 
+/*
+ * Get label ID of LAG backing bundle, or -1 if bundle has no LAG.
+ */
 static int
 __bundle_get(struct ofproto *ofproto_, void *aux, int *bundle_handle)
 {
+    int status = 0;
+    struct ofbundle_sai *bundle = NULL;
+    struct ofproto_sai *ofproto = __ofproto_sai_cast(ofproto_);
+
     SAI_API_TRACE_FN();
 
-    return 0;
+    NULL_PARAM_LOG_ABORT(bundle_handle);
+
+    bundle = __ofbundle_lookup(ofproto, aux);
+    if (NULL == bundle) {
+        status = ENOENT;
+        ERRNO_LOG_EXIT(status, "Failed to get bundle");
+    }
+
+    *bundle_handle = bundle->lag.created ? bundle->lag.hw_id : -1;
+
+exit:
+    return status;
 }
 
 static int
@@ -1914,6 +2628,13 @@ __add_l3_host_entry(const struct ofproto *ofproto_, void *aux,
             ERRNO_EXIT(status);
         }
         __neigh_entry_hash_add(next_hop_mac_addr, ip_addr, bundle);
+
+        status = ops_sai_route_nh_weight_set(&ofproto->vrid, ip_addr,
+                                             __ofbundle_nh_weight_get(bundle),
+                                             false);
+        ERRNO_LOG(status, "Failed to set next hop weight (next hop: %s)",
+                  ip_addr);
+        status = 0;
     }
 
     exit:
@@ -1947,6 +2668,12 @@ __delete_l3_host_entry(const struct ofproto *ofproto_, void *aux,
             ERRNO_EXIT(status);
         }
         __neigh_entry_hash_remove(ip_addr, bundle);
+
+        status = ops_sai_route_nh_weight_set(&ofproto->vrid, ip_addr, 0,
+                                             false);
+        ERRNO_LOG(status, "Failed to unset next hop weight (next hop: %s)",
+                  ip_addr);
+        status = 0;
     } else {
         VLOG_WARN("Not removing non-existing neighbor entry"
                   "(ip address: %s, rifid: %lu)",
@@ -2136,11 +2863,53 @@ __l3_ecmp_hash_set(const struct ofproto *ofprotop, unsigned int hash,
     return ops_sai_ecmp_hash_set(hash, enable);
 }
 
+/*
+ * Runs switch wide engines. Called once per main loop iteration for each
+ * enumerated type, so engines are run for system type only.
+ */
+static int
+__type_run(const char *type)
+{
+    SAI_API_TRACE_FN();
+
+    if (!STR_EQ(type, SAI_INTERFACE_TYPE_SYSTEM)) {
+        return 0;
+    }
+
+    ops_sai_event_run();
+    ops_sai_rx_run();
+    ops_sai_host_intf_run();
+    ops_sai_acl_run();
+    ops_sai_sflow_run();
+
+    return 0;
+}
+
+static void
+__type_wait(const char *type)
+{
+    SAI_API_TRACE_FN();
+
+    if (!STR_EQ(type, SAI_INTERFACE_TYPE_SYSTEM)) {
+        return;
+    }
+
+    ops_sai_event_wait();
+    ops_sai_rx_wait();
+    ops_sai_host_intf_wait();
+    ops_sai_acl_wait();
+    ops_sai_sflow_wait();
+}
+
 static int
 __run(struct ofproto *ofproto)
 {
     SAI_API_TRACE_FN();
 
+    if (STR_EQ(ofproto->type, SAI_INTERFACE_TYPE_VRF)) {
+        __vrf_nh_weights_run(__ofproto_sai_cast(ofproto));
+    }
+
     return 0;
 }
 
@@ -2148,6 +2917,11 @@ static void
 __wait(struct ofproto *ofproto)
 {
     SAI_API_TRACE_FN();
+
+    if (STR_EQ(ofproto->type, SAI_INTERFACE_TYPE_VRF)) {
+        seq_wait(connectivity_seq_get(),
+                 __ofproto_sai_cast(ofproto)->connectivity_seqno);
+    }
 }
 
 static void
@@ -2158,6 +2932,43 @@ __set_tables_version(struct ofproto *ofproto, cls_version_t version)
     return;
 }
 
+/*
+ * Configure sFlow. Sampling is switch wide, so options of the last ofproto
+ * which set them apply, and only that ofproto disables sFlow, or destroying
+ * it does.
+ */
+static int
+__set_sflow(struct ofproto *ofproto_,
+            const struct ofproto_sflow_options *sflow_options)
+{
+    int err = 0;
+    struct ofproto_sai *ofproto = __ofproto_sai_cast(ofproto_);
+    struct ops_sai_sflow_options options = { };
+
+    SAI_API_TRACE_FN();
+
+    if (!sflow_options) {
+        if (sflow_owner == ofproto) {
+            err = ops_sai_sflow_set(NULL);
+            sflow_owner = NULL;
+        }
+        goto exit;
+    }
+
+    options.targets = &sflow_options->targets;
+    options.sampling_rate = sflow_options->sampling_rate;
+    options.header_len = sflow_options->header_len;
+    options.sub_id = sflow_options->sub_id;
+    options.agent_ip = sflow_options->control_ip;
+
+    err = ops_sai_sflow_set(&options);
+    ERRNO_LOG_EXIT(err, "Failed to set sFlow of %s", ofproto_->name);
+    sflow_owner = ofproto;
+
+exit:
+    return err;
+}
+
 static void
 OVS_UNUSED __ofproto_bundle_settings_dump(const struct ofproto_bundle_settings *s)
 {
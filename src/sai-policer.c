@@ -85,6 +85,95 @@ exit:
     return SAI_ERROR_2_ERRNO(status);
 }
 
+/*
+ * Change rate and burst of existing policer.
+ *
+ * param[in] handle pointer to policer object.
+ * @param[in] config pointer to policer configuration.
+ *
+ * @return 0 on success, sai status converted to errno value.
+ */
+int
+__policer_update(const handle_t *handle,
+                 const struct ops_sai_policer_config *config)
+{
+    int i = 0;
+    sai_attribute_t attr[4] = { };
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
+
+    NULL_PARAM_LOG_ABORT(handle);
+    NULL_PARAM_LOG_ABORT(config);
+
+    attr[0].id = SAI_POLICER_ATTR_CBS;
+    attr[0].value.u64 = config->burst_max;
+    attr[1].id = SAI_POLICER_ATTR_CIR;
+    attr[1].value.u64 = config->rate_max;
+    attr[2].id = SAI_POLICER_ATTR_PBS;
+    attr[2].value.u64 = config->burst_max;
+    attr[3].id = SAI_POLICER_ATTR_PIR;
+    attr[3].value.u64 = config->rate_max;
+
+    for (i = 0; i < ARRAY_SIZE(attr); i++) {
+        status = sai_api->policer_api->set_policer_attribute(handle->data,
+                                                             &attr[i]);
+        SAI_ERROR_LOG_EXIT(status, "Failed to update policer (attr: %u)",
+                           attr[i].id);
+    }
+
+exit:
+    return SAI_ERROR_2_ERRNO(status);
+}
+
+/*
+ * Read policer counters. All colors are read with single call, policers
+ * which count violations only fall back to red counter.
+ *
+ * param[in]  handle pointer to policer object.
+ * param[out] stats  policer counters.
+ *
+ * @return 0 on success, sai status converted to errno value.
+ */
+int
+__policer_stats_get(const handle_t *handle,
+                    struct ops_sai_policer_stats *stats)
+{
+    uint64_t counters[3] = { };
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
+    static const sai_policer_stat_counter_t counter_ids[] = {
+        SAI_POLICER_STAT_GREEN_PACKETS,
+        SAI_POLICER_STAT_YELLOW_PACKETS,
+        SAI_POLICER_STAT_RED_PACKETS,
+    };
+
+    NULL_PARAM_LOG_ABORT(handle);
+    NULL_PARAM_LOG_ABORT(stats);
+
+    status = sai_api->policer_api->get_policer_statistics(handle->data,
+                                                          counter_ids,
+                                                          ARRAY_SIZE(counter_ids),
+                                                          counters);
+    if (SAI_STATUS_SUCCESS == status) {
+        stats->green_packets = counters[0];
+        stats->yellow_packets = counters[1];
+        stats->red_packets = counters[2];
+        goto exit;
+    }
+
+    status = sai_api->policer_api->get_policer_statistics(handle->data,
+                                                          &counter_ids[2], 1,
+                                                          &counters[2]);
+    SAI_ERROR_LOG_EXIT(status, "Failed to get policer statistics");
+
+    stats->green_packets = OPS_SAI_POLICER_STAT_NA;
+    stats->yellow_packets = OPS_SAI_POLICER_STAT_NA;
+    stats->red_packets = counters[2];
+
+exit:
+    return SAI_ERROR_2_ERRNO(status);
+}
+
 /*
  * De-initialize policers.
  */
@@ -97,6 +186,8 @@ DEFINE_GENERIC_CLASS(struct policer_class, policer) = {
         .init = __policer_init,
         .create = __policer_create,
         .remove = __policer_remove,
+        .update = __policer_update,
+        .stats_get = __policer_stats_get,
         .deinit = __policer_deinit,
 };
 
@@ -10,6 +10,7 @@
 #include <sai-log.h>
 #include <sai-api-class.h>
 #include <sai-port.h>
+#include <sai-rx.h>
 #include <list.h>
 
 VLOG_DEFINE_THIS_MODULE(sai_port);
@@ -204,8 +205,15 @@ int
 ops_sai_port_config_set(uint32_t hw_id, const struct ops_sai_port_config *new,
                         struct ops_sai_port_config *old)
 {
+    int status = 0;
+
     ovs_assert(ops_sai_port_class()->config_set);
-    return ops_sai_port_class()->config_set(hw_id, new, old);
+    status = ops_sai_port_class()->config_set(hw_id, new, old);
+    if (!status) {
+        ops_sai_rx_port_mtu_update(new->mtu);
+    }
+
+    return status;
 }
 
 /*
@@ -285,8 +293,15 @@ exit:
 int
 ops_sai_port_mtu_set(uint32_t hw_id, int mtu)
 {
+    int status = 0;
+
     ovs_assert(ops_sai_port_class()->mtu_set);
-    return ops_sai_port_class()->mtu_set(hw_id, mtu);
+    status = ops_sai_port_class()->mtu_set(hw_id, mtu);
+    if (!status) {
+        ops_sai_rx_port_mtu_update(mtu);
+    }
+
+    return status;
 }
 
 /*
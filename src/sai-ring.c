@@ -0,0 +1,352 @@
+/*
+ * Copyright Mellanox Technologies, Ltd. 2001-2016.
+ * This software product is licensed under Apache version 2, as detailed in
+ * the COPYING file.
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include <util.h>
+#include <poll-loop.h>
+
+#include <sai-log.h>
+#include <sai-ring.h>
+
+VLOG_DEFINE_THIS_MODULE(sai_ring);
+
+/*
+ * Every cell carries a sequence number which tells whether it is free for
+ * position 'pos' (seq == pos) or holds an element published for position
+ * 'pos' (seq == pos + 1).
+ */
+struct ops_sai_ring_cell {
+    atomic_uint32_t seq;
+    uint64_t data[];
+};
+
+static inline struct ops_sai_ring_cell *__ring_cell(const struct ops_sai_ring *,
+                                                    uint32_t);
+static inline uint32_t __ring_tail(struct ops_sai_ring *);
+
+/**
+ * Initialize ring.
+ *
+ * @param[in] ring      - pointer to ring.
+ * @param[in] size      - number of elements, must be a power of 2.
+ * @param[in] elem_size - size of single element in bytes.
+ *
+ * @return 0 operation completed successfully
+ * @return errno operation failed
+ */
+int
+ops_sai_ring_init(struct ops_sai_ring *ring, uint32_t size, size_t elem_size)
+{
+    uint32_t i = 0;
+    int status = 0;
+
+    NULL_PARAM_LOG_ABORT(ring);
+    ovs_assert(size && !(size & (size - 1)));
+
+    memset(ring, 0, sizeof *ring);
+
+    ring->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (ring->wake_fd < 0) {
+        status = errno;
+        ERRNO_LOG_EXIT(status, "Failed to create ring eventfd");
+    }
+
+    ring->elem_size = elem_size;
+    ring->cell_size = sizeof(struct ops_sai_ring_cell)
+                      + ROUND_UP(elem_size, sizeof(uint64_t));
+    ring->mask = size - 1;
+    ring->cells = xmalloc(ring->cell_size * size);
+    atomic_init(&ring->tail, 0);
+
+    for (i = 0; i < size; i++) {
+        atomic_init(&__ring_cell(ring, i)->seq, i);
+    }
+
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->n_dropped, 0);
+    atomic_flag_clear(&ring->wake_pending);
+
+exit:
+    return status;
+}
+
+/**
+ * De-initialize ring. No producers may access ring at this point.
+ *
+ * @param[in] ring - pointer to ring.
+ */
+void
+ops_sai_ring_destroy(struct ops_sai_ring *ring)
+{
+    NULL_PARAM_LOG_ABORT(ring);
+
+    if (ring->wake_fd >= 0) {
+        close(ring->wake_fd);
+        ring->wake_fd = -1;
+    }
+
+    free(ring->cells);
+    ring->cells = NULL;
+}
+
+/**
+ * Copy element into ring and wake up consumer. Never blocks, may be called
+ * from any thread.
+ *
+ * @param[in] ring - pointer to ring.
+ * @param[in] elem - pointer to element of ring->elem_size bytes.
+ *
+ * @return true if element was queued, false if ring is full.
+ */
+bool
+ops_sai_ring_push(struct ops_sai_ring *ring, const void *elem)
+{
+    void *slot = ops_sai_ring_reserve(ring);
+
+    if (!slot) {
+        return false;
+    }
+
+    memcpy(slot, elem, ring->elem_size);
+    ops_sai_ring_commit(ring, slot);
+
+    return true;
+}
+
+/**
+ * Claim free slot, so producer can build element in place. Slot must be
+ * published with ops_sai_ring_commit(). Never blocks, may be called from any
+ * thread.
+ *
+ * @param[in] ring - pointer to ring.
+ *
+ * @return pointer to slot of ring->elem_size bytes, NULL if ring is full.
+ */
+void *
+ops_sai_ring_reserve(struct ops_sai_ring *ring)
+{
+    uint32_t pos = 0;
+    uint32_t seq = 0;
+    int32_t diff = 0;
+    uint64_t orig = 0;
+    struct ops_sai_ring_cell *cell = NULL;
+
+    atomic_read_explicit(&ring->head, &pos, memory_order_relaxed);
+
+    for (;;) {
+        cell = __ring_cell(ring, pos);
+        atomic_read_explicit(&cell->seq, &seq, memory_order_acquire);
+        diff = (int32_t) (seq - pos);
+
+        if (!diff) {
+            if (atomic_compare_exchange_weak_explicit(&ring->head, &pos,
+                                                      pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                return cell->data;
+            }
+        } else if (diff < 0) {
+            atomic_add_relaxed(&ring->n_dropped, 1, &orig);
+            return NULL;
+        } else {
+            atomic_read_explicit(&ring->head, &pos, memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * Publish slot claimed by ops_sai_ring_reserve() and wake up consumer.
+ *
+ * @param[in] ring - pointer to ring.
+ * @param[in] slot - slot returned by ops_sai_ring_reserve().
+ */
+void
+ops_sai_ring_commit(struct ops_sai_ring *ring, void *slot)
+{
+    uint32_t seq = 0;
+    uint64_t one = 1;
+    struct ops_sai_ring_cell *cell = CONTAINER_OF(slot,
+                                                  struct ops_sai_ring_cell,
+                                                  data);
+
+    /* Cell is owned by producer, so its sequence equals claimed position. */
+    atomic_read_relaxed(&cell->seq, &seq);
+    atomic_store_explicit(&cell->seq, seq + 1, memory_order_release);
+
+    /* Only the first producer after consumer wake up pays for a syscall. */
+    if (!atomic_flag_test_and_set(&ring->wake_pending)) {
+        ignore(write(ring->wake_fd, &one, sizeof one));
+    }
+}
+
+/**
+ * Copy oldest element out of ring. Must be called from consumer thread only.
+ *
+ * @param[in]  ring - pointer to ring.
+ * @param[out] elem - pointer to buffer of ring->elem_size bytes.
+ *
+ * @return true if element was dequeued, false if ring is empty.
+ */
+bool
+ops_sai_ring_pop(struct ops_sai_ring *ring, void *elem)
+{
+    const void *slot = ops_sai_ring_peek(ring);
+
+    if (!slot) {
+        return false;
+    }
+
+    memcpy(elem, slot, ring->elem_size);
+    ops_sai_ring_release(ring);
+
+    return true;
+}
+
+/**
+ * Get oldest element without copying it. Element stays valid until
+ * ops_sai_ring_release(). Must be called from consumer thread only.
+ *
+ * @param[in] ring - pointer to ring.
+ *
+ * @return pointer to element, NULL if ring is empty.
+ */
+const void *
+ops_sai_ring_peek(struct ops_sai_ring *ring)
+{
+    uint32_t seq = 0;
+    uint32_t tail = __ring_tail(ring);
+    struct ops_sai_ring_cell *cell = __ring_cell(ring, tail);
+
+    atomic_read_explicit(&cell->seq, &seq, memory_order_acquire);
+    if (seq != tail + 1) {
+        return NULL;
+    }
+
+    return cell->data;
+}
+
+/**
+ * Return slot of element obtained by ops_sai_ring_peek() to producers.
+ *
+ * @param[in] ring - pointer to ring.
+ */
+void
+ops_sai_ring_release(struct ops_sai_ring *ring)
+{
+    uint32_t tail = __ring_tail(ring);
+    struct ops_sai_ring_cell *cell = __ring_cell(ring, tail);
+
+    atomic_store_explicit(&cell->seq, tail + ring->mask + 1,
+                          memory_order_release);
+    atomic_store_relaxed(&ring->tail, tail + 1);
+}
+
+/**
+ * Check whether consumer has nothing to dequeue.
+ *
+ * @param[in] ring - pointer to ring.
+ *
+ * @return true if ring is empty.
+ */
+bool
+ops_sai_ring_is_empty(struct ops_sai_ring *ring)
+{
+    uint32_t seq = 0;
+    uint32_t tail = __ring_tail(ring);
+
+    atomic_read_explicit(&__ring_cell(ring, tail)->seq, &seq,
+                         memory_order_acquire);
+
+    return seq != tail + 1;
+}
+
+/**
+ * Get number of claimed slots, including slots producers still write.
+ * Must be called from consumer thread only.
+ *
+ * @param[in] ring - pointer to ring.
+ *
+ * @return number of elements in ring.
+ */
+uint32_t
+ops_sai_ring_count(struct ops_sai_ring *ring)
+{
+    uint32_t head = 0;
+
+    atomic_read_relaxed(&ring->head, &head);
+
+    return head - __ring_tail(ring);
+}
+
+/**
+ * Get number of elements dropped because ring was full.
+ *
+ * @param[in] ring - pointer to ring.
+ *
+ * @return number of dropped elements.
+ */
+uint64_t
+ops_sai_ring_dropped_get(struct ops_sai_ring *ring)
+{
+    uint64_t n_dropped = 0;
+
+    atomic_read_relaxed(&ring->n_dropped, &n_dropped);
+
+    return n_dropped;
+}
+
+/**
+ * Acknowledge wake up. Must be called by consumer before draining ring, so
+ * elements pushed while draining trigger new wake up.
+ *
+ * @param[in] ring - pointer to ring.
+ */
+void
+ops_sai_ring_wake_clear(struct ops_sai_ring *ring)
+{
+    uint64_t value = 0;
+
+    ignore(read(ring->wake_fd, &value, sizeof value));
+    atomic_flag_clear(&ring->wake_pending);
+}
+
+/**
+ * Make poll loop wake up when elements are available.
+ *
+ * @param[in] ring - pointer to ring.
+ */
+void
+ops_sai_ring_wait(struct ops_sai_ring *ring)
+{
+    if (!ops_sai_ring_is_empty(ring)) {
+        poll_immediate_wake();
+        return;
+    }
+
+    poll_fd_wait(ring->wake_fd, POLLIN);
+}
+
+static inline struct ops_sai_ring_cell *
+__ring_cell(const struct ops_sai_ring *ring, uint32_t pos)
+{
+    return (struct ops_sai_ring_cell *) (ring->cells
+                                         + (pos & ring->mask)
+                                           * ring->cell_size);
+}
+
+static inline uint32_t
+__ring_tail(struct ops_sai_ring *ring)
+{
+    uint32_t tail = 0;
+
+    atomic_read_relaxed(&ring->tail, &tail);
+
+    return tail;
+}
@@ -116,6 +116,25 @@ __route_remove(const handle_t *vrid, const char     *prefix)
     return 0;
 }
 
+/*
+ *  Function for setting weight of next hop in all remote routes of virtual
+ *  router
+ *
+ * @param[in] vrid       - virtual router ID
+ * @param[in] next_hop   - next hop IP address
+ * @param[in] weight     - weight, 0 to unset
+ * @param[in] configured - weight is configured by user
+ *
+ * @return 0  if operation completed successfully.
+ * @return -1 if operation failed.*/
+static int
+__route_nh_weight_set(const handle_t *vrid, const char *next_hop,
+                      uint32_t weight, bool configured)
+{
+    SAI_API_TRACE_NOT_IMPLEMENTED_FN();
+    return 0;
+}
+
 /*
  * De-initializes route.
  */
@@ -132,6 +151,7 @@ DEFINE_GENERIC_CLASS(struct route_class, route) = {
     .remote_add = __route_remote_add,
     .remote_nh_remove = __route_remote_nh_remove,
     .remove = __route_remove,
+    .nh_weight_set = __route_nh_weight_set,
     .deinit = __route_deinit,
 };
 
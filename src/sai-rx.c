@@ -0,0 +1,795 @@
+/*
+ * Copyright Mellanox Technologies, Ltd. 2001-2016.
+ * This software product is licensed under Apache version 2, as detailed in
+ * the COPYING file.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <util.h>
+#include <hash.h>
+#include <list.h>
+#include <latch.h>
+#include <poll-loop.h>
+#include <ovs-atomic.h>
+#include <ovs-thread.h>
+#include <packets.h>
+
+#include <sai-log.h>
+#include <sai-ring.h>
+#include <sai-rx.h>
+
+/* Must be power of 2. */
+#define SAI_RX_RING_SIZE        (512)
+/* Maximum number of packets taken from single queue in one iteration, so
+ * flood on one trap group does not starve the others. */
+#define SAI_RX_BATCH_MAX        (64)
+#define SAI_RX_TRAPS_MAX        (128)
+/* Open addressing trap index, must be power of 2 larger than
+ * SAI_RX_TRAPS_MAX so probing always ends at empty slot. */
+#define SAI_RX_TRAP_INDEX_SIZE  (2 * SAI_RX_TRAPS_MAX)
+#define SAI_RX_QUEUE_NAME_LEN   (64)
+
+VLOG_DEFINE_THIS_MODULE(sai_rx);
+
+struct rx_ring {
+    uint32_t frame_size;            /* Largest packet slot holds. */
+    struct ops_sai_ring ring;
+};
+
+struct rx_queue {
+    struct ovs_list list_node;      /* In rx_queues, by priority. */
+    char name[SAI_RX_QUEUE_NAME_LEN];
+    uint32_t priority;
+    /* Replaced by larger ring when port MTU grows. Replaced ring is freed
+     * once SAI receive threads which read it before replacement committed
+     * their packets, see rx_n_writers. */
+    ATOMIC(struct rx_ring *) ring;
+    uint64_t n_retired_dropped;     /* Dropped by replaced rings. */
+    atomic_uint64_t n_accepted;
+    atomic_uint64_t n_oversize;
+    atomic_uint64_t n_delivered;
+    atomic_uint64_t n_no_consumer;
+    /* Worker thread owning consumer side of ring. Queue is served by main
+     * loop if worker is not running. */
+    int worker_core;                /* SAI_RX_WORKER_* or CPU core. */
+    bool has_worker;
+    pthread_t worker;
+    struct latch worker_exit;
+};
+
+struct rx_trap {
+    int32_t trap_id;
+    /* Swapped when trap is rebound, NULL when its queue is destroyed. */
+    ATOMIC(struct rx_queue *) queue;
+    /* Consumer is called with mutex held, so it is never called after
+     * unregistration returns, even from worker thread. */
+    struct ovs_mutex mutex;
+    ops_sai_rx_cb cb OVS_GUARDED;
+    void *aux OVS_GUARDED;
+};
+
+/*
+ * Traps are looked up by SAI receive thread while main thread binds new ones,
+ * so trap table and its index are append only: entry is filled before it is
+ * published in rx_trap_index. Receive thread may still use queue trap was
+ * bound to before rebinding, so queues and rings are freed only when no
+ * receive thread is between reading them and committing its packet.
+ */
+static struct rx_trap rx_traps[SAI_RX_TRAPS_MAX];
+static uint32_t rx_n_traps = 0;
+static ATOMIC(struct rx_trap *) rx_trap_index[SAI_RX_TRAP_INDEX_SIZE];
+/* SAI receive threads between reading trap queue and committing packet. */
+static atomic_uint32_t rx_n_writers = ATOMIC_VAR_INIT(0);
+static struct ovs_list rx_queues = OVS_LIST_INITIALIZER(&rx_queues);
+/* Frame size of rings created now, follows largest port MTU. */
+static uint32_t rx_frame_size = SAI_RX_FRAME_SIZE_MIN;
+
+static struct rx_trap *__rx_trap_find(int32_t);
+static void __rx_trap_index_add(struct rx_trap *);
+static struct rx_queue *__rx_queue_find(const char *);
+static struct rx_ring *__rx_queue_ring(struct rx_queue *);
+static int __rx_ring_create(uint32_t, struct rx_ring **);
+static void __rx_ring_destroy(struct rx_ring *);
+static void __rx_queue_ring_replace(struct rx_queue *);
+static void __rx_writers_wait(void);
+static void __rx_queue_drain(struct rx_queue *, struct rx_ring *);
+static void __rx_worker_start(struct rx_queue *);
+static void __rx_worker_stop(struct rx_queue *);
+static void *__rx_worker_main(void *);
+
+/**
+ * Initialize receive engine. Must be called before SAI notifications are
+ * registered.
+ */
+void
+ops_sai_rx_init(void)
+{
+    uint32_t i = 0;
+
+    VLOG_INFO("Initializing receive engine");
+
+    memset(rx_traps, 0, sizeof rx_traps);
+    rx_n_traps = 0;
+    for (i = 0; i < SAI_RX_TRAP_INDEX_SIZE; i++) {
+        atomic_init(&rx_trap_index[i], NULL);
+    }
+    list_init(&rx_queues);
+    rx_frame_size = SAI_RX_FRAME_SIZE_MIN;
+}
+
+/**
+ * De-initialize receive engine. Must be called after SAI notifications are
+ * unregistered.
+ */
+void
+ops_sai_rx_deinit(void)
+{
+    uint32_t i = 0;
+    struct rx_queue *queue = NULL, *next_queue = NULL;
+
+    VLOG_INFO("De-initializing receive engine");
+
+    LIST_FOR_EACH(queue, list_node, &rx_queues) {
+        __rx_worker_stop(queue);
+    }
+
+    for (i = 0; i < SAI_RX_TRAP_INDEX_SIZE; i++) {
+        atomic_store_relaxed(&rx_trap_index[i], NULL);
+    }
+    for (i = 0; i < rx_n_traps; i++) {
+        ovs_mutex_destroy(&rx_traps[i].mutex);
+    }
+    rx_n_traps = 0;
+
+    LIST_FOR_EACH_SAFE(queue, next_queue, list_node, &rx_queues) {
+        list_remove(&queue->list_node);
+        latch_destroy(&queue->worker_exit);
+        __rx_ring_destroy(__rx_queue_ring(queue));
+        free(queue);
+    }
+}
+
+/**
+ * Create receive queue. Queues served by main loop are served in priority
+ * order. Queue with worker is served by its own thread, optionally pinned to
+ * CPU core, so it never waits behind other queues. If queue already exists
+ * its priority and worker are updated.
+ *
+ * @param[in] name        - queue name, usually trap group name.
+ * @param[in] priority    - queue priority.
+ * @param[in] worker_core - SAI_RX_WORKER_NONE to serve queue from main loop,
+ *                          SAI_RX_WORKER_ANY for worker without CPU affinity
+ *                          or CPU core to pin worker to.
+ *
+ * @return 0 operation completed successfully
+ * @return errno operation failed
+ */
+int
+ops_sai_rx_queue_create(const char *name, uint32_t priority, int worker_core)
+{
+    int status = 0;
+    struct rx_ring *ring = NULL;
+    struct rx_queue *queue = NULL;
+    struct rx_queue *pos = NULL;
+
+    NULL_PARAM_LOG_ABORT(name);
+
+    queue = __rx_queue_find(name);
+    if (queue) {
+        list_remove(&queue->list_node);
+    } else {
+        status = __rx_ring_create(rx_frame_size, &ring);
+        ERRNO_LOG_EXIT(status, "Failed to create receive queue (name: %s)",
+                       name);
+
+        queue = xzalloc(sizeof *queue);
+        ovs_strlcpy(queue->name, name, sizeof queue->name);
+        atomic_init(&queue->ring, ring);
+        atomic_init(&queue->n_accepted, 0);
+        atomic_init(&queue->n_oversize, 0);
+        atomic_init(&queue->n_delivered, 0);
+        atomic_init(&queue->n_no_consumer, 0);
+        queue->worker_core = SAI_RX_WORKER_NONE;
+        latch_init(&queue->worker_exit);
+    }
+    queue->priority = priority;
+
+    if (queue->worker_core != worker_core) {
+        __rx_worker_stop(queue);
+        queue->worker_core = worker_core;
+        __rx_worker_start(queue);
+    }
+
+    LIST_FOR_EACH(pos, list_node, &rx_queues) {
+        if (pos->priority < priority) {
+            break;
+        }
+    }
+    list_insert(&pos->list_node, &queue->list_node);
+
+exit:
+    return status;
+}
+
+/**
+ * Destroy receive queue. Traps bound to the queue are unbound from receive
+ * engine, their consumers are kept. Packets already queued are delivered.
+ * Must be called from main thread.
+ *
+ * @param[in] name - queue name.
+ */
+void
+ops_sai_rx_queue_destroy(const char *name)
+{
+    uint32_t i = 0;
+    struct rx_ring *ring = NULL;
+    struct rx_queue *queue = NULL;
+    struct rx_queue *trap_queue = NULL;
+
+    NULL_PARAM_LOG_ABORT(name);
+
+    queue = __rx_queue_find(name);
+    if (!queue) {
+        return;
+    }
+
+    VLOG_INFO("Destroying receive queue (name: %s)", name);
+
+    __rx_worker_stop(queue);
+    list_remove(&queue->list_node);
+
+    for (i = 0; i < rx_n_traps; i++) {
+        atomic_read_relaxed(&rx_traps[i].queue, &trap_queue);
+        if (trap_queue == queue) {
+            atomic_store(&rx_traps[i].queue, NULL);
+        }
+    }
+    __rx_writers_wait();
+
+    ring = __rx_queue_ring(queue);
+    while (!ops_sai_ring_is_empty(&ring->ring)) {
+        __rx_queue_drain(queue, ring);
+    }
+
+    latch_destroy(&queue->worker_exit);
+    __rx_ring_destroy(ring);
+    free(queue);
+}
+
+/**
+ * Direct packets of trap to receive queue. Trap which is already bound is
+ * moved to new queue, its consumer is kept.
+ *
+ * @param[in] queue_name - queue name.
+ * @param[in] trap_id    - SAI trap id.
+ *
+ * @return 0 operation completed successfully
+ * @return errno operation failed
+ */
+int
+ops_sai_rx_trap_bind(const char *queue_name, int32_t trap_id)
+{
+    int status = 0;
+    struct rx_trap *trap = NULL;
+    struct rx_queue *queue = NULL;
+
+    NULL_PARAM_LOG_ABORT(queue_name);
+
+    queue = __rx_queue_find(queue_name);
+    if (!queue) {
+        status = ENOENT;
+        ERRNO_LOG_EXIT(status, "Receive queue not found (name: %s)",
+                       queue_name);
+    }
+
+    trap = __rx_trap_find(trap_id);
+    if (trap) {
+        atomic_store_explicit(&trap->queue, queue, memory_order_release);
+        goto exit;
+    }
+
+    if (rx_n_traps == SAI_RX_TRAPS_MAX) {
+        status = ENOSPC;
+        ERRNO_LOG_EXIT(status, "Too many receive traps (trap: %d)", trap_id);
+    }
+
+    trap = &rx_traps[rx_n_traps++];
+    trap->trap_id = trap_id;
+    atomic_init(&trap->queue, queue);
+    ovs_mutex_init(&trap->mutex);
+    trap->cb = NULL;
+    trap->aux = NULL;
+    __rx_trap_index_add(trap);
+
+exit:
+    return status;
+}
+
+/**
+ * Register consumer of trap. Callback is invoked from main loop, or from
+ * worker thread if trap is bound to queue with worker, with packet which
+ * points into receive ring, packet must not be used after return. Callback
+ * must not register or unregister consumers.
+ *
+ * @param[in] trap_id - SAI trap id.
+ * @param[in] cb      - consumer callback.
+ * @param[in] aux     - argument of callback.
+ *
+ * @return 0 operation completed successfully
+ * @return errno operation failed
+ */
+int
+ops_sai_rx_consumer_register(int32_t trap_id, ops_sai_rx_cb cb, void *aux)
+{
+    int status = 0;
+    struct rx_trap *trap = NULL;
+
+    NULL_PARAM_LOG_ABORT(cb);
+
+    trap = __rx_trap_find(trap_id);
+    if (!trap) {
+        status = ENOENT;
+        ERRNO_LOG_EXIT(status, "Trap is not bound to receive queue "
+                       "(trap: %d)", trap_id);
+    }
+
+    ovs_mutex_lock(&trap->mutex);
+    trap->cb = cb;
+    trap->aux = aux;
+    ovs_mutex_unlock(&trap->mutex);
+
+exit:
+    return status;
+}
+
+/**
+ * Unregister consumer of trap. Waits for callback running in worker thread,
+ * so consumer may free its data on return.
+ *
+ * @param[in] trap_id - SAI trap id.
+ */
+void
+ops_sai_rx_consumer_unregister(int32_t trap_id)
+{
+    struct rx_trap *trap = __rx_trap_find(trap_id);
+
+    if (trap) {
+        ovs_mutex_lock(&trap->mutex);
+        trap->cb = NULL;
+        trap->aux = NULL;
+        ovs_mutex_unlock(&trap->mutex);
+    }
+}
+
+/**
+ * Queue packet received from SAI. Called from SAI receive thread, never
+ * blocks. Packet is written directly into ring slot.
+ *
+ * @param[in] buffer     - packet data.
+ * @param[in] size       - packet size.
+ * @param[in] attr_count - number of packet attributes.
+ * @param[in] attr_list  - packet attributes.
+ */
+void
+ops_sai_rx_packet_post(const void *buffer, sai_size_t size,
+                       uint32_t attr_count, const sai_attribute_t *attr_list)
+{
+    uint32_t i = 0;
+    uint64_t orig = 0;
+    uint32_t n_writers = 0;
+    int32_t trap_id = -1;
+    sai_object_id_t in_port = SAI_NULL_OBJECT_ID;
+    struct rx_trap *trap = NULL;
+    struct rx_ring *ring = NULL;
+    struct rx_queue *queue = NULL;
+    struct ops_sai_rx_packet *packet = NULL;
+
+    for (i = 0; i < attr_count; i++) {
+        switch (attr_list[i].id) {
+        case SAI_HOSTIF_PACKET_TRAP_ID:
+            trap_id = attr_list[i].value.s32;
+            break;
+        case SAI_HOSTIF_PACKET_INGRESS_PORT:
+            in_port = attr_list[i].value.oid;
+            break;
+        default:
+            break;
+        }
+    }
+
+    trap = __rx_trap_find(trap_id);
+    if (!trap) {
+        return;
+    }
+
+    /* Writer is accounted before queue and ring are read, so queue
+     * destruction and ring replacement either are seen here or wait for
+     * packet to be committed. */
+    atomic_add(&rx_n_writers, 1, &n_writers);
+    atomic_read(&trap->queue, &queue);
+    if (!queue) {
+        goto exit;
+    }
+    atomic_read(&queue->ring, &ring);
+
+    if (size > ring->frame_size) {
+        atomic_add_relaxed(&queue->n_oversize, 1, &orig);
+        goto exit;
+    }
+
+    packet = ops_sai_ring_reserve(&ring->ring);
+    if (!packet) {
+        goto exit;
+    }
+
+    packet->trap_id = trap_id;
+    packet->in_port = in_port;
+    packet->size = size;
+    memcpy(packet->data, buffer, size);
+    ops_sai_ring_commit(&ring->ring, packet);
+
+    atomic_add_relaxed(&queue->n_accepted, 1, &orig);
+
+exit:
+    atomic_sub_explicit(&rx_n_writers, 1, &n_writers, memory_order_release);
+}
+
+/**
+ * Grow receive ring slots of all queues, so frames of port with new MTU are
+ * not dropped as oversized. Slots never shrink. Must be called from main
+ * thread.
+ *
+ * @param[in] mtu - port MTU.
+ */
+void
+ops_sai_rx_port_mtu_update(int mtu)
+{
+    uint32_t frame_size = 0;
+    struct rx_queue *queue = NULL;
+
+    if (mtu <= 0) {
+        return;
+    }
+
+    /* Trapped frames keep L2 header and up to two VLAN tags. */
+    frame_size = mtu + ETH_HEADER_LEN + 2 * VLAN_HEADER_LEN;
+    if (frame_size <= rx_frame_size) {
+        return;
+    }
+
+    VLOG_INFO("Growing receive ring slots (frame size: %u)", frame_size);
+
+    rx_frame_size = frame_size;
+    LIST_FOR_EACH(queue, list_node, &rx_queues) {
+        __rx_queue_ring_replace(queue);
+    }
+}
+
+/**
+ * Hand queued packets of queues without worker to consumers. Queues are served
+ * in priority order and at most SAI_RX_BATCH_MAX packets are taken from each
+ * queue.
+ */
+void
+ops_sai_rx_run(void)
+{
+    struct rx_queue *queue = NULL;
+
+    LIST_FOR_EACH(queue, list_node, &rx_queues) {
+        if (!queue->has_worker) {
+            __rx_queue_drain(queue, __rx_queue_ring(queue));
+        }
+    }
+}
+
+/**
+ * Make main loop wake up when packets are queued to queues without worker.
+ */
+void
+ops_sai_rx_wait(void)
+{
+    struct rx_queue *queue = NULL;
+
+    LIST_FOR_EACH(queue, list_node, &rx_queues) {
+        if (!queue->has_worker) {
+            ops_sai_ring_wait(&__rx_queue_ring(queue)->ring);
+        }
+    }
+}
+
+/**
+ * Get receive queue counters.
+ *
+ * @param[in]  queue_name - queue name.
+ * @param[out] stats      - queue counters.
+ *
+ * @return 0 operation completed successfully
+ * @return errno operation failed
+ */
+int
+ops_sai_rx_stats_get(const char *queue_name, struct ops_sai_rx_stats *stats)
+{
+    int status = 0;
+    uint64_t n_oversize = 0;
+    struct rx_ring *ring = NULL;
+    struct rx_queue *queue = NULL;
+
+    NULL_PARAM_LOG_ABORT(queue_name);
+    NULL_PARAM_LOG_ABORT(stats);
+
+    queue = __rx_queue_find(queue_name);
+    if (!queue) {
+        status = ENOENT;
+        goto exit;
+    }
+
+    atomic_read_relaxed(&queue->n_accepted, &stats->accepted);
+    atomic_read_relaxed(&queue->n_oversize, &n_oversize);
+    stats->dropped = n_oversize + queue->n_retired_dropped;
+    ring = __rx_queue_ring(queue);
+    stats->dropped += ops_sai_ring_dropped_get(&ring->ring);
+    atomic_read_relaxed(&queue->n_delivered, &stats->delivered);
+    atomic_read_relaxed(&queue->n_no_consumer, &stats->no_consumer);
+    stats->depth = ops_sai_ring_count(&ring->ring);
+    stats->capacity = SAI_RX_RING_SIZE;
+
+exit:
+    return status;
+}
+
+/*
+ * Look trap up in index. Called per packet by SAI receive thread.
+ */
+static struct rx_trap *
+__rx_trap_find(int32_t trap_id)
+{
+    uint32_t i = 0;
+    uint32_t slot = hash_int(trap_id, 0);
+    struct rx_trap *trap = NULL;
+
+    for (i = 0; i < SAI_RX_TRAP_INDEX_SIZE; i++, slot++) {
+        atomic_read_explicit(&rx_trap_index[slot % SAI_RX_TRAP_INDEX_SIZE],
+                             &trap, memory_order_acquire);
+        if (!trap || trap->trap_id == trap_id) {
+            return trap;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Publish filled trap entry in first free slot of its probe sequence.
+ */
+static void
+__rx_trap_index_add(struct rx_trap *trap)
+{
+    uint32_t slot = hash_int(trap->trap_id, 0);
+    struct rx_trap *pos = NULL;
+
+    for (;; slot++) {
+        atomic_read_relaxed(&rx_trap_index[slot % SAI_RX_TRAP_INDEX_SIZE],
+                            &pos);
+        if (!pos) {
+            atomic_store_explicit(
+                &rx_trap_index[slot % SAI_RX_TRAP_INDEX_SIZE], trap,
+                memory_order_release);
+            return;
+        }
+    }
+}
+
+static struct rx_queue *
+__rx_queue_find(const char *name)
+{
+    struct rx_queue *queue = NULL;
+
+    LIST_FOR_EACH(queue, list_node, &rx_queues) {
+        if (!strcmp(queue->name, name)) {
+            return queue;
+        }
+    }
+
+    return NULL;
+}
+
+static struct rx_ring *
+__rx_queue_ring(struct rx_queue *queue)
+{
+    struct rx_ring *ring = NULL;
+
+    atomic_read_explicit(&queue->ring, &ring, memory_order_acquire);
+
+    return ring;
+}
+
+static int
+__rx_ring_create(uint32_t frame_size, struct rx_ring **ringp)
+{
+    int status = 0;
+    struct rx_ring *ring = xzalloc(sizeof *ring);
+
+    ring->frame_size = frame_size;
+    status = ops_sai_ring_init(&ring->ring, SAI_RX_RING_SIZE,
+                               sizeof(struct ops_sai_rx_packet) + frame_size);
+    if (status) {
+        free(ring);
+        ring = NULL;
+    }
+
+    *ringp = ring;
+    return status;
+}
+
+static void
+__rx_ring_destroy(struct rx_ring *ring)
+{
+    ops_sai_ring_destroy(&ring->ring);
+    free(ring);
+}
+
+/*
+ * Replace ring of queue by ring with rx_frame_size slots. Worker is stopped
+ * meanwhile, so main thread owns consumer side of both rings. Packets queued
+ * before replacement, including those SAI receive thread commits after it,
+ * are delivered before new ones and old ring is freed.
+ */
+static void
+__rx_queue_ring_replace(struct rx_queue *queue)
+{
+    int status = 0;
+    struct rx_ring *ring = NULL;
+    struct rx_ring *old = __rx_queue_ring(queue);
+
+    status = __rx_ring_create(rx_frame_size, &ring);
+    ERRNO_LOG_EXIT(status, "Failed to grow receive queue (name: %s)",
+                   queue->name);
+
+    __rx_worker_stop(queue);
+
+    atomic_store(&queue->ring, ring);
+
+    /* Writers which read old ring may still hold reserved slot in it. */
+    __rx_writers_wait();
+
+    while (!ops_sai_ring_is_empty(&old->ring)) {
+        __rx_queue_drain(queue, old);
+    }
+    queue->n_retired_dropped += ops_sai_ring_dropped_get(&old->ring);
+    __rx_ring_destroy(old);
+
+    __rx_worker_start(queue);
+
+exit:
+    return;
+}
+
+/*
+ * Wait until SAI receive threads which may have read queue or ring before it
+ * was unpublished commit their packets. Posting packet is short, so wait is
+ * short too.
+ */
+static void
+__rx_writers_wait(void)
+{
+    uint32_t n_writers = 0;
+
+    atomic_read(&rx_n_writers, &n_writers);
+    while (n_writers) {
+        sched_yield();
+        atomic_read(&rx_n_writers, &n_writers);
+    }
+}
+
+/*
+ * Hand at most SAI_RX_BATCH_MAX packets of queue ring to consumers. Called by
+ * thread which owns consumer side of queue ring.
+ */
+static void
+__rx_queue_drain(struct rx_queue *queue, struct rx_ring *ring)
+{
+    static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 5);
+    size_t n = 0;
+    uint64_t orig = 0;
+    bool is_delivered = false;
+    struct rx_trap *trap = NULL;
+    const struct ops_sai_rx_packet *packet = NULL;
+
+    ops_sai_ring_wake_clear(&ring->ring);
+
+    for (n = 0; n < SAI_RX_BATCH_MAX; n++) {
+        packet = ops_sai_ring_peek(&ring->ring);
+        if (!packet) {
+            break;
+        }
+
+        is_delivered = false;
+        trap = __rx_trap_find(packet->trap_id);
+        if (trap) {
+            ovs_mutex_lock(&trap->mutex);
+            if (trap->cb) {
+                trap->cb(packet, trap->aux);
+                is_delivered = true;
+            }
+            ovs_mutex_unlock(&trap->mutex);
+        }
+
+        if (is_delivered) {
+            atomic_add_relaxed(&queue->n_delivered, 1, &orig);
+        } else {
+            atomic_add_relaxed(&queue->n_no_consumer, 1, &orig);
+            VLOG_WARN_RL(&rl, "Trap on callback channel has no consumer, "
+                         "packet dropped (trap: %d, queue: %s)",
+                         packet->trap_id, queue->name);
+        }
+
+        ops_sai_ring_release(&ring->ring);
+    }
+}
+
+static void
+__rx_worker_start(struct rx_queue *queue)
+{
+    if (SAI_RX_WORKER_NONE == queue->worker_core) {
+        return;
+    }
+
+    VLOG_INFO("Starting receive worker (name: %s, core: %d)", queue->name,
+              queue->worker_core);
+
+    latch_poll(&queue->worker_exit);
+    queue->worker = ovs_thread_create("sai_rx", __rx_worker_main, queue);
+    queue->has_worker = true;
+}
+
+static void
+__rx_worker_stop(struct rx_queue *queue)
+{
+    if (!queue->has_worker) {
+        return;
+    }
+
+    VLOG_INFO("Stopping receive worker (name: %s)", queue->name);
+
+    latch_set(&queue->worker_exit);
+    xpthread_join(queue->worker, NULL);
+    queue->has_worker = false;
+}
+
+static void *
+__rx_worker_main(void *arg)
+{
+    int err = 0;
+    cpu_set_t cpus;
+    struct rx_ring *ring = NULL;
+    struct rx_queue *queue = arg;
+
+    if (queue->worker_core >= 0) {
+        CPU_ZERO(&cpus);
+        CPU_SET(queue->worker_core, &cpus);
+        err = pthread_setaffinity_np(pthread_self(), sizeof cpus, &cpus);
+        if (err) {
+            VLOG_WARN("Failed to pin receive worker, running unpinned "
+                      "(name: %s, core: %d, error: %s)", queue->name,
+                      queue->worker_core, ovs_strerror(err));
+        }
+    }
+
+    while (!latch_is_set(&queue->worker_exit)) {
+        ring = __rx_queue_ring(queue);
+        __rx_queue_drain(queue, ring);
+
+        ops_sai_ring_wait(&ring->ring);
+        latch_wait(&queue->worker_exit);
+        poll_block();
+    }
+
+    return NULL;
+}
@@ -0,0 +1,751 @@
+/*
+ * Copyright Mellanox Technologies, Ltd. 2001-2016.
+ * This software product is licensed under Apache version 2, as detailed in
+ * the COPYING file.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include <util.h>
+#include <hmap.h>
+#include <hash.h>
+#include <sset.h>
+#include <packets.h>
+#include <timeval.h>
+#include <unixctl.h>
+#include <seq.h>
+#include <poll-loop.h>
+#include <collectors.h>
+#include <ovs-thread.h>
+#include <dynamic-string.h>
+
+#include <sai-log.h>
+#include <sai-common.h>
+#include <sai-api-class.h>
+#include <sai-rx.h>
+#include <sai-sflow.h>
+
+#define SFLOW_COLLECTOR_PORT        (6343)
+#define SFLOW_VERSION               (5)
+/* Datagrams are kept below path MTU, as by other sFlow agents. */
+#define SFLOW_DATAGRAM_MAX          (1400)
+/* Version, address type, IPv6 address, sub-agent ID, sequence number, uptime
+ * and number of samples. */
+#define SFLOW_DATAGRAM_HEADER_MAX   (40)
+#define SFLOW_SAMPLES_MAX \
+    (SFLOW_DATAGRAM_MAX - SFLOW_DATAGRAM_HEADER_MAX)
+/* Flow sample with single raw packet header record, without header bytes. */
+#define SFLOW_FLOW_SAMPLE_LEN       (64)
+#define SFLOW_HEADER_LEN_DEFAULT    (128)
+#define SFLOW_HEADER_LEN_MAX        (256)
+/* Samples wait for datagram to fill at most this long. */
+#define SFLOW_FLUSH_INTERVAL_MS     (1000)
+
+#define SFLOW_ADDRESS_IP4           (1)
+#define SFLOW_ADDRESS_IP6           (2)
+#define SFLOW_FLOW_SAMPLE           (1)
+#define SFLOW_RECORD_RAW_HEADER     (1)
+#define SFLOW_HEADER_ETHERNET       (1)
+#define SFLOW_FCS_LEN               (4)
+
+VLOG_DEFINE_THIS_MODULE(sai_sflow);
+
+/* Port which is sampled while sFlow is enabled. */
+struct sflow_port {
+    struct hmap_node node;          /* In 'sflow_ports', by port object ID. */
+    uint32_t hw_id;
+    uint32_t ifindex;               /* Of port host interface, reported as
+                                     * sFlow ifIndex, 0 if unknown. */
+    sai_object_id_t oid;
+    uint32_t sample_seq;            /* Flow samples of port. */
+    uint32_t sample_pool;           /* Packets samples of port stand for. */
+};
+
+/*
+ * sFlow agent. Samples are added by the thread serving sampled packets trap,
+ * which is receive worker of S_FLOW trap group by default, configuration is
+ * changed by main thread.
+ */
+struct sflow_agent {
+    bool enabled;
+    struct sset targets;
+    struct collectors *collectors;
+    uint32_t rate;
+    uint32_t header_len;
+    uint32_t sub_id;
+    bool is_ip6;
+    ovs_be32 ip4;
+    struct in6_addr ip6;
+    uint32_t directions;            /* Bitmap of ops_sai_sflow_direction. */
+    long long int start_time;       /* Uptime reference. */
+    uint32_t datagram_seq;
+    uint32_t n_sampled;             /* Flow samples of all ports. */
+    /* Sequence and pool of samples from ports which are not sampled, e.g.
+     * ingress ports of packets sampled on egress. */
+    uint32_t sample_seq;
+    uint32_t sample_pool;
+    /* Samples of datagram being built. */
+    uint8_t samples[SFLOW_SAMPLES_MAX];
+    size_t samples_len;
+    uint32_t n_samples;
+    long long int first_sample_time;
+    struct seq *seq;                /* Changed when datagram gets its first
+                                     * sample, so that main loop arms flush
+                                     * timer. */
+};
+
+static struct ovs_mutex sflow_mutex = OVS_MUTEX_INITIALIZER;
+static struct sflow_agent sflow_agent OVS_GUARDED_BY(sflow_mutex) = {
+    .targets = SSET_INITIALIZER(&sflow_agent.targets),
+    .directions = OPS_SAI_SFLOW_INGRESS,
+};
+static struct hmap sflow_ports OVS_GUARDED_BY(sflow_mutex)
+    = HMAP_INITIALIZER(&sflow_ports);
+/* Consumer of sampled packets trap is registered, main thread only. */
+static bool sflow_consumer_registered = false;
+/* Hardware sampling session, generic class only. */
+static sai_object_id_t sflow_session = SAI_NULL_OBJECT_ID;
+
+static void __sflow_disable(void);
+static int __sflow_configure(const struct ops_sai_sflow_options *)
+    OVS_REQUIRES(sflow_mutex);
+static void __sflow_agent_ip_set(const char *) OVS_REQUIRES(sflow_mutex);
+static void __sflow_ports_program(uint32_t) OVS_REQUIRES(sflow_mutex);
+static struct sflow_port *__sflow_port_find(uint32_t)
+    OVS_REQUIRES(sflow_mutex);
+static void __sflow_sample_receive(const struct ops_sai_rx_packet *, void *);
+static void __sflow_flush(void) OVS_REQUIRES(sflow_mutex);
+static void __put32(uint8_t *, size_t *, uint32_t);
+static void __put_bytes(uint8_t *, size_t *, const void *, size_t);
+static const char *__sflow_direction_str(uint32_t);
+static void __sflow_show(struct unixctl_conn *, int, const char *[], void *);
+static void __sflow_direction_cmd(struct unixctl_conn *, int, const char *[],
+                                  void *);
+
+/**
+ * Enable, reconfigure or disable sFlow. Sampled packets are exported as sFlow
+ * version 5 flow samples with raw packet header to collectors.
+ *
+ * @param[in] options - sFlow options, NULL disables sFlow.
+ *
+ * @return 0 operation completed successfully
+ * @return errno operation failed
+ */
+int
+ops_sai_sflow_set(const struct ops_sai_sflow_options *options)
+{
+    int err = 0;
+
+    if (!options) {
+        __sflow_disable();
+        goto exit;
+    }
+
+    if (!options->sampling_rate) {
+        err = EINVAL;
+        ERRNO_LOG_EXIT(err, "Invalid sFlow sampling rate");
+    }
+
+    ovs_mutex_lock(&sflow_mutex);
+    err = __sflow_configure(options);
+    ovs_mutex_unlock(&sflow_mutex);
+    ERRNO_EXIT(err);
+
+    if (!sflow_consumer_registered) {
+        err = ops_sai_rx_consumer_register(SAI_HOSTIF_TRAP_ID_SAMPLEPACKET,
+                                           __sflow_sample_receive, NULL);
+        ERRNO_LOG_EXIT(err, "Sampled packets are not received, S_FLOW trap "
+                       "group must use callback channel");
+        sflow_consumer_registered = true;
+    }
+
+exit:
+    return err;
+}
+
+/**
+ * Add port to or remove it from sampled ports. Port is sampled only while
+ * sFlow is enabled.
+ *
+ * @param[in] hw_id   - port label id.
+ * @param[in] ifindex - index of port host interface, 0 if unknown.
+ * @param[in] enable  - port should be sampled.
+ *
+ * @return 0 operation completed successfully
+ * @return errno operation failed
+ */
+int
+ops_sai_sflow_port_set(uint32_t hw_id, uint32_t ifindex, bool enable)
+{
+    int err = 0;
+    struct sflow_port *port = NULL;
+
+    ovs_mutex_lock(&sflow_mutex);
+
+    port = __sflow_port_find(hw_id);
+    if (enable && !port) {
+        port = xzalloc(sizeof *port);
+        port->hw_id = hw_id;
+        port->ifindex = ifindex;
+        port->oid = ops_sai_api_hw_id2port_id(hw_id);
+        hmap_insert(&sflow_ports, &port->node, hash_uint64(port->oid));
+
+        if (sflow_agent.enabled) {
+            err = ops_sai_sflow_port_sampling_set(hw_id,
+                                                  sflow_agent.directions);
+        }
+    } else if (!enable && port) {
+        if (sflow_agent.enabled) {
+            err = ops_sai_sflow_port_sampling_set(hw_id, 0);
+        }
+
+        hmap_remove(&sflow_ports, &port->node);
+        free(port);
+    }
+
+    ovs_mutex_unlock(&sflow_mutex);
+
+    ERRNO_LOG(err, "Failed to %s sampling of port %u",
+              enable ? "enable" : "disable", hw_id);
+    return err;
+}
+
+/**
+ * Send datagram of samples which waited for too long.
+ */
+void
+ops_sai_sflow_run(void)
+{
+    ovs_mutex_lock(&sflow_mutex);
+    if (sflow_agent.n_samples &&
+        time_msec() >= sflow_agent.first_sample_time
+                       + SFLOW_FLUSH_INTERVAL_MS) {
+        __sflow_flush();
+    }
+    ovs_mutex_unlock(&sflow_mutex);
+}
+
+/**
+ * Make main loop wake up when waiting samples should be sent, or when the
+ * first of them is added by receive worker.
+ */
+void
+ops_sai_sflow_wait(void)
+{
+    ovs_mutex_lock(&sflow_mutex);
+    if (sflow_agent.n_samples) {
+        poll_timer_wait_until(sflow_agent.first_sample_time
+                              + SFLOW_FLUSH_INTERVAL_MS);
+    } else if (sflow_agent.seq) {
+        seq_wait(sflow_agent.seq, seq_read(sflow_agent.seq));
+    }
+    ovs_mutex_unlock(&sflow_mutex);
+}
+
+/**
+ * Register sFlow appctl commands.
+ */
+void
+ops_sai_sflow_unixctl_register(void)
+{
+    unixctl_command_register("sai/sflow/show", "", 0, 0, __sflow_show, NULL);
+    unixctl_command_register("sai/sflow/direction", "[ingress|egress|both]",
+                             0, 1, __sflow_direction_cmd, NULL);
+}
+
+/*
+ * Stop receiving samples, unbind ports and remove sampling session. Waiting
+ * samples are sent. Sampled ports are remembered for next enable.
+ */
+static void
+__sflow_disable(void)
+{
+    int err = 0;
+    struct sflow_port *port = NULL;
+
+    if (sflow_consumer_registered) {
+        ops_sai_rx_consumer_unregister(SAI_HOSTIF_TRAP_ID_SAMPLEPACKET);
+        sflow_consumer_registered = false;
+    }
+
+    ovs_mutex_lock(&sflow_mutex);
+
+    if (sflow_agent.enabled) {
+        HMAP_FOR_EACH(port, node, &sflow_ports) {
+            err = ops_sai_sflow_port_sampling_set(port->hw_id, 0);
+            ERRNO_LOG(err, "Failed to disable sampling of port %u",
+                      port->hw_id);
+        }
+
+        err = ops_sai_sflow_rate_set(0);
+        ERRNO_LOG(err, "Failed to remove sampling session");
+
+        __sflow_flush();
+        collectors_destroy(sflow_agent.collectors);
+        sflow_agent.collectors = NULL;
+        sset_clear(&sflow_agent.targets);
+        sflow_agent.rate = 0;
+        sflow_agent.enabled = false;
+
+        VLOG_INFO("sFlow disabled");
+    }
+
+    ovs_mutex_unlock(&sflow_mutex);
+}
+
+/*
+ * Apply options to agent and hardware. Collectors are reopened only when
+ * targets change, as options are set on every bridge reconfiguration.
+ */
+static int
+__sflow_configure(const struct ops_sai_sflow_options *options)
+{
+    int err = 0;
+
+    if (!sset_equals(&sflow_agent.targets, options->targets)) {
+        __sflow_flush();
+        collectors_destroy(sflow_agent.collectors);
+        sflow_agent.collectors = NULL;
+        sset_destroy(&sflow_agent.targets);
+        sset_clone(&sflow_agent.targets, options->targets);
+
+        /* Collectors which could be opened are used. */
+        err = collectors_create(options->targets, SFLOW_COLLECTOR_PORT,
+                                &sflow_agent.collectors);
+        ERRNO_LOG(err, "Failed to open sFlow collectors");
+        err = 0;
+    }
+
+    __sflow_agent_ip_set(options->agent_ip);
+    sflow_agent.header_len = MIN(options->header_len
+                                 ? options->header_len
+                                 : SFLOW_HEADER_LEN_DEFAULT,
+                                 SFLOW_HEADER_LEN_MAX);
+    sflow_agent.sub_id = options->sub_id;
+
+    if (sflow_agent.rate != options->sampling_rate) {
+        err = ops_sai_sflow_rate_set(options->sampling_rate);
+        ERRNO_LOG_EXIT(err, "Failed to set sampling rate %u",
+                       options->sampling_rate);
+        sflow_agent.rate = options->sampling_rate;
+    }
+
+    if (!sflow_agent.seq) {
+        sflow_agent.seq = seq_create();
+    }
+
+    if (!sflow_agent.enabled) {
+        sflow_agent.enabled = true;
+        sflow_agent.start_time = time_msec();
+        __sflow_ports_program(sflow_agent.directions);
+
+        VLOG_INFO("sFlow enabled (rate: %u, collectors: %"PRIuSIZE")",
+                  sflow_agent.rate, sset_count(&sflow_agent.targets));
+    }
+
+exit:
+    return err;
+}
+
+/*
+ * Agent address is not known unless configured, zero address is reported
+ * then.
+ */
+static void
+__sflow_agent_ip_set(const char *agent_ip)
+{
+    sflow_agent.is_ip6 = false;
+    sflow_agent.ip4 = htonl(0);
+    memset(&sflow_agent.ip6, 0, sizeof sflow_agent.ip6);
+
+    if (!agent_ip || !agent_ip[0] || ip_parse(agent_ip, &sflow_agent.ip4)) {
+        return;
+    }
+
+    if (ipv6_parse(agent_ip, &sflow_agent.ip6)) {
+        sflow_agent.is_ip6 = true;
+        return;
+    }
+
+    VLOG_WARN("Invalid sFlow agent address %s", agent_ip);
+}
+
+static void
+__sflow_ports_program(uint32_t directions)
+{
+    int err = 0;
+    struct sflow_port *port = NULL;
+
+    HMAP_FOR_EACH(port, node, &sflow_ports) {
+        err = ops_sai_sflow_port_sampling_set(port->hw_id, directions);
+        ERRNO_LOG(err, "Failed to set sampling of port %u", port->hw_id);
+    }
+}
+
+static struct sflow_port *
+__sflow_port_find(uint32_t hw_id)
+{
+    struct sflow_port *port = NULL;
+
+    HMAP_FOR_EACH(port, node, &sflow_ports) {
+        if (port->hw_id == hw_id) {
+            return port;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Consumer of sampled packets trap. Appends flow sample to datagram, which is
+ * sent when it is full or its first sample waited for too long.
+ */
+static void
+__sflow_sample_receive(const struct ops_sai_rx_packet *packet,
+                       void *aux OVS_UNUSED)
+{
+    size_t len = 0;
+    uint32_t input = 0;
+    uint32_t header_len = 0;
+    uint32_t sample_len = 0;
+    uint32_t *sample_seq = NULL;
+    uint32_t *sample_pool = NULL;
+    uint8_t *samples = NULL;
+    struct sflow_port *port = NULL;
+
+    ovs_mutex_lock(&sflow_mutex);
+
+    if (!sflow_agent.enabled) {
+        goto exit;
+    }
+
+    sample_seq = &sflow_agent.sample_seq;
+    sample_pool = &sflow_agent.sample_pool;
+    HMAP_FOR_EACH_WITH_HASH(port, node, hash_uint64(packet->in_port),
+                            &sflow_ports) {
+        if (port->oid == packet->in_port) {
+            input = port->ifindex;
+            sample_seq = &port->sample_seq;
+            sample_pool = &port->sample_pool;
+            break;
+        }
+    }
+
+    header_len = MIN(packet->size, sflow_agent.header_len);
+    sample_len = SFLOW_FLOW_SAMPLE_LEN + ROUND_UP(header_len, 4);
+    if (sflow_agent.samples_len + sample_len > SFLOW_SAMPLES_MAX) {
+        __sflow_flush();
+    }
+
+    *sample_pool += sflow_agent.rate;
+    sflow_agent.n_sampled++;
+    samples = sflow_agent.samples;
+    len = sflow_agent.samples_len;
+
+    __put32(samples, &len, SFLOW_FLOW_SAMPLE);
+    __put32(samples, &len, sample_len - 8);
+    __put32(samples, &len, ++*sample_seq);
+    __put32(samples, &len, input);          /* Source: ifIndex of port. */
+    __put32(samples, &len, sflow_agent.rate);
+    __put32(samples, &len, *sample_pool);
+    __put32(samples, &len, 0);              /* Drops. */
+    __put32(samples, &len, input);
+    __put32(samples, &len, 0);              /* Output port is unknown. */
+    __put32(samples, &len, 1);              /* Records. */
+
+    __put32(samples, &len, SFLOW_RECORD_RAW_HEADER);
+    __put32(samples, &len, sample_len - SFLOW_FLOW_SAMPLE_LEN + 16);
+    __put32(samples, &len, SFLOW_HEADER_ETHERNET);
+    __put32(samples, &len, packet->size + SFLOW_FCS_LEN);
+    __put32(samples, &len, SFLOW_FCS_LEN);  /* Stripped. */
+    __put32(samples, &len, header_len);
+    __put_bytes(samples, &len, packet->data, header_len);
+
+    sflow_agent.samples_len = len;
+    if (!sflow_agent.n_samples++) {
+        sflow_agent.first_sample_time = time_msec();
+        seq_change(sflow_agent.seq);
+    } else if (time_msec() >= sflow_agent.first_sample_time
+                              + SFLOW_FLUSH_INTERVAL_MS) {
+        __sflow_flush();
+    }
+
+exit:
+    ovs_mutex_unlock(&sflow_mutex);
+}
+
+/*
+ * Send waiting samples to collectors in single datagram.
+ */
+static void
+__sflow_flush(void)
+{
+    size_t len = 0;
+    uint8_t datagram[SFLOW_DATAGRAM_MAX];
+
+    if (!sflow_agent.n_samples) {
+        return;
+    }
+
+    __put32(datagram, &len, SFLOW_VERSION);
+    if (sflow_agent.is_ip6) {
+        __put32(datagram, &len, SFLOW_ADDRESS_IP6);
+        __put_bytes(datagram, &len, &sflow_agent.ip6,
+                    sizeof sflow_agent.ip6);
+    } else {
+        __put32(datagram, &len, SFLOW_ADDRESS_IP4);
+        __put_bytes(datagram, &len, &sflow_agent.ip4,
+                    sizeof sflow_agent.ip4);
+    }
+    __put32(datagram, &len, sflow_agent.sub_id);
+    __put32(datagram, &len, ++sflow_agent.datagram_seq);
+    __put32(datagram, &len, time_msec() - sflow_agent.start_time);
+    __put32(datagram, &len, sflow_agent.n_samples);
+    __put_bytes(datagram, &len, sflow_agent.samples,
+                sflow_agent.samples_len);
+
+    if (sflow_agent.collectors) {
+        collectors_send(sflow_agent.collectors, datagram, len);
+    }
+
+    sflow_agent.samples_len = 0;
+    sflow_agent.n_samples = 0;
+}
+
+/*
+ * Append big endian 32 bit value, as sFlow uses XDR encoding.
+ */
+static void
+__put32(uint8_t *buf, size_t *len, uint32_t value)
+{
+    ovs_be32 be_value = htonl(value);
+
+    memcpy(buf + *len, &be_value, sizeof be_value);
+    *len += sizeof be_value;
+}
+
+/*
+ * Append opaque data padded to 4 bytes.
+ */
+static void
+__put_bytes(uint8_t *buf, size_t *len, const void *data, size_t size)
+{
+    memcpy(buf + *len, data, size);
+    memset(buf + *len + size, 0, ROUND_UP(size, 4) - size);
+    *len += ROUND_UP(size, 4);
+}
+
+static const char *
+__sflow_direction_str(uint32_t directions)
+{
+    return OPS_SAI_SFLOW_BOTH == directions ? "both"
+           : OPS_SAI_SFLOW_EGRESS == directions ? "egress" : "ingress";
+}
+
+/*
+ * appctl sai/sflow/show: sFlow configuration and counters.
+ */
+static void
+__sflow_show(struct unixctl_conn *conn, int argc OVS_UNUSED,
+             const char *argv[] OVS_UNUSED, void *aux OVS_UNUSED)
+{
+    const char *target = NULL;
+    char ip6[INET6_ADDRSTRLEN];
+    struct ds ds = DS_EMPTY_INITIALIZER;
+
+    ovs_mutex_lock(&sflow_mutex);
+
+    ds_put_format(&ds, "sFlow: %s\n",
+                  sflow_agent.enabled ? "enabled" : "disabled");
+    ds_put_format(&ds, "Direction: %s\n",
+                  __sflow_direction_str(sflow_agent.directions));
+    ds_put_format(&ds, "Sampled ports: %"PRIuSIZE"\n",
+                  hmap_count(&sflow_ports));
+
+    if (sflow_agent.enabled) {
+        ds_put_format(&ds, "Sampling rate: 1 in %u\n", sflow_agent.rate);
+        ds_put_format(&ds, "Header length: %u\n", sflow_agent.header_len);
+        ds_put_format(&ds, "Sub-agent ID: %u\n", sflow_agent.sub_id);
+        if (sflow_agent.is_ip6) {
+            inet_ntop(AF_INET6, &sflow_agent.ip6, ip6, sizeof ip6);
+            ds_put_format(&ds, "Agent address: %s\n", ip6);
+        } else {
+            ds_put_format(&ds, "Agent address: "IP_FMT"\n",
+                          IP_ARGS(sflow_agent.ip4));
+        }
+        ds_put_cstr(&ds, "Collectors:");
+        SSET_FOR_EACH(target, &sflow_agent.targets) {
+            ds_put_format(&ds, " %s", target);
+        }
+        ds_put_char(&ds, '\n');
+        ds_put_format(&ds, "Samples: %u\n", sflow_agent.n_sampled);
+        ds_put_format(&ds, "Datagrams: %u\n", sflow_agent.datagram_seq);
+    }
+
+    ovs_mutex_unlock(&sflow_mutex);
+
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
+}
+
+/*
+ * appctl sai/sflow/direction [ingress|egress|both]: show or set directions of
+ * sampled port traffic.
+ */
+static void
+__sflow_direction_cmd(struct unixctl_conn *conn, int argc,
+                      const char *argv[], void *aux OVS_UNUSED)
+{
+    uint32_t directions = 0;
+
+    if (argc < 2) {
+        ovs_mutex_lock(&sflow_mutex);
+        directions = sflow_agent.directions;
+        ovs_mutex_unlock(&sflow_mutex);
+        unixctl_command_reply(conn, __sflow_direction_str(directions));
+        return;
+    }
+
+    if (!strcmp(argv[1], "ingress")) {
+        directions = OPS_SAI_SFLOW_INGRESS;
+    } else if (!strcmp(argv[1], "egress")) {
+        directions = OPS_SAI_SFLOW_EGRESS;
+    } else if (!strcmp(argv[1], "both")) {
+        directions = OPS_SAI_SFLOW_BOTH;
+    } else {
+        unixctl_command_reply_error(conn, "Invalid direction");
+        return;
+    }
+
+    ovs_mutex_lock(&sflow_mutex);
+    if (sflow_agent.directions != directions) {
+        sflow_agent.directions = directions;
+        if (sflow_agent.enabled) {
+            __sflow_ports_program(directions);
+        }
+    }
+    ovs_mutex_unlock(&sflow_mutex);
+
+    unixctl_command_reply(conn, NULL);
+}
+
+/*
+ * Initialize sampling.
+ */
+static void
+__sflow_init(void)
+{
+    VLOG_INFO("Initializing sFlow");
+
+    sflow_session = SAI_NULL_OBJECT_ID;
+}
+
+/*
+ * Create sampling session or change its rate, remove it if rate is 0.
+ *
+ * @param[in] rate - one of rate packets is sampled.
+ *
+ * @return 0 operation completed successfully
+ * @return errno operation failed
+ */
+static int
+__sflow_rate_set(uint32_t rate)
+{
+    sai_attribute_t attr[2] = { };
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
+
+    if (!sai_api->samplepacket_api) {
+        status = SAI_STATUS_NOT_SUPPORTED;
+        SAI_ERROR_LOG_EXIT(status, "Packet sampling is not supported");
+    }
+
+    if (!rate) {
+        if (SAI_NULL_OBJECT_ID != sflow_session) {
+            status = sai_api->samplepacket_api->
+                     remove_samplepacket_session(sflow_session);
+            SAI_ERROR_LOG_EXIT(status, "Failed to remove sampling session");
+            sflow_session = SAI_NULL_OBJECT_ID;
+        }
+        goto exit;
+    }
+
+    attr[0].id = SAI_SAMPLEPACKET_ATTR_SAMPLE_RATE;
+    attr[0].value.u32 = rate;
+
+    if (SAI_NULL_OBJECT_ID != sflow_session) {
+        status = sai_api->samplepacket_api->
+                 set_samplepacket_attribute(sflow_session, &attr[0]);
+        SAI_ERROR_LOG_EXIT(status, "Failed to set sampling rate %u", rate);
+        goto exit;
+    }
+
+    attr[1].id = SAI_SAMPLEPACKET_ATTR_TYPE;
+    attr[1].value.s32 = SAI_SAMPLEPACKET_SLOW_PATH;
+
+    status = sai_api->samplepacket_api->
+             create_samplepacket_session(&sflow_session, ARRAY_SIZE(attr),
+                                         attr);
+    SAI_ERROR_LOG_EXIT(status, "Failed to create sampling session "
+                       "(rate: %u)", rate);
+
+exit:
+    return SAI_ERROR_2_ERRNO(status);
+}
+
+/*
+ * Bind port to sampling session in given directions.
+ *
+ * @param[in] hw_id      - port label id.
+ * @param[in] directions - bitmap of ops_sai_sflow_direction.
+ *
+ * @return 0 operation completed successfully
+ * @return errno operation failed
+ */
+static int
+__sflow_port_set(uint32_t hw_id, uint32_t directions)
+{
+    sai_attribute_t attr = { };
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    sai_object_id_t port_oid = ops_sai_api_hw_id2port_id(hw_id);
+    const struct ops_sai_api_class *sai_api = ops_sai_api_get_instance();
+
+    ovs_assert(!directions || SAI_NULL_OBJECT_ID != sflow_session);
+
+    attr.id = SAI_PORT_ATTR_INGRESS_SAMPLEPACKET_ENABLE;
+    attr.value.oid = directions & OPS_SAI_SFLOW_INGRESS
+                     ? sflow_session : SAI_NULL_OBJECT_ID;
+    status = sai_api->port_api->set_port_attribute(port_oid, &attr);
+    SAI_ERROR_LOG_EXIT(status, "Failed to set ingress sampling of port %u",
+                       hw_id);
+
+    attr.id = SAI_PORT_ATTR_EGRESS_SAMPLEPACKET_ENABLE;
+    attr.value.oid = directions & OPS_SAI_SFLOW_EGRESS
+                     ? sflow_session : SAI_NULL_OBJECT_ID;
+    status = sai_api->port_api->set_port_attribute(port_oid, &attr);
+    SAI_ERROR_LOG_EXIT(status, "Failed to set egress sampling of port %u",
+                       hw_id);
+
+exit:
+    return SAI_ERROR_2_ERRNO(status);
+}
+
+/*
+ * De-initialize sampling. Session is removed when sFlow is disabled.
+ */
+static void
+__sflow_deinit(void)
+{
+    VLOG_INFO("De-initializing sFlow");
+}
+
+DEFINE_GENERIC_CLASS(struct sflow_class, sflow) = {
+    .init = __sflow_init,
+    .rate_set = __sflow_rate_set,
+    .port_set = __sflow_port_set,
+    .deinit = __sflow_deinit,
+};
+
+DEFINE_GENERIC_CLASS_GETTER(struct sflow_class, sflow);
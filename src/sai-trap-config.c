@@ -0,0 +1,591 @@
+/*
+ * Copyright Mellanox Technologies, Ltd. 2001-2016.
+ * This software product is licensed under Apache version 2, as detailed in
+ * the COPYING file.
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <yaml.h>
+
+#include <util.h>
+#include <shash.h>
+
+#include <sai-log.h>
+#include <sai-trap-config.h>
+
+/*
+ * Trap group configuration file:
+ *
+ * policers:
+ *   - name: arp
+ *     rate: 1000
+ *     burst: 1000
+ *     rate_min: 100          # optional, enables adaptive tuning
+ *     rate_ceil: 1000        # optional
+ * trap_groups:
+ *   - name: sai_trap_group_arp
+ *     traps: [arp_request, arp_response, ipv6_neighbor_discovery]
+ *     priority: 2
+ *     queue: 2               # optional CPU queue
+ *     policer: arp
+ *     log: true
+ *     l3: true
+ *     channel: netdev        # netdev or callback
+ *     worker: true           # optional, callback channel only: serve
+ *                            # receive queue from dedicated thread
+ *     core: 3                # optional, pin worker to CPU core
+ */
+
+VLOG_DEFINE_THIS_MODULE(sai_trap_config);
+
+struct policer_profile {
+    struct ops_sai_policer_config config;
+    uint32_t rate_min;
+    uint32_t rate_ceil;
+};
+
+struct trap_name {
+    const char *name;
+    int id;
+};
+
+static const struct trap_name trap_names[] = {
+    { "stp", SAI_HOSTIF_TRAP_ID_STP },
+    { "lacp", SAI_HOSTIF_TRAP_ID_LACP },
+    { "eapol", SAI_HOSTIF_TRAP_ID_EAPOL },
+    { "lldp", SAI_HOSTIF_TRAP_ID_LLDP },
+    { "pvrst", SAI_HOSTIF_TRAP_ID_PVRST },
+    { "igmp_type_query", SAI_HOSTIF_TRAP_ID_IGMP_TYPE_QUERY },
+    { "igmp_type_leave", SAI_HOSTIF_TRAP_ID_IGMP_TYPE_LEAVE },
+    { "igmp_type_v1_report", SAI_HOSTIF_TRAP_ID_IGMP_TYPE_V1_REPORT },
+    { "igmp_type_v2_report", SAI_HOSTIF_TRAP_ID_IGMP_TYPE_V2_REPORT },
+    { "igmp_type_v3_report", SAI_HOSTIF_TRAP_ID_IGMP_TYPE_V3_REPORT },
+    { "samplepacket", SAI_HOSTIF_TRAP_ID_SAMPLEPACKET },
+    { "arp_request", SAI_HOSTIF_TRAP_ID_ARP_REQUEST },
+    { "arp_response", SAI_HOSTIF_TRAP_ID_ARP_RESPONSE },
+    { "dhcp", SAI_HOSTIF_TRAP_ID_DHCP },
+    { "ospf", SAI_HOSTIF_TRAP_ID_OSPF },
+    { "pim", SAI_HOSTIF_TRAP_ID_PIM },
+    { "vrrp", SAI_HOSTIF_TRAP_ID_VRRP },
+    { "bgp", SAI_HOSTIF_TRAP_ID_BGP },
+    { "dhcpv6", SAI_HOSTIF_TRAP_ID_DHCPV6 },
+    { "ospfv6", SAI_HOSTIF_TRAP_ID_OSPFV6 },
+    { "vrrpv6", SAI_HOSTIF_TRAP_ID_VRRPV6 },
+    { "bgpv6", SAI_HOSTIF_TRAP_ID_BGPV6 },
+    { "ipv6_neighbor_discovery", SAI_HOSTIF_TRAP_ID_IPV6_NEIGHBOR_DISCOVERY },
+    { "ipv6_mld_v1_v2", SAI_HOSTIF_TRAP_ID_IPV6_MLD_V1_V2 },
+    { "ipv6_mld_v1_report", SAI_HOSTIF_TRAP_ID_IPV6_MLD_V1_REPORT },
+    { "ipv6_mld_v1_done", SAI_HOSTIF_TRAP_ID_IPV6_MLD_V1_DONE },
+    { "mld_v2_report", SAI_HOSTIF_TRAP_ID_MLD_V2_REPORT },
+    { "ip2me", SAI_HOSTIF_TRAP_ID_IP2ME },
+    { "ssh", SAI_HOSTIF_TRAP_ID_SSH },
+    { "snmp", SAI_HOSTIF_TRAP_ID_SNMP },
+    { "l3_mtu_error", SAI_HOSTIF_TRAP_ID_L3_MTU_ERROR },
+    { "ttl_error", SAI_HOSTIF_TRAP_ID_TTL_ERROR },
+};
+
+static const char *__scalar(yaml_document_t *, yaml_node_t *);
+static int __scalar_u32(yaml_document_t *, yaml_node_t *, uint32_t *);
+static int __scalar_bool(yaml_document_t *, yaml_node_t *, bool *);
+static int __trap_id_get(const char *, int *);
+static bool __trap_ids_contain(const int *, int);
+static int __policers_parse(yaml_document_t *, yaml_node_t *, struct shash *);
+static int __policer_parse(yaml_document_t *, yaml_node_t *, struct shash *);
+static int __groups_parse(yaml_document_t *, yaml_node_t *,
+                          const struct shash *,
+                          struct ops_sai_trap_group_config **, size_t *);
+static int __group_parse(yaml_document_t *, yaml_node_t *,
+                         const struct shash *,
+                         struct ops_sai_trap_group_config *);
+static int __traps_parse(yaml_document_t *, yaml_node_t *, int *);
+
+/**
+ * Load trap group configuration from YAML file.
+ *
+ * @param[in]  path      - configuration file path.
+ * @param[out] configs   - array of trap group configurations, must be freed
+ *                         with ops_sai_trap_config_destroy().
+ * @param[out] n_configs - number of trap groups.
+ *
+ * @return 0 operation completed successfully
+ * @return ENOENT if file does not exist
+ * @return errno operation failed
+ */
+int
+ops_sai_trap_config_load(const char *path,
+                         struct ops_sai_trap_group_config **configs,
+                         size_t *n_configs)
+{
+    int status = 0;
+    FILE *file = NULL;
+    yaml_parser_t parser;
+    yaml_document_t document;
+    yaml_node_t *root = NULL;
+    yaml_node_pair_t *pair = NULL;
+    yaml_node_t *groups = NULL;
+    yaml_node_t *policers = NULL;
+    const char *key = NULL;
+    struct shash profiles = SHASH_INITIALIZER(&profiles);
+
+    NULL_PARAM_LOG_ABORT(path);
+    NULL_PARAM_LOG_ABORT(configs);
+    NULL_PARAM_LOG_ABORT(n_configs);
+
+    *configs = NULL;
+    *n_configs = 0;
+
+    file = fopen(path, "r");
+    if (NULL == file) {
+        return errno;
+    }
+
+    yaml_parser_initialize(&parser);
+    yaml_parser_set_input_file(&parser, file);
+
+    if (!yaml_parser_load(&parser, &document)) {
+        VLOG_ERR("Failed to parse %s (line: %zu, error: %s)", path,
+                 parser.problem_mark.line + 1,
+                 parser.problem ? parser.problem : "unknown");
+        yaml_parser_delete(&parser);
+        fclose(file);
+        return EINVAL;
+    }
+
+    root = yaml_document_get_root_node(&document);
+    if (!root || YAML_MAPPING_NODE != root->type) {
+        status = EINVAL;
+        ERRNO_LOG_EXIT(status, "Root of %s must be mapping", path);
+    }
+
+    for (pair = root->data.mapping.pairs.start;
+         pair < root->data.mapping.pairs.top; pair++) {
+        key = __scalar(&document, yaml_document_get_node(&document,
+                                                         pair->key));
+        if (key && !strcmp(key, "policers")) {
+            policers = yaml_document_get_node(&document, pair->value);
+        } else if (key && !strcmp(key, "trap_groups")) {
+            groups = yaml_document_get_node(&document, pair->value);
+        } else {
+            VLOG_WARN("Unknown key %s in %s", key ? key : "(null)", path);
+        }
+    }
+
+    if (policers) {
+        status = __policers_parse(&document, policers, &profiles);
+        ERRNO_LOG_EXIT(status, "Failed to parse policers of %s", path);
+    }
+
+    if (!groups) {
+        status = EINVAL;
+        ERRNO_LOG_EXIT(status, "No trap_groups in %s", path);
+    }
+
+    status = __groups_parse(&document, groups, &profiles, configs,
+                            n_configs);
+    ERRNO_LOG_EXIT(status, "Failed to parse trap groups of %s", path);
+
+exit:
+    shash_destroy_free_data(&profiles);
+    yaml_document_delete(&document);
+    yaml_parser_delete(&parser);
+    fclose(file);
+
+    if (status) {
+        ops_sai_trap_config_destroy(*configs, *n_configs);
+        *configs = NULL;
+        *n_configs = 0;
+    }
+
+    return status;
+}
+
+/**
+ * Copy trap group configuration to heap.
+ *
+ * @param[in] config - trap group configuration.
+ *
+ * @return copy, must be freed with ops_sai_trap_config_free().
+ */
+struct ops_sai_trap_group_config *
+ops_sai_trap_config_clone(const struct ops_sai_trap_group_config *config)
+{
+    struct ops_sai_trap_group_config *clone = NULL;
+
+    NULL_PARAM_LOG_ABORT(config);
+
+    clone = xmemdup(config, sizeof *config);
+    clone->name = xstrdup(config->name);
+
+    return clone;
+}
+
+/**
+ * Free trap group configuration returned by ops_sai_trap_config_clone().
+ *
+ * @param[in] config - trap group configuration.
+ */
+void
+ops_sai_trap_config_free(struct ops_sai_trap_group_config *config)
+{
+    if (config) {
+        free(CONST_CAST(char *, config->name));
+        free(config);
+    }
+}
+
+/**
+ * Free trap group configurations returned by ops_sai_trap_config_load().
+ *
+ * @param[in] configs   - array of trap group configurations.
+ * @param[in] n_configs - number of trap groups.
+ */
+void
+ops_sai_trap_config_destroy(struct ops_sai_trap_group_config *configs,
+                            size_t n_configs)
+{
+    size_t i = 0;
+
+    for (i = 0; i < n_configs; i++) {
+        free(CONST_CAST(char *, configs[i].name));
+    }
+    free(configs);
+}
+
+static const char *
+__scalar(yaml_document_t *document, yaml_node_t *node)
+{
+    if (!node || YAML_SCALAR_NODE != node->type) {
+        return NULL;
+    }
+
+    return (const char *) node->data.scalar.value;
+}
+
+static int
+__scalar_u32(yaml_document_t *document, yaml_node_t *node, uint32_t *value)
+{
+    const char *str = __scalar(document, node);
+
+    if (!str || !str_to_uint(str, 10, value)) {
+        return EINVAL;
+    }
+
+    return 0;
+}
+
+static int
+__scalar_bool(yaml_document_t *document, yaml_node_t *node, bool *value)
+{
+    const char *str = __scalar(document, node);
+
+    if (str && (!strcmp(str, "true") || !strcmp(str, "yes"))) {
+        *value = true;
+    } else if (str && (!strcmp(str, "false") || !strcmp(str, "no"))) {
+        *value = false;
+    } else {
+        return EINVAL;
+    }
+
+    return 0;
+}
+
+static int
+__trap_id_get(const char *name, int *trap_id)
+{
+    size_t i = 0;
+
+    for (i = 0; i < ARRAY_SIZE(trap_names); i++) {
+        if (!strcmp(trap_names[i].name, name)) {
+            *trap_id = trap_names[i].id;
+            return 0;
+        }
+    }
+
+    return ENOENT;
+}
+
+static bool
+__trap_ids_contain(const int *trap_ids, int trap_id)
+{
+    size_t i = 0;
+
+    for (i = 0; trap_ids[i] != -1; i++) {
+        if (trap_ids[i] == trap_id) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static int
+__policers_parse(yaml_document_t *document, yaml_node_t *node,
+                 struct shash *profiles)
+{
+    int status = 0;
+    yaml_node_item_t *item = NULL;
+
+    if (YAML_SEQUENCE_NODE != node->type) {
+        status = EINVAL;
+        ERRNO_LOG_EXIT(status, "policers must be sequence");
+    }
+
+    for (item = node->data.sequence.items.start;
+         item < node->data.sequence.items.top; item++) {
+        status = __policer_parse(document,
+                                 yaml_document_get_node(document, *item),
+                                 profiles);
+        ERRNO_EXIT(status);
+    }
+
+exit:
+    return status;
+}
+
+static int
+__policer_parse(yaml_document_t *document, yaml_node_t *node,
+                struct shash *profiles)
+{
+    int status = 0;
+    const char *key = NULL;
+    const char *name = NULL;
+    yaml_node_t *value = NULL;
+    yaml_node_pair_t *pair = NULL;
+    struct policer_profile *profile = NULL;
+
+    if (!node || YAML_MAPPING_NODE != node->type) {
+        status = EINVAL;
+        ERRNO_LOG_EXIT(status, "Policer must be mapping");
+    }
+
+    profile = xzalloc(sizeof *profile);
+
+    for (pair = node->data.mapping.pairs.start;
+         pair < node->data.mapping.pairs.top; pair++) {
+        key = __scalar(document, yaml_document_get_node(document, pair->key));
+        value = yaml_document_get_node(document, pair->value);
+
+        if (!key) {
+            status = EINVAL;
+        } else if (!strcmp(key, "name")) {
+            name = __scalar(document, value);
+            status = name ? 0 : EINVAL;
+        } else if (!strcmp(key, "rate")) {
+            status = __scalar_u32(document, value,
+                                  &profile->config.rate_max);
+        } else if (!strcmp(key, "burst")) {
+            status = __scalar_u32(document, value,
+                                  &profile->config.burst_max);
+        } else if (!strcmp(key, "rate_min")) {
+            status = __scalar_u32(document, value, &profile->rate_min);
+        } else if (!strcmp(key, "rate_ceil")) {
+            status = __scalar_u32(document, value, &profile->rate_ceil);
+        } else {
+            status = EINVAL;
+        }
+        ERRNO_LOG_EXIT(status, "Invalid policer attribute %s (line: %zu)",
+                       key ? key : "(null)", value->start_mark.line + 1);
+    }
+
+    if (!name || !profile->config.rate_max || !profile->config.burst_max) {
+        status = EINVAL;
+        ERRNO_LOG_EXIT(status, "Policer requires name, rate and burst "
+                       "(line: %zu)", node->start_mark.line + 1);
+    }
+
+    if (!shash_add_once(profiles, name, profile)) {
+        status = EEXIST;
+        ERRNO_LOG_EXIT(status, "Duplicate policer %s", name);
+    }
+    profile = NULL;
+
+exit:
+    free(profile);
+    return status;
+}
+
+static int
+__groups_parse(yaml_document_t *document, yaml_node_t *node,
+               const struct shash *profiles,
+               struct ops_sai_trap_group_config **configs, size_t *n_configs)
+{
+    size_t i = 0;
+    size_t j = 0;
+    size_t n = 0;
+    int status = 0;
+    yaml_node_item_t *item = NULL;
+    struct ops_sai_trap_group_config *config = NULL;
+
+    if (YAML_SEQUENCE_NODE != node->type) {
+        status = EINVAL;
+        ERRNO_LOG_EXIT(status, "trap_groups must be sequence");
+    }
+
+    n = node->data.sequence.items.top - node->data.sequence.items.start;
+    *configs = xcalloc(n ? n : 1, sizeof **configs);
+
+    for (item = node->data.sequence.items.start;
+         item < node->data.sequence.items.top; item++) {
+        config = &(*configs)[*n_configs];
+
+        status = __group_parse(document,
+                               yaml_document_get_node(document, *item),
+                               profiles, config);
+        if (config->name) {
+            (*n_configs)++;
+        }
+        ERRNO_EXIT(status);
+
+        for (i = 0; i < *n_configs - 1; i++) {
+            if (!strcmp((*configs)[i].name, config->name)) {
+                status = EEXIST;
+                ERRNO_LOG_EXIT(status, "Duplicate trap group %s",
+                               config->name);
+            }
+
+            for (j = 0; config->trap_ids[j] != -1; j++) {
+                if (__trap_ids_contain((*configs)[i].trap_ids,
+                                       config->trap_ids[j])) {
+                    status = EEXIST;
+                    ERRNO_LOG_EXIT(status, "Trap %d is in groups %s and %s",
+                                   config->trap_ids[j], (*configs)[i].name,
+                                   config->name);
+                }
+            }
+        }
+    }
+
+exit:
+    return status;
+}
+
+static int
+__group_parse(yaml_document_t *document, yaml_node_t *node,
+              const struct shash *profiles,
+              struct ops_sai_trap_group_config *config)
+{
+    int status = 0;
+    uint32_t core = 0;
+    bool has_core = false;
+    const char *key = NULL;
+    const char *str = NULL;
+    const char *name = NULL;
+    yaml_node_t *value = NULL;
+    yaml_node_pair_t *pair = NULL;
+    const struct policer_profile *profile = NULL;
+
+    if (!node || YAML_MAPPING_NODE != node->type) {
+        status = EINVAL;
+        ERRNO_LOG_EXIT(status, "Trap group must be mapping");
+    }
+
+    config->trap_ids[0] = -1;
+    config->rx_core = -1;
+
+    for (pair = node->data.mapping.pairs.start;
+         pair < node->data.mapping.pairs.top; pair++) {
+        key = __scalar(document, yaml_document_get_node(document, pair->key));
+        value = yaml_document_get_node(document, pair->value);
+
+        if (!key) {
+            status = EINVAL;
+        } else if (!strcmp(key, "name")) {
+            name = __scalar(document, value);
+            status = name && strlen(name) < SAI_TRAP_GROUP_MAX_NAME_LEN
+                     ? 0 : EINVAL;
+        } else if (!strcmp(key, "traps")) {
+            status = __traps_parse(document, value, config->trap_ids);
+        } else if (!strcmp(key, "priority")) {
+            status = __scalar_u32(document, value, &config->priority);
+        } else if (!strcmp(key, "queue")) {
+            status = __scalar_u32(document, value, &config->queue);
+            config->has_queue = !status;
+        } else if (!strcmp(key, "policer")) {
+            str = __scalar(document, value);
+            profile = str ? shash_find_data(profiles, str) : NULL;
+            status = profile ? 0 : EINVAL;
+        } else if (!strcmp(key, "log")) {
+            status = __scalar_bool(document, value, &config->is_log);
+        } else if (!strcmp(key, "l3")) {
+            status = __scalar_bool(document, value, &config->is_l3);
+        } else if (!strcmp(key, "worker")) {
+            status = __scalar_bool(document, value, &config->has_rx_worker);
+        } else if (!strcmp(key, "core")) {
+            status = __scalar_u32(document, value, &core);
+            status = status || core > INT_MAX ? EINVAL : 0;
+            has_core = true;
+        } else if (!strcmp(key, "channel")) {
+            str = __scalar(document, value);
+            if (str && !strcmp(str, "callback")) {
+                config->is_cb = true;
+            } else if (str && !strcmp(str, "netdev")) {
+                config->is_cb = false;
+            } else {
+                status = EINVAL;
+            }
+        } else {
+            status = EINVAL;
+        }
+        ERRNO_LOG_EXIT(status, "Invalid trap group attribute %s (line: %zu)",
+                       key ? key : "(null)", value->start_mark.line + 1);
+    }
+
+    if (!name || !profile) {
+        status = EINVAL;
+        ERRNO_LOG_EXIT(status, "Trap group requires name and policer "
+                       "(line: %zu)", node->start_mark.line + 1);
+    }
+
+    if (has_core) {
+        config->has_rx_worker = true;
+        config->rx_core = core;
+    }
+
+    if (config->has_rx_worker && !config->is_cb) {
+        status = EINVAL;
+        ERRNO_LOG_EXIT(status, "Receive worker requires callback channel "
+                       "(group: %s)", name);
+    }
+
+    config->name = xstrdup(name);
+    config->policer_config = profile->config;
+    config->rate_min = profile->rate_min;
+    config->rate_ceil = profile->rate_ceil;
+
+exit:
+    return status;
+}
+
+static int
+__traps_parse(yaml_document_t *document, yaml_node_t *node, int *trap_ids)
+{
+    size_t n = 0;
+    int status = 0;
+    const char *name = NULL;
+    yaml_node_item_t *item = NULL;
+
+    if (!node || YAML_SEQUENCE_NODE != node->type) {
+        status = EINVAL;
+        ERRNO_LOG_EXIT(status, "traps must be sequence");
+    }
+
+    for (item = node->data.sequence.items.start;
+         item < node->data.sequence.items.top; item++) {
+        if (n == SAI_TRAP_ID_MAX_COUNT - 1) {
+            status = E2BIG;
+            ERRNO_LOG_EXIT(status, "Too many traps in group (max: %d)",
+                           SAI_TRAP_ID_MAX_COUNT - 1);
+        }
+
+        name = __scalar(document, yaml_document_get_node(document, *item));
+        status = name && !__trap_id_get(name, &trap_ids[n]) ? 0 : EINVAL;
+        ERRNO_LOG_EXIT(status, "Unknown trap %s", name ? name : "(null)");
+        n++;
+    }
+
+exit:
+    trap_ids[n] = -1;
+    return status;
+}
@@ -0,0 +1,585 @@
+/*
+ * Copyright Mellanox Technologies, Ltd. 2001-2016.
+ * This software product is licensed under Apache version 2, as detailed in
+ * the COPYING file.
+ */
+
+/*
+ * Offline ECMP/LAG hash distribution simulator. Hashes flows of a pcap file
+ * or a flow list with the same field selection, seed, algorithm and
+ * symmetric mode the plugin configures, and reports load of each member.
+ *
+ * Hash function of the ASIC is not public, CRC32C is used instead. Results
+ * are meant to compare field selections and seeds on a traffic mix, not to
+ * predict member of a particular flow.
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <crc32c.h>
+#include <dp-packet.h>
+#include <flow.h>
+#include <packets.h>
+#include <pcap-file.h>
+#include <random.h>
+#include <util.h>
+#include <ofproto/ofproto.h>
+
+#include <sai-hash.h>
+
+#define SIM_MEMBERS_MAX (1024)
+#define SIM_LINE_MAX    (512)
+#define SIM_KEY_MAX     (128)
+
+enum sim_mode {
+    SIM_MODE_ECMP,
+    SIM_MODE_LAG,
+};
+
+struct sim_field {
+    const char *name;
+    uint32_t ecmp;                  /* OFPROTO_ECMP_HASH_*, 0 if N/A. */
+    uint32_t lag;                   /* OPS_SAI_LAG_HASH_*, 0 if N/A. */
+};
+
+static const struct sim_field sim_fields[] = {
+    { "src-mac", 0, OPS_SAI_LAG_HASH_SRC_MAC },
+    { "dst-mac", 0, OPS_SAI_LAG_HASH_DST_MAC },
+    { "ethertype", 0, OPS_SAI_LAG_HASH_ETHERTYPE },
+    { "vlan", 0, OPS_SAI_LAG_HASH_VLAN_ID },
+    { "src-ip", OFPROTO_ECMP_HASH_SRCIP, OPS_SAI_LAG_HASH_SRC_IP },
+    { "dst-ip", OFPROTO_ECMP_HASH_DSTIP, OPS_SAI_LAG_HASH_DST_IP },
+    { "ip-proto", 0, OPS_SAI_LAG_HASH_IP_PROTO },
+    { "src-port", OFPROTO_ECMP_HASH_SRCPORT, OPS_SAI_LAG_HASH_SRC_PORT },
+    { "dst-port", OFPROTO_ECMP_HASH_DSTPORT, OPS_SAI_LAG_HASH_DST_PORT },
+};
+
+static const char *const sim_algorithms[] = {
+    [OPS_SAI_ECMP_HASH_ALGORITHM_CRC] = "crc",
+    [OPS_SAI_ECMP_HASH_ALGORITHM_XOR] = "xor",
+    [OPS_SAI_ECMP_HASH_ALGORITHM_RANDOM] = "random",
+};
+
+/* Packet fields hash can be computed over. IPv4 addresses are mapped to
+ * IPv6, so both families are hashed the same way. */
+struct sim_flow {
+    struct eth_addr src_mac;
+    struct eth_addr dst_mac;
+    ovs_be16 eth_type;
+    ovs_be16 vlan;
+    struct in6_addr src_ip;
+    struct in6_addr dst_ip;
+    uint8_t proto;
+    ovs_be16 src_port;
+    ovs_be16 dst_port;
+};
+
+struct sim_config {
+    enum sim_mode mode;
+    uint32_t fields;                /* Bitmap of OFPROTO_ECMP_HASH_* or
+                                     * OPS_SAI_LAG_HASH_*, per 'mode'. */
+    uint32_t seed;
+    enum ops_sai_ecmp_hash_algorithm algorithm;
+    bool symmetric;
+    size_t n_members;
+};
+
+struct sim_member {
+    uint64_t flows;
+    uint64_t packets;
+    uint64_t bytes;
+};
+
+static void __usage(void);
+static uint32_t __fields_parse(enum sim_mode, char *);
+static bool __field_enabled(const struct sim_config *, const char *);
+static void __key_put(uint8_t *, size_t *, const void *, size_t);
+static void __key_put_pair(const struct sim_config *, uint8_t *, size_t *,
+                           const char *, const void *, const char *,
+                           const void *, size_t);
+static uint32_t __flow_hash(const struct sim_config *,
+                            const struct sim_flow *);
+static void __flow_account(const struct sim_config *,
+                           const struct sim_flow *, uint64_t, uint64_t,
+                           struct sim_member *);
+static bool __ip_parse(const char *, struct in6_addr *);
+static void __pcap_run(const struct sim_config *, const char *,
+                       struct sim_member *);
+static void __flows_run(const struct sim_config *, const char *,
+                        struct sim_member *);
+static void __report(const struct sim_config *, const struct sim_member *);
+
+int
+main(int argc, char *argv[])
+{
+    enum {
+        OPT_PCAP = UCHAR_MAX + 1,
+        OPT_FLOWS,
+        OPT_MODE,
+        OPT_FIELDS,
+        OPT_MEMBERS,
+        OPT_SEED,
+        OPT_ALGORITHM,
+        OPT_SYMMETRIC,
+        OPT_HELP,
+    };
+    static const struct option long_options[] = {
+        { "pcap", required_argument, NULL, OPT_PCAP },
+        { "flows", required_argument, NULL, OPT_FLOWS },
+        { "mode", required_argument, NULL, OPT_MODE },
+        { "fields", required_argument, NULL, OPT_FIELDS },
+        { "members", required_argument, NULL, OPT_MEMBERS },
+        { "seed", required_argument, NULL, OPT_SEED },
+        { "algorithm", required_argument, NULL, OPT_ALGORITHM },
+        { "symmetric", no_argument, NULL, OPT_SYMMETRIC },
+        { "help", no_argument, NULL, OPT_HELP },
+        { NULL, 0, NULL, 0 },
+    };
+    int opt = 0;
+    size_t i = 0;
+    char *end = NULL;
+    char *fields = NULL;
+    const char *pcap = NULL;
+    const char *flows = NULL;
+    unsigned long value = 0;
+    struct sim_member *members = NULL;
+    struct sim_config config = {
+        .mode = SIM_MODE_ECMP,
+        .algorithm = OPS_SAI_ECMP_HASH_ALGORITHM_CRC,
+        .n_members = 2,
+    };
+
+    set_program_name(argv[0]);
+
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (opt) {
+        case OPT_PCAP:
+            pcap = optarg;
+            break;
+        case OPT_FLOWS:
+            flows = optarg;
+            break;
+        case OPT_MODE:
+            if (!strcmp(optarg, "ecmp")) {
+                config.mode = SIM_MODE_ECMP;
+            } else if (!strcmp(optarg, "lag")) {
+                config.mode = SIM_MODE_LAG;
+            } else {
+                ovs_fatal(0, "unknown mode %s", optarg);
+            }
+            break;
+        case OPT_FIELDS:
+            fields = optarg;
+            break;
+        case OPT_MEMBERS:
+            errno = 0;
+            value = strtoul(optarg, &end, 0);
+            if (errno || *end || !value || value > SIM_MEMBERS_MAX) {
+                ovs_fatal(0, "invalid number of members %s", optarg);
+            }
+            config.n_members = value;
+            break;
+        case OPT_SEED:
+            errno = 0;
+            value = strtoul(optarg, &end, 0);
+            if (errno || *end || value > UINT32_MAX) {
+                ovs_fatal(0, "invalid seed %s", optarg);
+            }
+            config.seed = value;
+            break;
+        case OPT_ALGORITHM:
+            for (i = 0; i < ARRAY_SIZE(sim_algorithms); i++) {
+                if (!strcmp(optarg, sim_algorithms[i])) {
+                    break;
+                }
+            }
+            if (i == ARRAY_SIZE(sim_algorithms)) {
+                ovs_fatal(0, "unknown algorithm %s", optarg);
+            }
+            config.algorithm = i;
+            break;
+        case OPT_SYMMETRIC:
+            config.symmetric = true;
+            break;
+        case OPT_HELP:
+            __usage();
+            exit(EXIT_SUCCESS);
+        default:
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (!pcap == !flows) {
+        ovs_fatal(0, "exactly one of --pcap and --flows is required "
+                  "(use --help for help)");
+    }
+
+    /* Defaults are the ones plugin configures on init. */
+    if (fields) {
+        config.fields = __fields_parse(config.mode, fields);
+    } else if (SIM_MODE_ECMP == config.mode) {
+        config.fields = OFPROTO_ECMP_HASH_SRCIP | OFPROTO_ECMP_HASH_DSTIP |
+                        OFPROTO_ECMP_HASH_SRCPORT | OFPROTO_ECMP_HASH_DSTPORT;
+    } else {
+        /* Inner headers are not parsed. */
+        config.fields = OPS_SAI_LAG_HASH_DEFAULT & ~OPS_SAI_LAG_HASH_INNER;
+    }
+
+    members = xcalloc(config.n_members, sizeof *members);
+
+    if (pcap) {
+        __pcap_run(&config, pcap, members);
+    } else {
+        __flows_run(&config, flows, members);
+    }
+
+    __report(&config, members);
+    free(members);
+
+    return 0;
+}
+
+static void
+__usage(void)
+{
+    size_t i = 0;
+
+    printf("%s: ECMP/LAG hash distribution simulator\n"
+           "usage: %s [OPTIONS] --pcap FILE | --flows FILE\n"
+           "\n"
+           "  --pcap FILE          hash packets of pcap file\n"
+           "  --flows FILE         hash flows of text file, one per line:\n"
+           "                       SRC_IP DST_IP PROTO SRC_PORT DST_PORT "
+           "[PACKETS [BYTES]]\n"
+           "  --mode ecmp|lag      hash to simulate (default: ecmp)\n"
+           "  --fields LIST        comma separated hash fields "
+           "(default: plugin defaults)\n"
+           "  --members N          number of next hops or LAG members "
+           "(default: 2)\n"
+           "  --seed N             hash seed (default: 0)\n"
+           "  --algorithm ALG      crc, xor or random (default: crc)\n"
+           "  --symmetric          hash both directions of flow the same\n"
+           "\n"
+           "Hash fields:\n",
+           program_name, program_name);
+
+    for (i = 0; i < ARRAY_SIZE(sim_fields); i++) {
+        printf("  %-12s%s%s\n", sim_fields[i].name,
+               sim_fields[i].ecmp ? " ecmp" : "",
+               sim_fields[i].lag ? " lag" : "");
+    }
+}
+
+static uint32_t
+__fields_parse(enum sim_mode mode, char *list)
+{
+    size_t i = 0;
+    uint32_t bit = 0;
+    uint32_t fields = 0;
+    char *save_ptr = NULL;
+    char *name = NULL;
+
+    for (name = strtok_r(list, ",", &save_ptr); name;
+         name = strtok_r(NULL, ",", &save_ptr)) {
+        for (i = 0; i < ARRAY_SIZE(sim_fields); i++) {
+            if (!strcmp(name, sim_fields[i].name)) {
+                break;
+            }
+        }
+
+        bit = i < ARRAY_SIZE(sim_fields) ?
+              (SIM_MODE_ECMP == mode ? sim_fields[i].ecmp
+                                     : sim_fields[i].lag) : 0;
+        if (!bit) {
+            ovs_fatal(0, "unknown %s hash field %s",
+                      SIM_MODE_ECMP == mode ? "ECMP" : "LAG", name);
+        }
+        fields |= bit;
+    }
+
+    if (!fields) {
+        ovs_fatal(0, "hash fields list could not be empty");
+    }
+
+    return fields;
+}
+
+static bool
+__field_enabled(const struct sim_config *config, const char *name)
+{
+    size_t i = 0;
+
+    for (i = 0; i < ARRAY_SIZE(sim_fields); i++) {
+        if (!strcmp(name, sim_fields[i].name)) {
+            return config->fields & (SIM_MODE_ECMP == config->mode ?
+                                     sim_fields[i].ecmp : sim_fields[i].lag);
+        }
+    }
+
+    return false;
+}
+
+static void
+__key_put(uint8_t *key, size_t *len, const void *data, size_t size)
+{
+    ovs_assert(*len + size <= SIM_KEY_MAX);
+    memcpy(key + *len, data, size);
+    *len += size;
+}
+
+/*
+ * Append source and destination fields to hash key. In symmetric mode a pair
+ * of enabled fields is appended in value order, so reversed flow gets the
+ * same key.
+ */
+static void
+__key_put_pair(const struct sim_config *config, uint8_t *key, size_t *len,
+               const char *src_name, const void *src,
+               const char *dst_name, const void *dst, size_t size)
+{
+    bool src_enabled = __field_enabled(config, src_name);
+    bool dst_enabled = __field_enabled(config, dst_name);
+
+    if (config->symmetric && src_enabled && dst_enabled &&
+        memcmp(src, dst, size) > 0) {
+        __key_put(key, len, dst, size);
+        __key_put(key, len, src, size);
+        return;
+    }
+
+    if (src_enabled) {
+        __key_put(key, len, src, size);
+    }
+    if (dst_enabled) {
+        __key_put(key, len, dst, size);
+    }
+}
+
+static uint32_t
+__flow_hash(const struct sim_config *config, const struct sim_flow *flow)
+{
+    size_t i = 0;
+    size_t len = 0;
+    uint32_t word = 0;
+    uint32_t hash = 0;
+    uint8_t key[SIM_KEY_MAX];
+
+    __key_put(key, &len, &config->seed, sizeof config->seed);
+    __key_put_pair(config, key, &len, "src-mac", &flow->src_mac,
+                   "dst-mac", &flow->dst_mac, sizeof flow->src_mac);
+    if (__field_enabled(config, "ethertype")) {
+        __key_put(key, &len, &flow->eth_type, sizeof flow->eth_type);
+    }
+    if (__field_enabled(config, "vlan")) {
+        __key_put(key, &len, &flow->vlan, sizeof flow->vlan);
+    }
+    __key_put_pair(config, key, &len, "src-ip", &flow->src_ip,
+                   "dst-ip", &flow->dst_ip, sizeof flow->src_ip);
+    if (__field_enabled(config, "ip-proto")) {
+        __key_put(key, &len, &flow->proto, sizeof flow->proto);
+    }
+    __key_put_pair(config, key, &len, "src-port", &flow->src_port,
+                   "dst-port", &flow->dst_port, sizeof flow->src_port);
+
+    switch (config->algorithm) {
+    case OPS_SAI_ECMP_HASH_ALGORITHM_CRC:
+        hash = (OVS_FORCE uint32_t) crc32c(key, len);
+        break;
+    case OPS_SAI_ECMP_HASH_ALGORITHM_XOR:
+        for (i = 0; i < len; i += sizeof word) {
+            word = 0;
+            memcpy(&word, key + i, MIN(sizeof word, len - i));
+            hash ^= word;
+        }
+        /* Fold, so that member selection depends on every byte. */
+        hash ^= hash >> 16;
+        hash ^= hash >> 8;
+        break;
+    case OPS_SAI_ECMP_HASH_ALGORITHM_RANDOM:
+    default:
+        hash = random_uint32();
+        break;
+    }
+
+    return hash;
+}
+
+static void
+__flow_account(const struct sim_config *config, const struct sim_flow *flow,
+               uint64_t packets, uint64_t bytes, struct sim_member *members)
+{
+    struct sim_member *member = NULL;
+
+    member = &members[__flow_hash(config, flow) % config->n_members];
+    member->flows++;
+    member->packets += packets;
+    member->bytes += bytes;
+}
+
+/*
+ * Hash every packet of pcap file. Each packet is accounted as a flow, so
+ * flow counters show packets of the capture.
+ */
+static void
+__pcap_run(const struct sim_config *config, const char *file_name,
+           struct sim_member *members)
+{
+    int err = 0;
+    FILE *pcap = NULL;
+    struct flow flow;
+    struct sim_flow sim_flow;
+    struct dp_packet *packet = NULL;
+
+    pcap = ovs_pcap_open(file_name, "rb");
+    if (!pcap) {
+        ovs_fatal(errno, "failed to open %s", file_name);
+    }
+
+    err = ovs_pcap_read_header(pcap);
+    if (err) {
+        ovs_fatal(err, "failed to read header of %s", file_name);
+    }
+
+    while (!(err = ovs_pcap_read(pcap, &packet, NULL))) {
+        memset(&flow, 0, sizeof flow);
+        memset(&sim_flow, 0, sizeof sim_flow);
+        flow_extract(packet, &flow);
+
+        sim_flow.src_mac = flow.dl_src;
+        sim_flow.dst_mac = flow.dl_dst;
+        sim_flow.eth_type = flow.dl_type;
+        sim_flow.vlan = flow.vlan_tci & htons(VLAN_VID_MASK);
+        if (flow.dl_type == htons(ETH_TYPE_IP)) {
+            in6_addr_set_mapped_ipv4(&sim_flow.src_ip, flow.nw_src);
+            in6_addr_set_mapped_ipv4(&sim_flow.dst_ip, flow.nw_dst);
+        } else if (flow.dl_type == htons(ETH_TYPE_IPV6)) {
+            sim_flow.src_ip = flow.ipv6_src;
+            sim_flow.dst_ip = flow.ipv6_dst;
+        }
+        sim_flow.proto = flow.nw_proto;
+        if (flow.nw_proto == IPPROTO_TCP || flow.nw_proto == IPPROTO_UDP ||
+            flow.nw_proto == IPPROTO_SCTP) {
+            sim_flow.src_port = flow.tp_src;
+            sim_flow.dst_port = flow.tp_dst;
+        }
+
+        __flow_account(config, &sim_flow, 1, dp_packet_size(packet),
+                       members);
+        dp_packet_delete(packet);
+    }
+
+    if (err != EOF) {
+        ovs_fatal(err, "failed to read %s", file_name);
+    }
+
+    fclose(pcap);
+}
+
+static bool
+__ip_parse(const char *s, struct in6_addr *ip)
+{
+    ovs_be32 ip4 = 0;
+
+    if (ip_parse(s, &ip4)) {
+        in6_addr_set_mapped_ipv4(ip, ip4);
+        return true;
+    }
+
+    return ipv6_parse(s, ip);
+}
+
+/*
+ * Hash flows of text file. Empty lines and lines starting with '#' are
+ * skipped. Flow without counters is accounted as single packet of one byte.
+ */
+static void
+__flows_run(const struct sim_config *config, const char *file_name,
+            struct sim_member *members)
+{
+    int n = 0;
+    unsigned int line_no = 0;
+    unsigned int proto = 0;
+    unsigned int src_port = 0;
+    unsigned int dst_port = 0;
+    unsigned long long packets = 0;
+    unsigned long long bytes = 0;
+    char src_ip[INET6_ADDRSTRLEN];
+    char dst_ip[INET6_ADDRSTRLEN];
+    char line[SIM_LINE_MAX];
+    struct sim_flow flow;
+    FILE *file = NULL;
+
+    file = fopen(file_name, "r");
+    if (!file) {
+        ovs_fatal(errno, "failed to open %s", file_name);
+    }
+
+    while (fgets(line, sizeof line, file)) {
+        line_no++;
+        if (line[strspn(line, " \t\n")] == '\0' ||
+            line[strspn(line, " \t")] == '#') {
+            continue;
+        }
+
+        packets = 1;
+        bytes = 1;
+        n = sscanf(line, "%45s %45s %u %u %u %llu %llu", src_ip, dst_ip,
+                   &proto, &src_port, &dst_port, &packets, &bytes);
+        if (n < 5 || proto > UINT8_MAX || src_port > UINT16_MAX ||
+            dst_port > UINT16_MAX) {
+            ovs_fatal(0, "%s:%u: invalid flow", file_name, line_no);
+        }
+        if (6 == n) {
+            bytes = packets;
+        }
+
+        memset(&flow, 0, sizeof flow);
+        if (!__ip_parse(src_ip, &flow.src_ip) ||
+            !__ip_parse(dst_ip, &flow.dst_ip)) {
+            ovs_fatal(0, "%s:%u: invalid IP address", file_name, line_no);
+        }
+        flow.eth_type = htons(IN6_IS_ADDR_V4MAPPED(&flow.src_ip) ?
+                              ETH_TYPE_IP : ETH_TYPE_IPV6);
+        flow.proto = proto;
+        flow.src_port = htons(src_port);
+        flow.dst_port = htons(dst_port);
+
+        __flow_account(config, &flow, packets, bytes, members);
+    }
+
+    fclose(file);
+}
+
+static void
+__report(const struct sim_config *config, const struct sim_member *members)
+{
+    size_t i = 0;
+    uint64_t total = 0;
+    uint64_t max = 0;
+    double mean = 0;
+
+    for (i = 0; i < config->n_members; i++) {
+        total += members[i].bytes;
+        max = MAX(max, members[i].bytes);
+    }
+    mean = (double) total / config->n_members;
+
+    printf("%s hash, %s, seed %u%s, %"PRIuSIZE" members\n",
+           SIM_MODE_ECMP == config->mode ? "ECMP" : "LAG",
+           sim_algorithms[config->algorithm], config->seed,
+           config->symmetric ? ", symmetric" : "", config->n_members);
+    printf("%-8s %12s %14s %18s %8s\n", "Member", "Flows", "Packets",
+           "Bytes", "Share");
+
+    for (i = 0; i < config->n_members; i++) {
+        printf("%-8"PRIuSIZE" %12"PRIu64" %14"PRIu64" %18"PRIu64" %7.2f%%\n",
+               i, members[i].flows, members[i].packets, members[i].bytes,
+               total ? 100.0 * members[i].bytes / total : 0.0);
+    }
+
+    printf("Max/mean load: %.3f\n", mean > 0 ? max / mean : 0.0);
+}